@@ -0,0 +1,247 @@
+//
+//  PapasWriter.cpp
+//  papas
+//
+
+#include "PapasWriter.h"
+
+#include "datamodel/CaloClusterCollection.h"
+#include "datamodel/EventInfoCollection.h"
+#include "datamodel/MCParticleCollection.h"
+#include "datamodel/ParticleCollection.h"
+#include "datamodel/ParticleMCParticleAssociationCollection.h"
+
+// podio specific includes
+#include "podio/EventStore.h"
+#include "podio/ROOTWriter.h"
+
+#include "papas/datatypes/HistoryHelper.h"
+#include "papas/utility/Timeline.h"
+
+// ROOT
+#include "TROOT.h"
+
+// STL
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+template <typename P, typename R>
+void fillParticle(P& particle, const R& record) {
+  auto& core = particle.core();
+  core.pdgId = record.pdgId;
+  core.charge = record.charge;
+  core.status = record.status;
+  core.p4.px = record.px;
+  core.p4.py = record.py;
+  core.p4.pz = record.pz;
+  core.p4.mass = record.mass;
+}
+
+template <typename R>
+void fillClusters(fcc::CaloClusterCollection& clusters, const std::vector<R>& records) {
+  for (const auto& record : records) {
+    auto cluster = clusters.create();
+    cluster.core().energy = record.energy;
+    auto& position = cluster.core().position;
+    position.x = record.x;
+    position.y = record.y;
+    position.z = record.z;
+  }
+}
+
+}  // end anonymous namespace
+
+PapasWriter::PapasWriter(const std::string& fname, bool truthLinks, unsigned int maxPending)
+    : m_fname(fname), m_truthLinks(truthLinks), m_maxPending(std::max(maxPending, 1u)), m_closing(false),
+      m_written(0) {
+  ROOT::EnableThreadSafety();
+  m_thread = std::thread(&PapasWriter::run, this);
+}
+
+PapasWriter::~PapasWriter() {
+  if (!m_thread.joinable()) return;
+  try {
+    close();
+  } catch (const char* err) {
+    std::cerr << "PapasWriter " << m_fname << ": " << err << std::endl;
+  } catch (const std::string& err) {
+    std::cerr << "PapasWriter " << m_fname << ": " << err << std::endl;
+  } catch (const std::exception& err) {
+    std::cerr << "PapasWriter " << m_fname << ": " << err.what() << std::endl;
+  }
+}
+
+void PapasWriter::write(unsigned int eventNo, const papas::Event& event) {
+  using papas::IdCoder;
+  EventRecord record;
+  record.eventNo = eventNo;
+  // copy what is written, so that the event can be cleared as soon as this returns
+  auto addParticles = [&event](char subtype, std::vector<ParticleRecord>& records,
+                               std::unordered_map<papas::Identifier, uint32_t>* positions) {
+    if (!event.hasCollection(IdCoder::kParticle, subtype)) return;
+    const auto& particles = event.particles(subtype);
+    records.reserve(particles.size());
+    for (const auto& p : particles) {
+      const auto& tlv = p.second.p4();
+      if (positions != nullptr) positions->emplace(p.first, records.size());
+      records.push_back(ParticleRecord{p.second.pdgId(), (float)p.second.charge(), tlv.Px(), tlv.Py(), tlv.Pz(),
+                                       tlv.M(), (int)p.second.status()});
+    }
+  };
+  auto addClusters = [&event](const char* typeAndSubtype, std::vector<ClusterRecord>& records) {
+    auto type = IdCoder::type(typeAndSubtype[0]);
+    if (!event.hasCollection(type, typeAndSubtype[1])) return;
+    const auto& clusters = event.clusters(type, typeAndSubtype[1]);
+    records.reserve(clusters.size());
+    for (const auto& c : clusters) {
+      const auto& position = c.second.position();
+      records.push_back(ClusterRecord{c.second.energy(), position.X(), position.Y(), position.Z()});
+    }
+  };
+  std::unordered_map<papas::Identifier, uint32_t> reconstructedPositions;
+  addParticles('r', record.reconstructed, &reconstructedPositions);
+  addClusters("em", record.ecals);
+  addClusters("hm", record.hcals);
+  if (event.hasCollection(IdCoder::kTrack, 's')) {
+    const auto& tracks = event.tracks('s');
+    record.tracks.reserve(tracks.size());
+    for (const auto& t : tracks) {
+      const auto& p3 = t.second.p3();
+      record.tracks.push_back(ParticleRecord{0, (float)t.second.charge(), p3.X(), p3.Y(), p3.Z(), 0., 1});
+    }
+  }
+  if (m_truthLinks) {
+    std::unordered_map<papas::Identifier, uint32_t> simulatedPositions;
+    addParticles('s', record.simulated, &simulatedPositions);
+    // the simulated particles that a reconstructed particle came from are the ancestors of the tracks and
+    // clusters it was made from. Its block is skipped, as it also holds the elements of other particles.
+    papas::HistoryHelper historyHelper(event);
+    std::vector<uint32_t> simulatedParents;
+    for (const auto& r : reconstructedPositions) {
+      auto node = event.history().find(r.first);
+      if (node == event.history().end()) continue;  // no history was recorded
+      simulatedParents.clear();
+      for (const auto* element : node->second.parents()) {
+        if (IdCoder::isBlock(element->value())) continue;
+        historyHelper.visitLinkedIds(element->value(), DAG::enumVisitType::PARENTS, [&](papas::Identifier id) {
+          auto simulated = simulatedPositions.find(id);
+          if (simulated != simulatedPositions.end()) simulatedParents.push_back(simulated->second);
+          return true;
+        });
+      }
+      // several elements may come from the same simulated particle
+      std::sort(simulatedParents.begin(), simulatedParents.end());
+      simulatedParents.erase(std::unique(simulatedParents.begin(), simulatedParents.end()), simulatedParents.end());
+      for (auto simulated : simulatedParents)
+        record.links.emplace_back(r.second, simulated);
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_changed.wait(lock, [this] { return m_pending.size() < m_maxPending || m_error || m_closing; });
+  rethrow();
+  if (m_closing) throw "PapasWriter: write after close";
+  m_pending.push_back(std::move(record));
+  m_changed.notify_all();
+}
+
+void PapasWriter::close() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closing = true;
+  }
+  m_changed.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  rethrow();
+}
+
+unsigned int PapasWriter::written() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_written;
+}
+
+void PapasWriter::rethrow() {
+  if (!m_error) return;
+  auto error = m_error;
+  m_error = nullptr;  // thrown once
+  std::rethrow_exception(error);
+}
+
+void PapasWriter::run() {
+  papas::Timeline::setThreadName("writer");
+  try {
+    // the store and the writer are only used by this thread
+    podio::EventStore store;
+    podio::ROOTWriter writer(m_fname, &store);
+    auto& evinfos = store.create<fcc::EventInfoCollection>("evtinfo");
+    auto& reconstructed = store.create<fcc::ParticleCollection>("RecParticle");
+    auto& ecals = store.create<fcc::CaloClusterCollection>("MergedEcalCluster");
+    auto& hcals = store.create<fcc::CaloClusterCollection>("MergedHcalCluster");
+    auto& tracks = store.create<fcc::ParticleCollection>("SmearedTrack");
+    writer.registerForWrite("evtinfo");
+    writer.registerForWrite("RecParticle");
+    writer.registerForWrite("MergedEcalCluster");
+    writer.registerForWrite("MergedHcalCluster");
+    writer.registerForWrite("SmearedTrack");
+    fcc::MCParticleCollection* simulated = nullptr;
+    fcc::ParticleMCParticleAssociationCollection* links = nullptr;
+    if (m_truthLinks) {
+      simulated = &store.create<fcc::MCParticleCollection>("SimParticle");
+      links = &store.create<fcc::ParticleMCParticleAssociationCollection>("RecSimAssociation");
+      writer.registerForWrite("SimParticle");
+      writer.registerForWrite("RecSimAssociation");
+    }
+
+    while (true) {
+      EventRecord record;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return !m_pending.empty() || m_closing; });
+        if (m_pending.empty()) break;  // closing and nothing left to write
+        record = std::move(m_pending.front());
+        m_pending.pop_front();
+      }
+      m_changed.notify_all();  // there is room for another event
+      papas::Timeline::Span writeSpan("write event", "io", record.eventNo);
+
+      auto evinfo = evinfos.create();
+      evinfo.number(record.eventNo);
+      for (const auto& r : record.reconstructed) {
+        auto particle = reconstructed.create();
+        fillParticle(particle, r);
+      }
+      fillClusters(ecals, record.ecals);
+      fillClusters(hcals, record.hcals);
+      for (const auto& t : record.tracks) {
+        auto track = tracks.create();
+        fillParticle(track, t);
+      }
+      if (m_truthLinks) {
+        for (const auto& s : record.simulated) {
+          auto particle = simulated->create();
+          fillParticle(particle, s);
+        }
+        for (const auto& link : record.links) {
+          auto association = links->create();
+          association.rec(reconstructed[link.first]);
+          association.sim((*simulated)[link.second]);
+        }
+      }
+      writer.writeEvent();
+      store.clearCollections();
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_written;
+    }
+    writer.finish();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_error = std::current_exception();
+    m_pending.clear();
+    m_closing = true;  // nothing more can be written, later writes throw the error
+  }
+  m_changed.notify_all();
+}
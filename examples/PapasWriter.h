@@ -0,0 +1,110 @@
+//
+//  PapasWriter.h
+//  papas
+//
+
+#ifndef PapasWriter_h
+#define PapasWriter_h
+
+#include "papas/datatypes/Event.h"
+
+// STL
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/** @brief Writes the output of a run to one podio ROOT file that stays open across events.
+
+ The file is opened once and has these collections for every event:
+   - "evtinfo"            event number (fcc::EventInfo)
+   - "RecParticle"        reconstructed particles (fcc::Particle)
+   - "MergedEcalCluster"  merged ecal clusters (fcc::CaloCluster)
+   - "MergedHcalCluster"  merged hcal clusters (fcc::CaloCluster)
+   - "SmearedTrack"       smeared tracks, stored as a charged fcc::Particle with the track momentum and no mass
+ and, if truth links are asked for,
+   - "SimParticle"        simulated particles (fcc::MCParticle)
+   - "RecSimAssociation"  links from each reconstructed particle to the simulated particles it came from, found
+                          through the tracks and clusters it was made from (not through its block)
+
+ write() copies what is needed from the Event into a plain buffer and returns. The podio collections are filled and
+ written on a background thread, so the processing loop only waits when maxPending events are already waiting to
+ be written. An error on the writer thread is thrown by the next call to write() or close().
+
+ ROOT thread safety is switched on, as the writer thread does ROOT I/O while the main thread may be reading.
+ When events are run in several worker processes (see ProcessPool) each worker should have its own PapasWriter
+ (made in workerStart, closed in workerEnd) and file. The files can then be merged with hadd.
+
+ Usage example:
+ @code
+   PapasWriter writer("papas.root", true);
+   for (...) {
+     ... simulate and reconstruct an event ...
+     writer.write(eventNo, papasManager.event());
+   }
+   writer.close();
+ @endcode
+ */
+class PapasWriter {
+public:
+  /** Starts the writer thread, which opens the file
+   * @param[in] fname name of the ROOT file
+   * @param[in] truthLinks whether to write the simulated particles and the links to them (needs history)
+   * @param[in] maxPending number of events that may be waiting to be written before write() waits
+   */
+  PapasWriter(const std::string& fname, bool truthLinks = false, unsigned int maxPending = 16);
+  ~PapasWriter();  ///< closes the file if close() was not called, errors are then only logged
+  PapasWriter(const PapasWriter&) = delete;
+  PapasWriter& operator=(const PapasWriter&) = delete;
+
+  /** Queues an event for writing. Collections that are not in the event are written empty.
+   * @param[in] eventNo event number
+   * @param[in] event event holding reconstructed particles 'r', merged clusters "em" and "hm" and smeared tracks
+   * 's' (and simulated particles 's' with their history for truth links)
+   */
+  void write(unsigned int eventNo, const papas::Event& event);
+  /// Writes the events still waiting, closes the file and stops the writer thread. Throws if writing failed.
+  void close();
+  unsigned int written() const;  ///< number of events written to the file so far
+
+private:
+  /// a particle (or track) as it is written
+  struct ParticleRecord {
+    int pdgId;
+    float charge;
+    double px, py, pz, mass;
+    int status;
+  };
+  /// a cluster as it is written
+  struct ClusterRecord {
+    double energy, x, y, z;
+  };
+  /// everything written for one event, copied from the Event so that the Event can be cleared
+  struct EventRecord {
+    unsigned int eventNo;
+    std::vector<ParticleRecord> reconstructed;
+    std::vector<ClusterRecord> ecals;
+    std::vector<ClusterRecord> hcals;
+    std::vector<ParticleRecord> tracks;
+    std::vector<ParticleRecord> simulated;
+    std::vector<std::pair<uint32_t, uint32_t>> links;  ///< (reconstructed, simulated) positions
+  };
+  void run();                               ///< body of the writer thread
+  void rethrow();                           ///< throws the error of the writer thread, if any (lock held)
+  const std::string m_fname;                ///< name of the ROOT file
+  const bool m_truthLinks;                  ///< whether simulated particles and links are written
+  const unsigned int m_maxPending;          ///< events that may be waiting before write() waits
+  mutable std::mutex m_mutex;               ///< guards everything below
+  std::condition_variable m_changed;        ///< signalled when an event is queued or taken, or on close
+  std::deque<EventRecord> m_pending;        ///< events waiting to be written
+  bool m_closing;                           ///< set by close(), the thread writes what is left and ends
+  unsigned int m_written;                   ///< events written so far
+  std::exception_ptr m_error;               ///< error of the writer thread
+  std::thread m_thread;                     ///< writer thread, owns the podio store and writer
+};
+
+#endif /* PapasWriter_h */
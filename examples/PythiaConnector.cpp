@@ -11,24 +11,33 @@
 #include "papas/reconstruction/PapasManager.h"
 #include "papas/reconstruction/PapasManager.h"
 
-//#include "datamodel/CaloClusterCollection.h"
+#include "datamodel/CaloClusterCollection.h"
 #include "datamodel/EventInfoCollection.h"
 #include "datamodel/ParticleCollection.h"
+#include "datamodel/TrackCollection.h"
 #include "utilities/ParticleUtils.h"
 
 #include "papas/datatypes/Helix.h"
 #include "papas/datatypes/Particle.h"
 #include "papas/datatypes/Path.h"
+#include "papas/detectors/Calorimeter.h"
 #include "papas/detectors/Detector.h"
 #include "papas/detectors/Field.h"
 #include "papas/display/PFApp.h"
 #include "papas/simulation/Simulator.h"
+#include "papas/utility/AllocTracker.h"
 #include "papas/utility/Log.h"
 #include "papas/utility/PDebug.h"
+#include "papas/utility/Timeline.h"
 
+#include <algorithm>
+#include <cmath>
 #include <exception>
+#include <numeric>
 #include <string>
 #include <sys/stat.h>
+#include <tuple>
+#include <vector>
 
 // ROOT
 #include "TBranch.h"
@@ -49,68 +58,73 @@ PythiaConnector::PythiaConnector(const char* fname) : m_store(podio::EventStore(
 }
 
 void PythiaConnector::makePapasParticlesFromGeneratedParticles(const fcc::MCParticleCollection* ptcs,
-                                                               papas::Particles& particles,
-                                                               const papas::Detector& detector) {
-  // turns pythia particles into Papas particles and lodges them in the history
+                                                               papas::Particles& particles) {
+  // turns the stable, visible pythia particles into Papas particles in order of decreasing energy.
+  // The 4-momentum (and so the energy) of each is worked out once, their positions are sorted by energy and the
+  // particles are then made in place in the collection. Their paths are made by addParticles.
+  std::vector<TLorentzVector> tlvs;  // 4-momenta of the selected particles
+  std::vector<double> energies;      // energies of the selected particles
+  std::vector<unsigned int> indices;  // positions in ptcs of the selected particles
+  tlvs.reserve(ptcs->size());
+  energies.reserve(ptcs->size());
+  indices.reserve(ptcs->size());
   TLorentzVector tlv;
-  int countp = 0;
-
-  // Sort particles in order of decreasing energy
-  std::list<fcc::ConstMCParticle> sortPtcs;
-  for (const auto& p : *ptcs) {
-    sortPtcs.push_back(p);
+  unsigned int index = 0;
+  for (const auto& ptc : *ptcs) {
+    const auto& core = ptc.core();
+    int pdgid = core.pdgId;
+    if (core.status == 1 && abs(pdgid) != 12 && abs(pdgid) != 14 && abs(pdgid) != 16) {  // only stable ones
+      tlv.SetXYZM(core.p4.px, core.p4.py, core.p4.pz, core.p4.mass);
+      if (tlv.Pt() > 1e-5) {
+        tlvs.push_back(tlv);
+        energies.push_back(tlv.E());
+        indices.push_back(index);
+      }
+    }
+    ++index;
   }
-  sortPtcs.sort([](const fcc::ConstMCParticle& a, const fcc::ConstMCParticle& b) {
-    auto p4 = a.p4();
-    TLorentzVector tlv;
-    tlv.SetXYZM(p4.px, p4.py, p4.pz, p4.mass);
-    TLorentzVector tlv2;
-    p4 = b.p4();
-    tlv2.SetXYZM(p4.px, p4.py, p4.pz, p4.mass);
-    return tlv.E() > tlv2.E();
-  });
-
-  for (const auto& ptc : sortPtcs) {
-    countp += 1;
-    auto p4 = ptc.core().p4;
-    tlv.SetXYZM(p4.px, p4.py, p4.pz, p4.mass);
-    int pdgid = ptc.core().pdgId;
+  // stable so that particles of equal energy stay in collection order
+  std::vector<unsigned int> order(tlvs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&energies](unsigned int a, unsigned int b) { return energies[a] > energies[b]; });
+
+  particles.reserve(particles.size() + order.size());
+  for (auto i : order) {
+    const auto ptc = (*ptcs)[indices[i]];
     TVector3 startVertex = TVector3(0, 0, 0);
     if (ptc.startVertex().isAvailable()) {
       startVertex = TVector3(ptc.startVertex().x() * 1e-3, ptc.startVertex().y() * 1e-3, ptc.startVertex().z() * 1e-3);
     }
-    if (ptc.core().status == 1) {  // only stable ones
-
-      if (tlv.Pt() > 1e-5 && (abs(pdgid) != 12) && (abs(pdgid) != 14) && (abs(pdgid) != 16)) {
-        papas::Particle particle(pdgid, (double)ptc.core().charge, tlv, particles.size(), 's', startVertex,
-                                 ptc.core().status);
-        // set the particles papas path (allows particles to be const when passed to simulator)
-        std::shared_ptr<papas::Path> ppath;
-        if (fabs(particle.charge()) < 0.5) {
-          ppath = std::make_shared<papas::Path>(particle.p4(), particle.startVertex(), particle.charge());
-        } else {
-          ppath = std::make_shared<papas::Helix>(particle.p4(), particle.startVertex(), particle.charge(),
-                                                 detector.field()->getMagnitude());
-        }
-        particle.setPath(ppath);
-        particles.emplace(particle.id(), particle);
-        papas::PDebug::write("Made {}", particle);
-      }
-    }
+    uint32_t particleIndex = particles.size();
+    auto id = papas::IdCoder::makeId(particleIndex, papas::IdCoder::kParticle, 's', energies[i]);
+    auto inserted = particles.emplace(std::piecewise_construct, std::forward_as_tuple(id),
+                                      std::forward_as_tuple(ptc.core().pdgId, (double)ptc.core().charge, tlvs[i],
+                                                            particleIndex, 's', startVertex, ptc.core().status));
+    papas::PDebug::write("Made {}", inserted.first->second);
   }
 }
 
-void PythiaConnector::processEvent(unsigned int eventNo, papas::PapasManager& papasManager) {
+void PythiaConnector::processEvent(unsigned int eventNo, papas::PapasManager& papasManager,
+                                   papas::PileupMixer* pileup) {
   // make a papas particle collection from the next event
   // then run simulate and reconstruct
-  m_reader.goToEvent(eventNo);
-  papasManager.setEventNo(eventNo);
+  papas::Timeline::Span eventSpan("event", "event", eventNo);
   const fcc::MCParticleCollection* ptcs;
-  if (m_store.get("GenParticle", ptcs)) {
+  bool found;
+  {
+    papas::Timeline::Span readSpan("read event", "io", eventNo);
+    papas::AllocTracker::Scope allocScope(papas::AllocTracker::kIO);
+    m_reader.goToEvent(eventNo);
+    found = m_store.get("GenParticle", ptcs);
+  }
+  papasManager.setEventNo(eventNo);
+  if (found) {
     try {
       papasManager.clear();
       papas::Particles& genParticles = papasManager.createParticles();
-      makePapasParticlesFromGeneratedParticles(ptcs, genParticles, papasManager.detector());
+      makePapasParticlesFromGeneratedParticles(ptcs, genParticles);
+      if (pileup != nullptr) pileup->mix(genParticles);
       papasManager.addParticles(genParticles);
       papasManager.simulate('s');
       papasManager.mergeClusters("es");
@@ -127,6 +141,119 @@ void PythiaConnector::processEvent(unsigned int eventNo, papas::PapasManager& pa
   m_reader.endOfEvent();
 }
 
+void PythiaConnector::fillPileupPool(papas::PileupMixer& mixer, unsigned int firstEvent, unsigned int nEvents) {
+  papas::AllocTracker::Scope allocScope(papas::AllocTracker::kIO);
+  std::vector<papas::PileupMixer::PoolParticle> event;
+  unsigned int lastEvent = std::min<unsigned int>(firstEvent + nEvents, m_reader.getEntries());
+  for (unsigned int eventNo = firstEvent; eventNo < lastEvent; ++eventNo) {
+    m_reader.goToEvent(eventNo);
+    const fcc::MCParticleCollection* ptcs;
+    if (m_store.get("GenParticle", ptcs)) {
+      event.clear();
+      for (const auto& ptc : *ptcs) {
+        // same selection as makePapasParticlesFromGeneratedParticles: stable, visible particles
+        auto p4 = ptc.core().p4;
+        int pdgid = ptc.core().pdgId;
+        if (ptc.core().status != 1 || abs(pdgid) == 12 || abs(pdgid) == 14 || abs(pdgid) == 16) continue;
+        TLorentzVector tlv;
+        tlv.SetXYZM(p4.px, p4.py, p4.pz, p4.mass);
+        if (tlv.Pt() <= 1e-5) continue;
+        TVector3 startVertex(0, 0, 0);
+        if (ptc.startVertex().isAvailable())
+          startVertex =
+              TVector3(ptc.startVertex().x() * 1e-3, ptc.startVertex().y() * 1e-3, ptc.startVertex().z() * 1e-3);
+        event.push_back(papas::PileupMixer::PoolParticle{pdgid, (float)ptc.core().charge, tlv, startVertex});
+      }
+      mixer.addPoolEvent(event);
+    }
+    m_store.clear();
+    m_reader.endOfEvent();
+  }
+}
+
+void PythiaConnector::processRecoEvent(unsigned int eventNo, papas::PapasManager& papasManager,
+                                       const std::string& ecalName, const std::string& hcalName,
+                                       const std::string& trackName) {
+  // make papas clusters and tracks from the next fully simulated event
+  // then reconstruct them (there is no papas simulation)
+  papas::Timeline::Span eventSpan("event", "event", eventNo);
+  const fcc::CaloClusterCollection* ecals;
+  const fcc::CaloClusterCollection* hcals;
+  const fcc::TrackCollection* fccTracks;
+  bool found;
+  {
+    papas::Timeline::Span readSpan("read event", "io", eventNo);
+    papas::AllocTracker::Scope allocScope(papas::AllocTracker::kIO);
+    m_reader.goToEvent(eventNo);
+    found = m_store.get(ecalName, ecals) && m_store.get(hcalName, hcals) && m_store.get(trackName, fccTracks);
+  }
+  papasManager.setEventNo(eventNo);
+  if (found) {
+    try {
+      papasManager.clear();
+      // full simulation clusters have no size, so the detector's photon and hadron cluster sizes are used
+      const auto& detector = papasManager.detector();
+      TLorentzVector tlv;
+      double ecalSize = detector.ecal()->clusterSize(papas::Particle(22, 0, tlv, 0, 'u'));
+      double hcalSize = detector.hcal()->clusterSize(papas::Particle(211, 1, tlv, 0, 'u'));
+      auto& ecalClusters = papasManager.createClusters();
+      makePapasClustersFromCaloClusters(ecals, ecalSize, papas::IdCoder::kEcalCluster, ecalClusters);
+      papasManager.addClusters(ecalClusters);
+      auto& hcalClusters = papasManager.createClusters();
+      makePapasClustersFromCaloClusters(hcals, hcalSize, papas::IdCoder::kHcalCluster, hcalClusters);
+      papasManager.addClusters(hcalClusters);
+      auto& tracks = papasManager.createTracks();
+      makePapasTracksFromTracks(fccTracks, papasManager, tracks);
+      papasManager.addTracks(tracks);
+      papasManager.mergeClusters("es");
+      papasManager.mergeClusters("hs");
+      papasManager.buildBlocks('m', 'm', 's');
+      papasManager.simplifyBlocks('r');
+      papasManager.reconstruct('s');
+    } catch (std::string message) {
+      papas::Log::error("An error occurred and event was discarsed. Event no: {} : {}", eventNo, message);
+    }
+    m_store.clear();
+  }
+
+  m_reader.endOfEvent();
+}
+
+void PythiaConnector::makePapasClustersFromCaloClusters(const fcc::CaloClusterCollection* fccClusters, double size,
+                                                        papas::IdCoder::ItemType itemType,
+                                                        papas::Clusters& clusters) const {
+  clusters.reserve(clusters.size() + fccClusters->size());
+  for (const auto& c : *fccClusters) {
+    const auto& core = c.core();
+    if (core.energy <= 0) continue;
+    // fcc positions are in mm
+    TVector3 position(core.position.x * 1e-3, core.position.y * 1e-3, core.position.z * 1e-3);
+    papas::Cluster cluster(core.energy, position, size, clusters.size(), itemType, 's');
+    papas::PDebug::write("Made {}", cluster);
+    clusters.emplace(cluster.id(), std::move(cluster));
+  }
+}
+
+void PythiaConnector::makePapasTracksFromTracks(const fcc::TrackCollection* fccTracks,
+                                                const papas::PapasManager& papasManager, papas::Tracks& tracks) const {
+  tracks.reserve(tracks.size() + fccTracks->size());
+  for (const auto& t : *fccTracks) {
+    if (t.states_size() == 0) continue;
+    // the first state is taken to be the one at the vertex
+    const auto state = t.states(0);
+    if (state.qOverP() == 0) continue;
+    double p = 1. / fabs(state.qOverP());
+    double charge = state.qOverP() > 0 ? 1 : -1;
+    TVector3 p3;
+    p3.SetMagThetaPhi(p, state.theta(), state.phi());
+    const auto& ref = state.referencePoint();
+    TVector3 vertex(ref.x * 1e-3, ref.y * 1e-3, ref.z * 1e-3);
+    papas::Track track(p3, charge, papasManager.makeTrackPath(p3, charge, vertex), tracks.size(), 's');
+    papas::PDebug::write("Made {}", track);
+    tracks.emplace(track.id(), std::move(track));
+  }
+}
+
 void PythiaConnector::displayEvent(const papas::PapasManager& papasManager) {
   papas::PFApp myApp{};  // I think this should turn into a PapasManager member
   myApp.display(papasManager.event(), papasManager.detector());
@@ -134,6 +261,7 @@ void PythiaConnector::displayEvent(const papas::PapasManager& papasManager) {
 }
 
 void PythiaConnector::writeParticlesROOT(const char* fname, const papas::Particles& particles) {
+  papas::AllocTracker::Scope allocScope(papas::AllocTracker::kIO);
 
   podio::ROOTWriter writer(fname, &m_store);
 
@@ -193,21 +321,6 @@ void PythiaConnector::writeClustersROOT(const char* fname, const papas::Clusters
   writer.finish();
 }
 
-papas::Clusters PythiaConnector::ConvertClustersToPapas(const fcc::CaloClusterCollection& fccClusters,
-                                                        float size,
-                                                        papas::IdCoder::ItemType itemtype,
-                                                        char subtype) const {
-  papas::Clusters clusters;
-  for (const auto& c : fccClusters) {
-    const auto position = c.core().position;
-    const auto energy = c.core().energy;
-    papas::Cluster cluster(energy, TVector3(position.x, position.y, position.z), size, clusters.size(), itemtype,
-                           subtype);
-    clusters.emplace(cluster.id(), std::move(cluster));
-  }
-  return clusters;
-}
-
 void PythiaConnector::AddClustersToEDM(const papas::Clusters& papasClusters, fcc::CaloClusterCollection& fccClusters) {
   for (const auto& c : papasClusters) {
     auto clust = fccClusters.create();
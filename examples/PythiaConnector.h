@@ -8,10 +8,12 @@
 
 #ifndef PythiaConnector_h
 #define PythiaConnector_h
+#include "datamodel/CaloClusterCollection.h"
 #include "datamodel/EventInfoCollection.h"
 #include "datamodel/GenVertexConst.h"
 #include "datamodel/MCParticleCollection.h"
 #include "datamodel/ParticleCollection.h"
+#include "datamodel/TrackCollection.h"
 #include "utilities/ParticleUtils.h"
 
 // ROOT
@@ -23,6 +25,7 @@
 
 // STL
 #include <iostream>
+#include <string>
 #include <vector>
 
 // podio specific includes
@@ -35,6 +38,7 @@
 #include "papas/datatypes/IdCoder.h"
 #include "papas/datatypes/Particle.h"
 #include "papas/reconstruction/PapasManager.h"
+#include "papas/simulation/PileupMixer.h"
 
 class PapasManager;
 
@@ -42,19 +46,48 @@ class PapasManager;
 class PythiaConnector {
 public:
   PythiaConnector(const char* fname);
+  /// Writes one event to a new file fname, see PapasWriter for writing all the events of a run to one file
   void writeParticlesROOT(const char* fname, const papas::Particles& particles);
   void writeClustersROOT(const char* fname, const papas::Clusters& clusters);
 
   // todo find new home;
   void displayEvent(const papas::PapasManager& papasManager);
-  void processEvent(unsigned int eventNo, papas::PapasManager& papasManager);  ///<reads and processes a Pythia event
+  /** Reads and processes a Pythia event
+   * @param[in] eventNo event number
+   * @param[in] papasManager manager that simulates and reconstructs the event
+   * @param[in] pileup optional mixer that overlays minimum-bias interactions on the event before simulation
+   */
+  void processEvent(unsigned int eventNo, papas::PapasManager& papasManager, papas::PileupMixer* pileup = nullptr);
+  /** Reads minimum-bias events from this file (once) into the pool of a pileup mixer
+   * @param[inout] mixer the mixer whose pool is filled
+   * @param[in] firstEvent first event to read
+   * @param[in] nEvents number of events to read (stops at the end of the file)
+   */
+  void fillPileupPool(papas::PileupMixer& mixer, unsigned int firstEvent, unsigned int nEvents);
+  /** Reads the calorimeter clusters and tracks of a fully simulated event and reconstructs them in place of the
+   * PAPAS simulation. They are imported as the smeared clusters "es", "hs" and tracks "ts", the clusters having the
+   * size that the detector gives to photon (ecal) and charged pion (hcal) clusters.
+   * @param[in] eventNo event number
+   * @param[in] papasManager manager that reconstructs the event
+   * @param[in] ecalName name of the ecal fcc::CaloClusterCollection
+   * @param[in] hcalName name of the hcal fcc::CaloClusterCollection
+   * @param[in] trackName name of the fcc::TrackCollection
+   */
+  void processRecoEvent(unsigned int eventNo, papas::PapasManager& papasManager,
+                        const std::string& ecalName = "ECalClusters", const std::string& hcalName = "HCalClusters",
+                        const std::string& trackName = "Tracks");
 
   ///< Takes pythia particles and creates Papas type particles adding them into
-  /// an empty Particles collection
-  void makePapasParticlesFromGeneratedParticles(const fcc::MCParticleCollection* ptcs, papas::Particles& particles,
-                                                const papas::Detector& detector);
-  papas::Clusters ConvertClustersToPapas(const fcc::CaloClusterCollection& fccClusters, float size,
-                                         papas::IdCoder::ItemType itemtype, char subtype) const;
+  /// an empty Particles collection. The particles have no path, PapasManager::addParticles makes it.
+  void makePapasParticlesFromGeneratedParticles(const fcc::MCParticleCollection* ptcs, papas::Particles& particles);
+  /// Takes fcc calorimeter clusters and creates smeared Papas clusters of the given size and type, adding them into
+  /// an empty Clusters collection
+  void makePapasClustersFromCaloClusters(const fcc::CaloClusterCollection* fccClusters, double size,
+                                         papas::IdCoder::ItemType itemType, papas::Clusters& clusters) const;
+  /// Takes fcc tracks and creates smeared Papas tracks adding them into an empty Tracks collection. Their paths are
+  /// made by the papasManager, the points where they meet the calorimeters are computed when first needed.
+  void makePapasTracksFromTracks(const fcc::TrackCollection* fccTracks, const papas::PapasManager& papasManager,
+                                 papas::Tracks& tracks) const;
   void AddClustersToEDM(const papas::Clusters& papasClusters, fcc::CaloClusterCollection& fccClusters);
 
 private:
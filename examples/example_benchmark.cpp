@@ -0,0 +1,212 @@
+//
+//  example_benchmark.cpp
+//
+//  Profiles each stage of papas (simulation, merging, block building, simplification and reconstruction)
+//  on events made by the ParticleGun. With large numbers of particles the events contain thousands of blocks.
+//  Hardware counters (IPC, cache and branch misses per object) are shown for each stage when Linux perf events
+//  are available, and the heap allocations of each stage when built with cmake -Dpapas_alloc_tracking=ON.
+//  Optionally writes a timeline of the events, stages and blocks that can be opened in a Chrome/Perfetto trace
+//  viewer, and per event workload metrics (prefix.csv) with their totals and histograms (prefix.prom, Prometheus
+//  format). A mean pileup overlays that many soft minimum-bias interactions on each event.
+//
+//  To measure throughput and latency on a fixed sample, or how they scale, use papasbench and papasscaling.
+//
+// C++
+#include <iostream>
+#include <stdio.h>
+
+#include "papas/detectors/CMS.h"
+#include "papas/reconstruction/PapasManager.h"
+#include "papas/simulation/ParticleGun.h"
+#include "papas/simulation/PileupMixer.h"
+#include "papas/utility/AllocTracker.h"
+#include "papas/utility/Metrics.h"
+#include "papas/utility/PDebug.h"
+#include "papas/utility/PerfCounters.h"
+#include "papas/utility/TRandom.h"
+#include "papas/utility/Timeline.h"
+
+// STL
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct Options {
+  unsigned int events = 10;      ///< number of events
+  unsigned int particles = 100;  ///< particles per event
+  unsigned int jets = 0;         ///< jets per event
+  std::string log;               ///< physics debug output (binary if it ends in .trace), or empty for none
+  std::string timeline;          ///< Chrome trace-event timeline, or empty for none
+  std::string metrics;           ///< prefix of the metrics files, or empty for none
+  double pileup = 0;             ///< mean number of pileup interactions per event
+};
+
+int usage() {
+  std::cerr << "Usage: ./example_benchmark [options]" << std::endl
+            << "  --events N          number of events (default 10)" << std::endl
+            << "  --particles N       particles per event (default 100)" << std::endl
+            << "  --jets N            jets per event (default 0)" << std::endl
+            << "  --log file          physics debug output, binary if the name ends in .trace (default none)"
+            << std::endl
+            << "  --timeline file     Chrome trace-event timeline (default none)" << std::endl
+            << "  --metrics prefix    per event metrics (prefix.csv) and their summary (prefix.prom)" << std::endl
+            << "  --pileup mean       mean number of minimum-bias interactions per event (default 0)" << std::endl;
+  return 1;
+}
+
+unsigned int number(const std::string& value) {
+  std::size_t end = 0;
+  unsigned long n = std::stoul(value, &end, 0);
+  if (end != value.size()) throw std::string("not a number: " + value);
+  return n;
+}
+
+/// reads the options, returns false if they are not valid
+bool parse(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) return false;
+    std::string name = argv[i];
+    std::string value = argv[i + 1];
+    if (name == "--events")
+      options.events = number(value);
+    else if (name == "--particles")
+      options.particles = number(value);
+    else if (name == "--jets")
+      options.jets = number(value);
+    else if (name == "--log")
+      options.log = value;
+    else if (name == "--timeline")
+      options.timeline = value;
+    else if (name == "--metrics")
+      options.metrics = value;
+    else if (name == "--pileup") {
+      std::size_t end = 0;
+      options.pileup = std::stod(value, &end);
+      if (end != value.size()) throw std::string("not a number: " + value);
+    } else
+      return false;
+  }
+  return options.events > 0 && options.pileup >= 0;
+}
+
+}  // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+
+  rootrandom::Random::seed(0xdeadbeef);
+  Options options;
+  try {
+    if (!parse(argc, argv, options)) return usage();
+    unsigned int nEvents = options.events;
+    unsigned int nParticles = options.particles;
+    unsigned int nJets = options.jets;
+    if (!options.log.empty()) {
+      const std::string& lname = options.log;
+      if (lname.size() > 6 && lname.substr(lname.size() - 6) == ".trace")
+        papas::PDebug::BinaryFile(lname);  // compact binary physics debug output, see papastrace
+      else
+        papas::PDebug::File(lname);  // physics debug output
+    }
+
+    // Create CMS detector and PapasManager
+    papas::CMS CMSDetector;
+    papas::PapasManager papasManager(CMSDetector);
+    papas::ParticleGun gun(CMSDetector);
+    if (!options.timeline.empty()) papas::Timeline::start();  // Chrome trace-event timeline of events, stages, blocks
+    const std::string& metricsPrefix = options.metrics;
+    if (!metricsPrefix.empty()) papas::Metrics::start(metricsPrefix + ".csv");  // per event workload counters
+
+    const std::array<const char*, 5> stages = {{"simulate", "merge", "blocks", "simplify", "reconstruct"}};
+    std::array<double, 5> times{};
+    std::size_t nBlocks = 0;
+    std::size_t nReconstructed = 0;
+    auto stamp = std::chrono::steady_clock::now();
+    auto lap = [&stamp](double& total) {
+      auto now = std::chrono::steady_clock::now();
+      total += std::chrono::duration<double, std::milli>(now - stamp).count();
+      stamp = now;
+    };
+
+    double meanPileup = options.pileup;
+    papas::PileupMixer pileup(CMSDetector, meanPileup);
+    if (meanPileup > 0) {
+      papas::ParticleGun minbias(CMSDetector, 2);
+      minbias.setEnergyRange(0.3, 5.);
+      minbias.setEtaMax(4.);
+      pileup.fillPool(minbias, 500, 30);
+    }
+    papas::AllocTracker::resetRun();
+    papas::PerfCounters::start();  // falls back to timing only if the hardware counters are unavailable
+    for (unsigned i = 0; i < nEvents; ++i) {
+      papas::Timeline::Span span("event", "event", i);
+      papasManager.clear();
+      papasManager.setEventNo(i);
+      papas::PDebug::write("Event: {}", i);
+      auto& particles = papasManager.createParticles();
+      gun.makeParticles(nParticles, particles, nJets);
+      if (meanPileup > 0) pileup.mix(particles);
+      papasManager.addParticles(particles);
+      stamp = std::chrono::steady_clock::now();
+      auto eventStart = stamp;
+      papasManager.simulate();
+      lap(times[0]);
+      papasManager.mergeClusters("es");
+      papasManager.mergeClusters("hs");
+      lap(times[1]);
+      papasManager.buildBlocks();
+      lap(times[2]);
+      papasManager.simplifyBlocks('r');
+      lap(times[3]);
+      papasManager.reconstruct('s');
+      lap(times[4]);
+      papas::Metrics::endEvent(i, std::chrono::duration<double>(stamp - eventStart).count());
+      papas::AllocTracker::endEvent();
+      nBlocks += papasManager.event().blocks('s').size();
+      nReconstructed += papasManager.event().particles('r').size();
+    }
+
+    double total = 0;
+    std::cout << "events: " << nEvents << " particles/event: " << nParticles << " jets/event: " << nJets << std::endl;
+    std::cout << "blocks/event: " << (double)nBlocks / nEvents
+              << " reconstructed particles/event: " << (double)nReconstructed / nEvents << std::endl;
+    for (std::size_t s = 0; s < stages.size(); ++s) {
+      std::cout << stages[s] << ": " << times[s] / nEvents << " ms/event" << std::endl;
+      total += times[s];
+    }
+    std::cout << "total: " << total / nEvents << " ms/event, " << 1000 * nEvents / total << " Evs/s" << std::endl;
+    std::cout << "block topologies:";
+    for (unsigned t = 0; t < papas::PFReconstructor::kNumTopologies; ++t) {
+      auto topology = static_cast<papas::PFReconstructor::Topology>(t);
+      std::cout << " " << papas::PFReconstructor::topologyName(topology) << "=" << papasManager.topologyCounts()[t];
+    }
+    std::cout << std::endl;
+    papas::PerfCounters::stop();
+    std::cout << "stage counters:\n" << papas::PerfCounters::report();
+    if (papas::AllocTracker::isEnabled())
+      std::cout << "heap allocations:\n"
+                << papas::AllocTracker::summary(papas::AllocTracker::runTotals(), papas::AllocTracker::numEvents());
+    if (!options.timeline.empty()) papas::Timeline::write(options.timeline);
+    if (!metricsPrefix.empty()) {
+      papas::Metrics::writePrometheus(metricsPrefix + ".prom");
+      papas::Metrics::stop();
+    }
+    return EXIT_SUCCESS;
+  } catch (std::runtime_error& err) {
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    exit(1);
+  } catch (std::logic_error& err) {  // eg an option that is not a number
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    return usage();
+  } catch (const char* c) {
+    std::cerr << c << ". Quitting." << std::endl;
+    exit(1);
+  } catch (const std::string& s) {
+    std::cerr << s << ". Quitting." << std::endl;
+    exit(1);
+  }
+}
@@ -12,25 +12,28 @@
 #include "papas/detectors/CMS.h"
 #include "papas/reconstruction/PapasManager.h"
 #include "papas/utility/PDebug.h"
+#include "papas/utility/ProcessPool.h"
 #include "papas/utility/TRandom.h"
 
 // STL
 #include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
 
 int main(int argc, char* argv[]) {
 
   papas::PDebug::File("physics.txt");
   rootrandom::Random::seed(0xdeadbeef);
 
-  if (argc != 2) {
-    std::cerr << "Usage: ./mainexe filename" << std::endl;
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: ./mainexe filename [nworkers]" << std::endl;
     return 1;
   }
   const char* fname = argv[1];
+  unsigned int nWorkers = (argc == 3) ? std::stoi(argv[2]) : 1;
   // open the Pythia file fname
   try {
-    PythiaConnector pythiaConnector(fname);
 #if WITHSORT
     std::cout << "doing sorting";
 #else
@@ -45,18 +48,44 @@ int main(int argc, char* argv[]) {
 
     auto start = std::chrono::steady_clock::now();
 
-    for (unsigned i = eventNo; i < eventNo + nEvents; ++i) {
+    // every event has its own random seed so that the results do not depend on the number of workers
+    if (nWorkers > 1) {
+      // each worker process opens the file itself and writes its own physics debug file
+      std::unique_ptr<PythiaConnector> pythiaConnector;
+      auto summaries = papas::ProcessPool::run(
+          nWorkers, eventNo, nEvents,
+          [&](unsigned int i) {
+            papas::PDebug::write("Event: {}", i);
+            rootrandom::Random::seed(0xdeadbeef + i);
+            pythiaConnector->processEvent(i, papasManager);
+            return papasManager.event().particles('r').size();
+          },
+          [&](unsigned int worker) {
+            papas::PDebug::File(papas::ProcessPool::workerFileName("physics.txt", worker));
+            pythiaConnector.reset(new PythiaConnector(fname));
+          },
+          [&](unsigned int) { papas::PDebug::flush(); });
+      papas::ProcessPool::mergeFiles("physics.txt", nWorkers);
+      std::size_t nReconstructed = 0;
+      for (const auto& summary : summaries)
+        nReconstructed += summary.reconstructed;
+      std::cout << std::endl << nWorkers << " workers reconstructed " << nReconstructed << " particles" << std::endl;
+    } else {
+      PythiaConnector pythiaConnector(fname);
+      for (unsigned i = eventNo; i < eventNo + nEvents; ++i) {
 
-      papas::PDebug::write("Event: {}", i);
-      if (i % 100 == 0) {
-        std::cout << "reading event " << i << std::endl;
+        papas::PDebug::write("Event: {}", i);
+        if (i % 100 == 0) {
+          std::cout << "reading event " << i << std::endl;
+        }
+        if (i == eventNo)
+          start = std::chrono::steady_clock::now();
+        else {
+          papasManager.clear();
+        }
+        rootrandom::Random::seed(0xdeadbeef + i);
+        pythiaConnector.processEvent(i, papasManager);
       }
-      if (i == eventNo)
-        start = std::chrono::steady_clock::now();
-      else {
-        papasManager.clear();
-      }
-      pythiaConnector.processEvent(i, papasManager);
     }
 
     auto end = std::chrono::steady_clock::now();
@@ -68,5 +97,8 @@ int main(int argc, char* argv[]) {
   } catch (std::runtime_error& err) {
     std::cerr << err.what() << ". Quitting." << std::endl;
     exit(1);
+  } catch (const char* err) {
+    std::cerr << err << ". Quitting." << std::endl;
+    exit(1);
   }
 }
@@ -20,15 +20,18 @@ int main(int argc, char* argv[]) {
   rootrandom::Random::seed(0xdeadbeef);
 
   if (argc < 2) {
-    std::cerr << "Usage: ./example_debug filename [logname]" << std::endl;
+    std::cerr << "Usage: ./example_debug filename [logname or name.trace]" << std::endl;
     return 1;
   }
   const char* fname = argv[1];
   PythiaConnector pythiaConnector(fname);
 
   if (argc == 3) {
-    const char* lname = argv[2];
-    PDebug::File(lname);  // physics debug output
+    std::string lname = argv[2];
+    if (lname.size() > 6 && lname.substr(lname.size() - 6) == ".trace")
+      PDebug::BinaryFile(lname);  // compact binary physics debug output, see papastrace
+    else
+      PDebug::File(lname);  // physics debug output
   }
   Log::init();
   Log::info("Logging Papas ");
@@ -0,0 +1,257 @@
+//
+//  papas_bench.cpp
+//
+//  End-to-end throughput benchmark
+//   ./papasbench --events 100 --particles 100 --jets 4 --json result.json
+//        runs simulate, merge, blocks, simplify and reconstruct on a fixed synthetic sample of ParticleGun events
+//        (event i always uses the same seeds) and reports the throughput and the percentiles of the latency per
+//        event, optionally writing them to a JSON result file
+//   ./papasbench --baseline baseline.json --json result.json --threshold 5
+//        compares a result file with a baseline and fails if the throughput or a latency percentile is worse
+//        than the baseline by more than the threshold (percent)
+//
+#include "papas/detectors/CMS.h"
+#include "papas/reconstruction/PapasManager.h"
+#include "papas/simulation/ParticleGun.h"
+#include "papas/utility/TRandom.h"
+
+// STL
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace papas;
+
+namespace {
+const unsigned int kSeed = 0xdeadbeef;  ///< seed of the sample, event i uses kSeed + i
+const unsigned int kWarmupEvents = 5;   ///< events run (and not measured) before the sample
+const std::array<const char*, 5> stageNames = {{"simulate", "merge", "blocks", "simplify", "reconstruct"}};
+
+struct Result {
+  unsigned int events = 0;
+  unsigned int particles = 0;
+  unsigned int jets = 0;
+  double seconds = 0;               ///< total time of the measured events
+  std::vector<double> latencies;    ///< time of each event (ms), sorted
+  std::array<double, 5> stages{};   ///< total time of each stage (ms)
+  std::size_t reconstructed = 0;    ///< number of reconstructed particles, a check that the sample is unchanged
+  double percentile(double p) const {  ///< nearest rank percentile of the latencies
+    if (latencies.empty()) return 0;
+    std::size_t rank = static_cast<std::size_t>(p / 100. * latencies.size() + 0.5);
+    return latencies[std::min(latencies.size(), std::max<std::size_t>(rank, 1)) - 1];
+  }
+};
+
+struct Options {
+  unsigned int events = 100;     ///< events in the sample
+  unsigned int particles = 100;  ///< particles per event
+  unsigned int jets = 0;         ///< jets per event
+  std::string json;              ///< result file written by a run, or read when comparing
+  std::string baseline;          ///< baseline the result file is compared with, or empty to run the sample
+  double threshold = 5.;         ///< regression threshold (percent)
+};
+
+int usage() {
+  std::cerr << "Usage: ./papasbench [options]" << std::endl
+            << "  --events N          events in the sample (default 100)" << std::endl
+            << "  --particles N       particles per event (default 100)" << std::endl
+            << "  --jets N            jets per event (default 0)" << std::endl
+            << "  --json file.json    result file (default none)" << std::endl
+            << "  --baseline file     compare the --json result with this baseline instead of running" << std::endl
+            << "  --threshold P       regression threshold in percent when comparing (default 5)" << std::endl;
+  return 1;
+}
+
+unsigned int number(const std::string& value) {
+  std::size_t end = 0;
+  unsigned long n = std::stoul(value, &end, 0);
+  if (end != value.size()) throw std::string("not a number: " + value);
+  return n;
+}
+
+/// reads the options, returns false if they are not valid
+bool parse(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) return false;
+    std::string name = argv[i];
+    std::string value = argv[i + 1];
+    if (name == "--events")
+      options.events = number(value);
+    else if (name == "--particles")
+      options.particles = number(value);
+    else if (name == "--jets")
+      options.jets = number(value);
+    else if (name == "--json")
+      options.json = value;
+    else if (name == "--baseline")
+      options.baseline = value;
+    else if (name == "--threshold") {
+      std::size_t end = 0;
+      options.threshold = std::stod(value, &end);
+      if (end != value.size()) throw std::string("not a number: " + value);
+    } else
+      return false;
+  }
+  if (!options.baseline.empty()) return !options.json.empty();
+  return options.events > 0;
+}
+
+/// runs one event of the sample, adding the time of each stage to stages
+void runEvent(PapasManager& papasManager, ParticleGun& gun, unsigned int eventNo, unsigned int nParticles,
+              unsigned int nJets, std::array<double, 5>& stages) {
+  papasManager.clear();
+  papasManager.setEventNo(eventNo);
+  gun.seed(kSeed + eventNo);
+  rootrandom::Random::seed(kSeed + eventNo);
+  auto& particles = papasManager.createParticles();
+  gun.makeParticles(nParticles, particles, nJets);
+  papasManager.addParticles(particles);
+  auto stamp = std::chrono::steady_clock::now();
+  auto lap = [&stamp, &stages](unsigned int stage) {
+    auto now = std::chrono::steady_clock::now();
+    stages[stage] += std::chrono::duration<double, std::milli>(now - stamp).count();
+    stamp = now;
+  };
+  papasManager.simulate();
+  lap(0);
+  papasManager.mergeClusters("es");
+  papasManager.mergeClusters("hs");
+  lap(1);
+  papasManager.buildBlocks();
+  lap(2);
+  papasManager.simplifyBlocks('r');
+  lap(3);
+  papasManager.reconstruct('s');
+  lap(4);
+}
+
+Result run(unsigned int nEvents, unsigned int nParticles, unsigned int nJets) {
+  CMS CMSDetector;
+  PapasManager papasManager(CMSDetector);
+  ParticleGun gun(CMSDetector);
+  Result result;
+  result.events = nEvents;
+  result.particles = nParticles;
+  result.jets = nJets;
+  std::array<double, 5> warmup{};
+  for (unsigned int i = 0; i < kWarmupEvents; ++i)
+    runEvent(papasManager, gun, nEvents + i, nParticles, nJets, warmup);  // not part of the sample
+  for (unsigned int i = 0; i < nEvents; ++i) {
+    std::array<double, 5> stages{};
+    runEvent(papasManager, gun, i, nParticles, nJets, stages);
+    double latency = 0;
+    for (unsigned int s = 0; s < stages.size(); ++s) {
+      latency += stages[s];
+      result.stages[s] += stages[s];
+    }
+    result.latencies.push_back(latency);
+    result.seconds += latency * 1e-3;
+    result.reconstructed += papasManager.event().particles('r').size();
+  }
+  std::sort(result.latencies.begin(), result.latencies.end());
+  return result;
+}
+
+void print(const Result& r) {
+  std::printf("events: %u particles/event: %u jets/event: %u reconstructed particles: %zu\n", r.events, r.particles,
+              r.jets, r.reconstructed);
+  std::printf("throughput: %.2f Evs/s\n", r.events / r.seconds);
+  std::printf("latency (ms): mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", 1e3 * r.seconds / r.events,
+              r.percentile(50), r.percentile(90), r.percentile(99), r.latencies.back());
+  for (unsigned int s = 0; s < stageNames.size(); ++s)
+    std::printf("%s: %.3f ms/event\n", stageNames[s], r.stages[s] / r.events);
+}
+
+void writeJson(const Result& r, const std::string& fname) {
+  FILE* file = std::fopen(fname.c_str(), "w");
+  if (file == nullptr) throw std::string("unable to open " + fname);
+  std::fprintf(file, "{\n  \"events\": %u,\n  \"particles\": %u,\n  \"jets\": %u,\n  \"seed\": %u,\n", r.events,
+               r.particles, r.jets, kSeed);
+  std::fprintf(file, "  \"reconstructed\": %zu,\n  \"throughput_evs\": %.6g,\n", r.reconstructed, r.events / r.seconds);
+  std::fprintf(file, "  \"latency_mean_ms\": %.6g,\n  \"latency_p50_ms\": %.6g,\n  \"latency_p90_ms\": %.6g,\n",
+               1e3 * r.seconds / r.events, r.percentile(50), r.percentile(90));
+  std::fprintf(file, "  \"latency_p99_ms\": %.6g,\n  \"latency_max_ms\": %.6g", r.percentile(99), r.latencies.back());
+  for (unsigned int s = 0; s < stageNames.size(); ++s)
+    std::fprintf(file, ",\n  \"stage_%s_ms\": %.6g", stageNames[s], r.stages[s] / r.events);
+  std::fprintf(file, "\n}\n");
+  if (std::fclose(file) != 0) throw std::string("unable to write " + fname);
+}
+
+/// reads a whole file
+std::string readFile(const std::string& fname) {
+  std::ifstream in(fname);
+  if (!in) throw std::string("unable to open " + fname);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+/// value of a number written by writeJson
+double jsonNumber(const std::string& text, const std::string& key, const std::string& fname) {
+  auto pos = text.find("\"" + key + "\":");
+  if (pos == std::string::npos) throw std::string(fname + " has no " + key);
+  return std::strtod(text.c_str() + pos + key.size() + 3, nullptr);
+}
+
+/// returns the number of regressions
+int compare(const std::string& baselineName, const std::string& resultName, double threshold) {
+  std::string baseline = readFile(baselineName);
+  std::string result = readFile(resultName);
+  for (const char* key : {"events", "particles", "jets", "seed", "reconstructed"})
+    if (jsonNumber(baseline, key, baselineName) != jsonNumber(result, key, resultName))
+      std::cout << "warning: " << key << " differs, the samples are not the same" << std::endl;
+  // throughput should not go down, latencies should not go up
+  const std::array<std::pair<const char*, double>, 5> metrics = {{{"throughput_evs", -1.},
+                                                                  {"latency_mean_ms", 1.},
+                                                                  {"latency_p50_ms", 1.},
+                                                                  {"latency_p90_ms", 1.},
+                                                                  {"latency_p99_ms", 1.}}};
+  int regressions = 0;
+  for (const auto& metric : metrics) {
+    double before = jsonNumber(baseline, metric.first, baselineName);
+    double after = jsonNumber(result, metric.first, resultName);
+    double change = (before != 0) ? 100. * (after - before) / before : 0.;
+    bool regressed = change * metric.second > threshold;
+    regressions += regressed;
+    std::printf("%-16s baseline %12.4f result %12.4f change %+7.2f%%%s\n", metric.first, before, after, change,
+                regressed ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+}
+
+int main(int argc, char* argv[]) {
+  Options options;
+  try {
+    if (!parse(argc, argv, options)) return usage();
+    if (!options.baseline.empty()) {
+      int regressions = compare(options.baseline, options.json, options.threshold);
+      std::cout << regressions << " regressions beyond " << options.threshold << "%" << std::endl;
+      return regressions ? 2 : 0;
+    }
+    Result result = run(options.events, options.particles, options.jets);
+    print(result);
+    if (!options.json.empty()) writeJson(result, options.json);
+  } catch (std::runtime_error& err) {
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    return 1;
+  } catch (std::logic_error& err) {  // eg an option that is not a number
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    return usage();
+  } catch (const char* c) {
+    std::cerr << c << ". Quitting." << std::endl;
+    return 1;
+  } catch (const std::string& s) {
+    std::cerr << s << ". Quitting." << std::endl;
+    return 1;
+  }
+  return EXIT_SUCCESS;
+}
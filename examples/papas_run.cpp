@@ -0,0 +1,222 @@
+//
+//  papas_run.cpp
+//
+//  Batch driver: simulates and reconstructs one shard of a range of events and writes the reconstructed particles
+//  (and optionally the metrics) of the shard. The shards of a range do not overlap and event i is always seeded
+//  with seed + i, so a production can be split into any number of jobs and the per shard outputs merged afterwards
+//  by concatenating them (keeping only the first header line).
+//
+//  The reconstructed particles, merged clusters and smeared tracks can also be written to a podio ROOT file (one
+//  per worker, see PapasWriter), with links to the simulated particles unless no history is recorded.
+//
+//  The events are read from a Pythia (podio) file, or made by the ParticleGun if no input is given.
+//  Each shard can be run in several worker processes (see ProcessPool) and connected components of large graphs
+//  can use several threads (see ConnectedComponents).
+//
+#include "PapasWriter.h"
+#include "PythiaConnector.h"
+#include "papas/detectors/CMS.h"
+#include "papas/graphtools/ConnectedComponents.h"
+#include "papas/graphtools/DefinitionsNodes.h"
+#include "papas/reconstruction/PapasManager.h"
+#include "papas/simulation/ParticleGun.h"
+#include "papas/utility/Metrics.h"
+#include "papas/utility/ProcessPool.h"
+#include "papas/utility/TRandom.h"
+
+// STL
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace papas;
+
+namespace {
+
+struct Options {
+  std::string input;                          ///< Pythia file, or empty to use the particle gun
+  unsigned int first = 0;                     ///< first event of the range
+  unsigned int count = 100;                   ///< number of events in the range
+  unsigned int shard = 0;                     ///< shard of the range processed by this job
+  unsigned int shards = 1;                    ///< number of shards the range is split into
+  unsigned int workers = 1;                   ///< worker processes
+  unsigned int threads = 0;                   ///< threads for connected components, 0 = hardware concurrency
+  unsigned int seed = 0xdeadbeef;             ///< event i is seeded with seed + i
+  HistoryLevel history = HistoryLevel::kFull;  ///< history recorded
+  std::string output = "papas_particles.csv";  ///< reconstructed particles of the shard
+  std::string metrics;                        ///< per event metrics of the shard (CSV), or empty for none
+  std::string root;                           ///< podio output of the shard, or empty for none
+  unsigned int particles = 100;               ///< particles per gun event
+  unsigned int jets = 0;                      ///< jets per gun event
+};
+
+int usage() {
+  std::cerr << "Usage: ./papasrun [options]" << std::endl
+            << "  --input file.root   Pythia events (default: particle gun events)" << std::endl
+            << "  --first N           first event of the range (default 0)" << std::endl
+            << "  --count N           number of events in the range (default 100)" << std::endl
+            << "  --shard i/n         process shard i of n of the range (default 0/1)" << std::endl
+            << "  --workers N         worker processes (default 1)" << std::endl
+            << "  --threads N         threads for large link graphs (default: one per hardware thread)" << std::endl
+            << "  --seed S            event i is seeded with S + i (default 3735928559)" << std::endl
+            << "  --history level     none, truth or full (default full), tracks always keep their truth links"
+            << std::endl
+            << "  --output file.csv   reconstructed particles (default papas_particles.csv)" << std::endl
+            << "  --metrics file.csv  per event metrics (default none)" << std::endl
+            << "  --root file.root    podio output, one file per worker if several (default none)" << std::endl
+            << "  --particles N       particles per gun event (default 100)" << std::endl
+            << "  --jets N            jets per gun event (default 0)" << std::endl;
+  return 1;
+}
+
+unsigned int number(const std::string& value) {
+  std::size_t end = 0;
+  unsigned long n = std::stoul(value, &end, 0);
+  if (end != value.size()) throw std::string("not a number: " + value);
+  return n;
+}
+
+/// reads the options, returns false if they are not valid
+bool parse(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) return false;
+    std::string name = argv[i];
+    std::string value = argv[i + 1];
+    if (name == "--input")
+      options.input = value;
+    else if (name == "--first")
+      options.first = number(value);
+    else if (name == "--count")
+      options.count = number(value);
+    else if (name == "--shard") {
+      auto slash = value.find('/');
+      if (slash == std::string::npos) return false;
+      options.shard = number(value.substr(0, slash));
+      options.shards = number(value.substr(slash + 1));
+    } else if (name == "--workers")
+      options.workers = number(value);
+    else if (name == "--threads")
+      options.threads = number(value);
+    else if (name == "--seed")
+      options.seed = number(value);
+    else if (name == "--history") {
+      if (value == "none")
+        options.history = HistoryLevel::kNone;
+      else if (value == "truth")
+        options.history = HistoryLevel::kTruth;
+      else if (value == "full")
+        options.history = HistoryLevel::kFull;
+      else
+        return false;
+    } else if (name == "--output")
+      options.output = value;
+    else if (name == "--metrics")
+      options.metrics = value;
+    else if (name == "--root")
+      options.root = value;
+    else if (name == "--particles")
+      options.particles = number(value);
+    else if (name == "--jets")
+      options.jets = number(value);
+    else
+      return false;
+  }
+  return options.shards > 0 && options.shard < options.shards && options.workers > 0;
+}
+
+}  // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  try {
+    if (!parse(argc, argv, options)) return usage();
+    // the events of this shard
+    unsigned int begin = options.first + (uint64_t)options.count * options.shard / options.shards;
+    unsigned int end = options.first + (uint64_t)options.count * (options.shard + 1) / options.shards;
+
+    setHistoryLevel(options.history);
+    ConnectedComponents::setThreads(options.threads);
+    if (!options.metrics.empty()) Metrics::start(options.metrics);
+    CMS CMSDetector;
+    PapasManager papasManager(CMSDetector);
+    if (options.root.empty())
+      papasManager.setRetention(PapasManager::Retention::kPruned);  // only the reconstructed particles are written
+    else  // the podio output also has the merged clusters (which point to the smeared ones) and the smeared tracks
+      papasManager.setRetention(PapasManager::Retention::kPruned, {"es", "hs", "em", "hm", "ts"});
+    ParticleGun gun(CMSDetector);
+    std::unique_ptr<PythiaConnector> pythiaConnector;
+    std::unique_ptr<PapasWriter> writer;
+    FILE* out = nullptr;
+
+    auto process = [&](unsigned int eventNo) {
+      rootrandom::Random::seed(options.seed + eventNo);
+      if (pythiaConnector) {
+        pythiaConnector->processEvent(eventNo, papasManager);
+      } else {
+        papasManager.clear();
+        papasManager.setEventNo(eventNo);
+        gun.seed(options.seed + eventNo);
+        auto& particles = papasManager.createParticles();
+        gun.makeParticles(options.particles, particles, options.jets);
+        papasManager.addParticles(particles);
+        papasManager.simulate();
+        papasManager.mergeAndBuildBlocks();
+        papasManager.simplifyBlocks('r');
+        papasManager.reconstruct('s');
+      }
+      const auto& reconstructed = papasManager.event().particles('r');
+      for (const auto& p : reconstructed) {
+        const auto& particle = p.second;
+        std::fprintf(out, "%u,%d,%g,%.6g,%.6g,%.6g,%.6g\n", eventNo, particle.pdgId(), particle.charge(),
+                     particle.e(), particle.p4().Px(), particle.p4().Py(), particle.p4().Pz());
+      }
+      if (writer) writer->write(eventNo, papasManager.event());
+      return reconstructed.size();
+    };
+    // each worker reads the input itself and writes its own part of the output
+    auto workerStart = [&](unsigned int worker) {
+      if (!options.input.empty()) pythiaConnector.reset(new PythiaConnector(options.input.c_str()));
+      out = std::fopen(ProcessPool::workerFileName(options.output, worker).c_str(), "w");
+      if (out == nullptr) throw std::string("unable to open " + options.output);
+      if (worker == 0) std::fprintf(out, "event,pdgid,charge,e,px,py,pz\n");
+      if (!options.root.empty()) {
+        auto rootName = options.workers > 1 ? ProcessPool::workerFileName(options.root, worker) : options.root;
+        writer.reset(new PapasWriter(rootName, options.history != HistoryLevel::kNone));
+      }
+    };
+    auto workerEnd = [&](unsigned int) {
+      if (std::fclose(out) != 0) throw std::string("unable to write " + options.output);
+      if (writer) writer->close();
+      writer.reset();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    auto summaries = ProcessPool::run(options.workers, begin, end - begin, process, workerStart, workerEnd);
+    ProcessPool::mergeFiles(options.output, options.workers);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t nReconstructed = 0;
+    for (const auto& summary : summaries)
+      nReconstructed += summary.reconstructed;
+    if (!options.metrics.empty()) Metrics::stop();
+    std::printf("shard %u/%u: events %u to %u, %zu reconstructed particles, %.3f s, %.2f Evs/s\n", options.shard,
+                options.shards, begin, end, nReconstructed, seconds, (end - begin) / seconds);
+  } catch (std::runtime_error& err) {
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    return 1;
+  } catch (std::logic_error& err) {  // eg an option that is not a number
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    return usage();
+  } catch (const char* c) {
+    std::cerr << c << ". Quitting." << std::endl;
+    return 1;
+  } catch (const std::string& s) {
+    std::cerr << s << ". Quitting." << std::endl;
+    return 1;
+  }
+  return EXIT_SUCCESS;
+}
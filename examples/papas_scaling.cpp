@@ -0,0 +1,262 @@
+//
+//  papas_scaling.cpp
+//
+//  Scaling study: runs the papas stages on ParticleGun events of increasing multiplicity (10 particles up to
+//  maxParticles) for one or more particle densities, and measures the time and memory of each stage. The density is
+//  set by the eta range into which the particles are shot (|eta| < etaMax, the smaller the denser).
+//  For each density it prints a table of the time per event of each stage, the local complexity exponent between
+//  successive multiplicities and an exponent fitted to all the points with at least 100 particles, so the point at
+//  which a stage stops scaling linearly is easy to see. The measurements are also written to a CSV file (one row per
+//  density, multiplicity and stage) ready for plotting.
+//  The peak memory of each stage is measured exactly when papas is built with allocation tracking
+//  (cmake -Dpapas_alloc_tracking=ON), otherwise only the process high water mark (maxrss) is available.
+//
+#include "papas/detectors/CMS.h"
+#include "papas/reconstruction/PapasManager.h"
+#include "papas/simulation/ParticleGun.h"
+#include "papas/utility/AllocTracker.h"
+#include "papas/utility/Metrics.h"
+#include "papas/utility/TRandom.h"
+
+// STL
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace papas;
+
+namespace {
+const unsigned int kSeed = 0xdeadbeef;  ///< event i of each point uses kSeed + i
+const unsigned int kNumStages = 5;
+const std::array<const char*, kNumStages> stageNames = {{"simulate", "merge", "blocks", "simplify", "reconstruct"}};
+const unsigned int kMinFitParticles = 100;  ///< smaller events are dominated by fixed costs and are not fitted
+
+/// Measurements for one density and multiplicity
+struct Point {
+  unsigned int particles;
+  unsigned int events;
+  std::array<double, kNumStages> ms{};           ///< time per event of each stage
+  std::array<uint64_t, kNumStages> peakBytes{};  ///< largest extra memory used by each stage in an event
+  std::array<long, kNumStages> maxRssKb{};       ///< process high water mark after each stage
+  double distances = 0;                          ///< distance evaluations per event
+  double edges = 0;                              ///< edges kept per event
+  double historyNodes = 0;                       ///< history nodes per event
+  double total() const {
+    double sum = 0;
+    for (double t : ms)
+      sum += t;
+    return sum;
+  }
+};
+
+long maxRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+Point measure(const Detector& detector, unsigned int nParticles, unsigned int nEvents, double etaMax) {
+  PapasManager papasManager(detector);
+  ParticleGun gun(detector);
+  gun.setEtaMax(etaMax);
+  Point point;
+  point.particles = nParticles;
+  point.events = nEvents;
+  Metrics::start();
+  for (unsigned int i = 0; i < nEvents; ++i) {
+    papasManager.clear();
+    papasManager.setEventNo(i);
+    gun.seed(kSeed + i);
+    rootrandom::Random::seed(kSeed + i);
+    auto& particles = papasManager.createParticles();
+    gun.makeParticles(nParticles, particles);
+    papasManager.addParticles(particles);
+    for (unsigned int s = 0; s < kNumStages; ++s) {
+      AllocTracker::resetPeak();
+      uint64_t liveBefore = AllocTracker::liveBytes();
+      auto start = std::chrono::steady_clock::now();
+      switch (s) {
+      case 0:
+        papasManager.simulate();
+        break;
+      case 1:
+        papasManager.mergeClusters("es");
+        papasManager.mergeClusters("hs");
+        break;
+      case 2:
+        papasManager.buildBlocks();
+        break;
+      case 3:
+        papasManager.simplifyBlocks('r');
+        break;
+      case 4:
+        papasManager.reconstruct('s');
+        break;
+      }
+      point.ms[s] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      point.peakBytes[s] = std::max(point.peakBytes[s], AllocTracker::peakBytes() - liveBefore);
+      point.maxRssKb[s] = maxRssKb();
+    }
+    point.distances += Metrics::value(Metrics::kDistanceEvaluations);
+    point.edges += Metrics::value(Metrics::kEdgesCreated);
+    point.historyNodes += Metrics::value(Metrics::kHistoryNodes);
+    Metrics::endEvent(i);
+  }
+  Metrics::stop();
+  for (auto& t : point.ms)
+    t /= nEvents;
+  point.distances /= nEvents;
+  point.edges /= nEvents;
+  point.historyNodes /= nEvents;
+  return point;
+}
+
+/// slope of the least squares line through (log n, log t) for the points with at least kMinFitParticles
+double fitExponent(const std::vector<Point>& points, int stage) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  unsigned int n = 0;
+  for (const auto& p : points) {
+    double t = (stage < 0) ? p.total() : p.ms[stage];
+    if (p.particles < kMinFitParticles || t <= 0) continue;
+    double x = std::log(p.particles), y = std::log(t);
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    ++n;
+  }
+  if (n < 2) return std::nan("");
+  return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+/// exponent between two successive points
+double localExponent(const Point& p1, const Point& p2, int stage) {
+  double t1 = (stage < 0) ? p1.total() : p1.ms[stage];
+  double t2 = (stage < 0) ? p2.total() : p2.ms[stage];
+  if (t1 <= 0 || t2 <= 0) return std::nan("");
+  return std::log(t2 / t1) / std::log(double(p2.particles) / p1.particles);
+}
+
+void printTable(const std::vector<Point>& points, double etaMax) {
+  std::printf("\n|eta| < %g: time per event in ms (local exponent)\n%9s %6s", etaMax, "particles", "events");
+  for (auto name : stageNames)
+    std::printf(" %20s", name);
+  std::printf(" %20s %12s %12s %12s\n", "total", "distances", "edges", "nodes");
+  for (unsigned int i = 0; i < points.size(); ++i) {
+    const Point& p = points[i];
+    std::printf("%9u %6u", p.particles, p.events);
+    for (int s = 0; s <= static_cast<int>(kNumStages); ++s) {
+      int stage = (s < static_cast<int>(kNumStages)) ? s : -1;
+      double t = (stage < 0) ? p.total() : p.ms[stage];
+      if (i == 0)
+        std::printf(" %12.3f %7s", t, "");
+      else
+        std::printf(" %12.3f (%5.2f)", t, localExponent(points[i - 1], p, stage));
+    }
+    std::printf(" %12.0f %12.0f %12.0f\n", p.distances, p.edges, p.historyNodes);
+  }
+  std::printf("%16s", "fitted exponent");
+  for (int s = 0; s <= static_cast<int>(kNumStages); ++s)
+    std::printf(" %12.2f %7s", fitExponent(points, (s < static_cast<int>(kNumStages)) ? s : -1), "");
+  std::printf("\n");
+  if (AllocTracker::isEnabled()) {
+    std::printf("peak extra memory per stage in MB\n%9s %6s", "particles", "");
+    for (auto name : stageNames)
+      std::printf(" %20s", name);
+    std::printf("\n");
+    for (const auto& p : points) {
+      std::printf("%9u %6s", p.particles, "");
+      for (auto bytes : p.peakBytes)
+        std::printf(" %20.3f", bytes / 1048576.);
+      std::printf("\n");
+    }
+  } else
+    std::printf("process maxrss after the largest events: %ld kB (build with -Dpapas_alloc_tracking=ON for the "
+                "peak memory of each stage)\n",
+                points.back().maxRssKb.back());
+}
+
+void writeCsv(FILE* file, const std::vector<Point>& points, double etaMax) {
+  for (const auto& p : points) {
+    for (unsigned int s = 0; s <= kNumStages; ++s) {
+      bool total = (s == kNumStages);
+      std::fprintf(file, "%g,%u,%u,%s,%.6g,%lld,%ld,%.0f,%.0f,%.0f\n", etaMax, p.particles, p.events,
+                   total ? "total" : stageNames[s], total ? p.total() : p.ms[s],
+                   (AllocTracker::isEnabled() && !total) ? (long long)p.peakBytes[s] : -1LL,
+                   total ? p.maxRssKb.back() : p.maxRssKb[s], p.distances, p.edges, p.historyNodes);
+    }
+  }
+  std::fflush(file);
+}
+
+int usage() {
+  std::cerr << "Usage: ./papasscaling [maxParticles (100000)] [result.csv (scaling.csv)] [etaMax values (2.5,1)] "
+               "[seconds per density (300)]"
+            << std::endl;
+  return 1;
+}
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 5) return usage();
+  unsigned int maxParticles = (argc > 1) ? std::atoi(argv[1]) : 100000;
+  std::string csvName = (argc > 2) ? argv[2] : "scaling.csv";
+  std::vector<double> etaMaxs;
+  std::stringstream etaList((argc > 3) ? argv[3] : "2.5,1");
+  std::string eta;
+  while (std::getline(etaList, eta, ','))
+    etaMaxs.push_back(std::atof(eta.c_str()));
+  double budget = (argc > 4) ? std::atof(argv[4]) : 300.;
+  if (maxParticles < 10 || etaMaxs.empty()) return usage();
+
+  try {
+    CMS CMSDetector;
+    FILE* csv = std::fopen(csvName.c_str(), "w");
+    if (csv == nullptr) throw std::string("unable to open " + csvName);
+    std::fprintf(csv, "eta_max,particles,events,stage,ms_per_event,peak_bytes,maxrss_kb,distance_evaluations,"
+                      "edges_created,history_nodes\n");
+    for (double etaMax : etaMaxs) {
+      std::vector<Point> points;
+      double elapsed = 0;
+      // multiplicities 10, 30, 100, 300 ... up to maxParticles
+      for (unsigned int n = 10, step = 0; n <= maxParticles; n = (step % 2) ? n * 10 / 3 : n * 3, ++step) {
+        if (elapsed > budget) {
+          std::printf("|eta| < %g: stopped before %u particles, time budget of %g s used\n", etaMax, n, budget);
+          break;
+        }
+        unsigned int nEvents = std::max(1u, std::min(20u, 20000 / n));
+        auto start = std::chrono::steady_clock::now();
+        points.push_back(measure(CMSDetector, n, nEvents, etaMax));
+        elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        writeCsv(csv, {points.back()}, etaMax);
+      }
+      printTable(points, etaMax);
+    }
+    std::fclose(csv);
+    std::printf("\nresults written to %s\n", csvName.c_str());
+  } catch (std::runtime_error& err) {
+    std::cerr << err.what() << ". Quitting." << std::endl;
+    return 1;
+  } catch (const char* c) {
+    std::cerr << c << ". Quitting." << std::endl;
+    return 1;
+  } catch (const std::string& s) {
+    std::cerr << s << ". Quitting." << std::endl;
+    return 1;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+//
+//  papas_trace.cpp
+//
+//  Tool for binary physics debug traces written with PDebug::BinaryFile
+//   render: writes the trace as the text that PDebug::File would have produced
+//   diff: compares two traces record by record (identifiers exactly, energies etc within a relative tolerance)
+//   summary: counts the records of each kind
+//
+#include "papas/utility/PTraceReader.h"
+
+// STL
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace papas;
+
+int usage() {
+  std::cerr << "Usage: ./papastrace render trace [textfile]" << std::endl
+            << "       ./papastrace diff trace1 trace2 [tolerance] [maxReported]" << std::endl
+            << "       ./papastrace summary trace" << std::endl;
+  return 1;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) return usage();
+  std::string command = argv[1];
+  try {
+    if (command == "render" && argc <= 4) {
+      std::ofstream file;
+      if (argc == 4) file.open(argv[3]);
+      std::ostream& out = (argc == 4) ? file : std::cout;
+      PTraceReader reader(argv[2]);
+      PTraceRecord record;
+      while (reader.next(record))
+        out << PTraceReader::render(record) << "\n";
+    } else if (command == "diff" && argc >= 4 && argc <= 6) {
+      double tolerance = (argc > 4) ? std::atof(argv[4]) : 0.;
+      std::size_t maxReported = (argc > 5) ? std::atoi(argv[5]) : 10;
+      auto ndiffs = PTraceReader::diff(argv[2], argv[3], std::cout, tolerance, maxReported);
+      std::cout << ndiffs << " records differ" << std::endl;
+      return ndiffs ? 2 : 0;
+    } else if (command == "summary" && argc == 3) {
+      PTraceReader reader(argv[2]);
+      PTraceRecord record;
+      std::array<std::size_t, PTrace::kReconstructed + 1> counts{};
+      while (reader.next(record))
+        if (record.kind <= PTrace::kReconstructed) counts[record.kind]++;
+      std::cout << "records: " << reader.numRecords() << std::endl;
+      for (unsigned k = 0; k < counts.size(); ++k)
+        std::cout << PTraceReader::kindName(static_cast<PTrace::RecordKind>(k)) << ": " << counts[k] << std::endl;
+    } else
+      return usage();
+  } catch (const std::string& s) {
+    std::cerr << s << ". Quitting." << std::endl;
+    return 1;
+  }
+  return EXIT_SUCCESS;
+}
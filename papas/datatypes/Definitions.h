@@ -1,15 +1,49 @@
 #ifndef Definitions_h
 #define Definitions_h
 
+#include <cstddef>
+#include <functional>
 #include <inttypes.h>
 
+/** Number of bits of an Identifier that hold the index of the object in its collection (see IdCoder).
+ The default of 21 allows 2097151 objects per collection. It may be raised up to 31 (cmake -Dpapas_id_index_bits=N)
+ for very high multiplicity events, at the cost of the precision of the value encoded in the identifier.
+ */
+#ifndef PAPAS_ID_INDEX_BITS
+#define PAPAS_ID_INDEX_BITS 21
+#endif
+
 namespace papas {
 typedef uint64_t Identifier;
 
+#if PAPAS_ID_INDEX_BITS > 21
+/// Key of an edge, see Edge::makeKey. The unique ids of the two ends do not fit into 32 bits so each is kept whole
+struct EdgeKey {
+  uint64_t uid1;  ///< unique id of the end with the larger identifier
+  uint64_t uid2;  ///< unique id of the end with the smaller identifier
+  bool operator==(const EdgeKey& other) const { return uid1 == other.uid1 && uid2 == other.uid2; }
+  bool operator!=(const EdgeKey& other) const { return !(*this == other); }
+  bool operator<(const EdgeKey& other) const { return uid1 < other.uid1 || (uid1 == other.uid1 && uid2 < other.uid2); }
+};
+#else
+typedef uint64_t EdgeKey;  ///< Key of an edge, see Edge::makeKey. Holds the 32 bit unique ids of the two ends
+#endif
+
 /// describe position of a Cluster within the Detector
 enum Position { kVertex, kEcalIn, kEcalOut, kEcalDecay, kHcalIn, kHcalOut };
 /// Detector layers
 enum Layer { kNone, kTracker, kEcal, kHcal, kField };
 }
 
+#if PAPAS_ID_INDEX_BITS > 21
+namespace std {
+template <>
+struct hash<papas::EdgeKey> {
+  size_t operator()(const papas::EdgeKey& key) const {
+    return hash<uint64_t>()((key.uid1 * 0x9E3779B97F4A7C15ull) ^ key.uid2);
+  }
+};
+}
+#endif
+
 #endif /* Definitions_h */
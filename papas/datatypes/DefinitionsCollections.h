@@ -5,10 +5,9 @@
 
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 #if WITHSORT
 #include <set>
-#else
-#include <unordered_set>
 #endif
 
 namespace papas {
@@ -19,7 +18,8 @@ class Edge;
 class Particle;
 
 typedef std::list<Particle> ListParticles;         ///< list of Particles
-typedef std::unordered_map<uint64_t, Edge> Edges;  ///< collection of Edge objects
+typedef std::unordered_map<EdgeKey, Edge> Edges;  ///< collection of Edge objects
+typedef std::unordered_set<EdgeKey> EdgeKeys;     ///< collection of Edge keys
 #if WITHSORT
 typedef std::set<Identifier, std::greater<Identifier>> Ids;  ///< set containing Identifiers
 #else
@@ -9,10 +9,21 @@
 #include "papas/graphtools/DefinitionsNodes.h"
 #include "papas/reconstruction/PFBlock.h"
 
+#include <array>
 #include <memory>
 #include <string>
 #include <unordered_map>
 
+/// When set to 1 each collection added to the Event is checked to make sure all its identifiers have the same type
+/// and subtype. The check visits every element so by default it is only made in debug (non NDEBUG) builds.
+#ifndef PAPAS_CHECK_COLLECTIONS
+#ifdef NDEBUG
+#define PAPAS_CHECK_COLLECTIONS 0
+#else
+#define PAPAS_CHECK_COLLECTIONS 1
+#endif
+#endif
+
 namespace papas {
 
 class Cluster;
@@ -24,9 +35,10 @@ class Cluster;
  *
  *  The Event is a lightweight obejct that can be used from Papas Standalone or from
  *  Gaudi modules.
- *    The collections stored in the Event are unordered_maps of unordered_maps eg an unordered map of Clusters.
- *    The collections are indexed by the typeAndSubtype of the identifiers of each item
- *    (eg of each Cluster in Clusters).
+ *    The collections stored in the Event are unordered_maps eg an unordered map of Clusters.
+ *    Pointers to the collections are held in a fixed size array indexed by the packed typeAndSubtype key
+ *    (see IdCoder::typeAndSubtypeKey) of the identifiers of each item (eg of each Cluster in Clusters), so
+ *    finding the collection for an identifier is a single array lookup.
  *       Therefore each collection to be stored must contain only one typeAndSubtype
 *       @code
  *       Examples of typeAndSubtype are:
@@ -218,6 +230,13 @@ public:
    *   @brief  resets everything, deletes all the clusters, tracks etc etc
    */
   void clear();
+  /**
+   *   @brief  removes a collection from the Event (the collection itself is not deleted), does nothing if there is
+   *           no such collection. The history of its objects is kept.
+   *   @param[in]  type The type of a collection eg IdCoder::kEcalCluster
+   *   @param[in]  subtype The subtype of a collection eg 't' for true
+   */
+  void removeCollection(IdCoder::ItemType type, IdCoder::SubType subtype);
   void setEventNo(unsigned int eventNo) { m_eventNo = eventNo; }
   unsigned int eventNo() const { return m_eventNo; }
 
@@ -238,23 +257,27 @@ private:
   /**
    *   @brief  templated class method used by the AddCollection methods to check that typeAndSubype match and that
    *           this collection type does not already exist. It then adds the collection into the Event.
-   *   @param [in] collection The collection that is to be added in
-   *   @param [inout] folder The folder to which the collection will be added
+   *   @param [in] collection The collection that is to be added in
+   *   @param [in] typeMask bit mask of the IdCoder::ItemType values (1 << type) allowed for this kind of collection
+   */
+  template <class T>
+  void addCollectionToFolderInternal(const std::unordered_map<Identifier, T>& collection, uint32_t typeMask);
+
+  /**
+   *   @brief  returns the collection stored for this type and subtype or nullptr if there is none.
+   *           The caller is responsible for asking for the collection type (T) that matches the item type
+   *   @param[in]  type The type of an object eg IdCoder::kEcalCluster
+   *   @param[in]  subtype The subtype of an object eg 'm' for merged
    */
   template <class T>
-  void
-  addCollectionToFolderInternal(const std::unordered_map<Identifier, T>& collection,
-                                std::unordered_map<IdCoder::SubType, const std::unordered_map<Identifier, T>*>& folder);
-  /// Unordered map of pointers to unordered map of (concrete) Ecal Clusters
-  ClustersFolder m_ecalClustersFolder;
-  /// Unordered map of pointers to unordered map of (concrete) Hcal Clusters
-  ClustersFolder m_hcalClustersFolder;
-  /// Unordered map of pointers to unordered map of (concrete) Tracks
-  TracksFolder m_tracksFolder;
-  /// Unordered map of pointers to unordered map of (concrete) Particles
-  ParticlesFolder m_particlesFolder;
-  /// Unordered map of pointers to unordered map of (concrete) Blocks
-  BlocksFolder m_blocksFolder;
+  const std::unordered_map<Identifier, T>* folder(IdCoder::ItemType type, IdCoder::SubType subtype) const {
+    return static_cast<const std::unordered_map<Identifier, T>*>(
+        m_folders[IdCoder::typeAndSubtypeKey(type, subtype)]);
+  }
+
+  /// Pointers to the (concrete) collections of Clusters, Tracks, Particles and Blocks indexed by typeAndSubtypeKey.
+  /// The item type part of the key determines the collection type that is pointed to.
+  std::array<const void*, IdCoder::kTypeAndSubtypeKeys> m_folders;
   Nodes& m_history;            ///< points to the merged history (built from the sucessive histories)
   Clusters m_emptyClusters;    ///<Used to return an empty collection when no collection is found
   Tracks m_emptyTracks;        ///<Used to return an empty collection when no collection is found
@@ -264,19 +287,21 @@ private:
 };
 
 template <class T>
-void Event::addCollectionToFolderInternal(
-    const std::unordered_map<Identifier, T>& collection,
-    std::unordered_map<IdCoder::SubType, const std::unordered_map<Identifier, T>*>& folder) {
+void Event::addCollectionToFolderInternal(const std::unordered_map<Identifier, T>& collection, uint32_t typeMask) {
   if (collection.size() == 0) return;
   Identifier firstId = collection.begin()->first;
-  if (hasCollection(firstId)) throw "Collection already exists";
+  if (((1u << IdCoder::type(firstId)) & typeMask) == 0) throw "Collection type does not match identifier type";
+  auto key = IdCoder::typeAndSubtypeKey(firstId);
+  if (m_folders[key] != nullptr) throw "Collection already exists";
+#if PAPAS_CHECK_COLLECTIONS
   for (const auto& it : collection) {
-    if (IdCoder::typeAndSubtype(it.first) != IdCoder::typeAndSubtype(firstId)) {
+    if (IdCoder::typeAndSubtypeKey(it.first) != key) {
       std::cout << IdCoder::pretty(it.first) << " : " << IdCoder::pretty(firstId) << std::endl;
       throw "more than one typeandSubtype found in collection";
     }
   }
-  folder.emplace(IdCoder::subtype(firstId), &collection);
+#endif
+  m_folders[key] = &collection;
 }
 
 template <class T>
@@ -44,6 +44,12 @@ public:
    @param phi angle
    */
   TVector3 pointAtPhi(double phi) const;
+  /** Finds where the helix crosses a cylinder (loopers are taken to the cylinder end cap)
+   @param[in] cyl the cylinder
+   @param[out] point the crossing point
+   @return false if the helix does not reach the cylinder
+   */
+  bool intersect(const SurfaceCylinder& cyl, TVector3& point) const override;
   const TVector3& extremePointXY() const { return m_extremePointXY; }
   const TVector3& centerXY() const { return m_centerXY; }
   double maxTime() const;
@@ -3,6 +3,7 @@
 
 #include "papas/datatypes/DefinitionsCollections.h"
 #include "papas/datatypes/IdCoder.h"
+#include "papas/graphtools/DefinitionsNodes.h"
 #include "papas/graphtools/DirectedAcyclicGraph.h"
 
 namespace papas {
@@ -34,7 +35,8 @@ public:
   */
   HistoryHelper(const Event& event);
   /**
-   *   @brief Finds all ids which have a history link with the input id
+   *   @brief Finds all ids which have a history link with the input id. The ids are returned in a new set, use
+   *   visitLinkedIds where this allocation matters.
    *   @param[in] id identifier for which we want to find connected items
    *   @param[in] direction whether to search parents, children or both
    */
@@ -48,6 +50,18 @@ public:
    */
   Ids linkedIds(Identifier id, const std::string& typeAndSubType,
                 DAG::enumVisitType direction = DAG::enumVisitType::UNDIRECTED) const;
+  /**
+   *   @brief Calls a function for each id which has a history link with the input id (including the id itself), in
+   *   breadth first order. Does not allocate, so it is the cheapest way to ask a question of the history.
+   *   @param[in] id identifier for which we want to find connected items
+   *   @param[in] direction whether to search parents, children or both
+   *   @param[in] callback bool callback(Identifier linkedId), returns false to stop the search
+   *   @return false if the callback stopped the search
+   */
+  template <typename F>
+  bool visitLinkedIds(Identifier id, DAG::enumVisitType direction, F&& callback) const {
+    return m_bfs.traverse(node(id), direction, [&callback](const PFNode* node) { return callback(node->value()); });
+  }
   /**
    *   @brief  Filters a vector of ids to find a subset which have the required type and subtype
    *         for example could be used to identify all ids which are merged Ecal clusters.
@@ -65,7 +79,11 @@ public:
   Ids filteredIds(Ids ids, const std::string& typeAndSubtype) const;
 
 private:
-  const Event& m_event;  ///< Contains pointers to data collections and to history
+  const PFNode& node(Identifier id) const;  ///< history node of this id
+  const Event& m_event;                     ///< Contains pointers to data collections and to history
+  /// reused for every search, so a HistoryHelper must only be used by one thread at a time (the history itself is
+  /// not modified by a search, so each thread can have its own HistoryHelper for the same Event)
+  mutable DAG::BFSTraverser<PFNode> m_bfs;
 };
 }
 
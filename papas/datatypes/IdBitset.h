@@ -0,0 +1,67 @@
+#ifndef IdBitset_h
+#define IdBitset_h
+
+#include "papas/datatypes/IdCoder.h"
+
+#include <array>
+#include <vector>
+
+namespace papas {
+
+/**
+ *  @brief A dense set of flags, one per Identifier, stored as bits.
+ *
+ *  The bit for an identifier is found from its type and subtype (which selects a bitmap) and its index
+ *  (which selects the bit within that bitmap). Because identifiers of a collection have consecutive indices the
+ *  bitmaps are compact and test/set/reset are a couple of array lookups rather than a hash table access.
+ *  clear() resets all the flags in O(number of words) and keeps the memory for reuse.
+ *
+ *  An IdBitset is not thread safe for writing, but because it is cheap to create, separate IdBitsets can be used
+ *  eg per block or per thread when blocks are reconstructed in parallel.
+ *
+ *  Usage example:
+ *  @code
+ *   IdBitset locked;
+ *   locked.set(id);
+ *   if (locked.test(id)) ...
+ *   locked.clear();
+ *  @endcode
+ */
+class IdBitset {
+public:
+  IdBitset();
+  /// returns true if the flag for this identifier is set
+  bool test(Identifier id) const {
+    auto slot = m_slots[IdCoder::typeAndSubtypeKey(id)];
+    if (slot == 0) return false;
+    const auto& words = m_words[slot - 1];
+    auto index = IdCoder::index(id);
+    return (index >> 6) < words.size() && (words[index >> 6] >> (index & 63)) & 1;
+  }
+  /// sets the flag for this identifier
+  void set(Identifier id) {
+    auto index = IdCoder::index(id);
+    words(id, index)[index >> 6] |= (uint64_t(1) << (index & 63));
+  }
+  /// resets the flag for this identifier
+  void reset(Identifier id) {
+    auto slot = m_slots[IdCoder::typeAndSubtypeKey(id)];
+    if (slot == 0) return;
+    auto& words = m_words[slot - 1];
+    auto index = IdCoder::index(id);
+    if ((index >> 6) < words.size()) words[index >> 6] &= ~(uint64_t(1) << (index & 63));
+  }
+  void clear();                ///< resets all flags, the memory is kept for reuse
+  std::size_t count() const;   ///< number of flags that are set
+  bool empty() const;          ///< true if no flags are set
+
+private:
+  /// returns the bitmap for this identifier's type and subtype, making sure that it is big enough for index
+  std::vector<uint64_t>& words(Identifier id, uint32_t index);
+  std::array<uint8_t, IdCoder::kTypeAndSubtypeKeys> m_slots;  ///< 1 + position in m_words for each typeAndSubtypeKey
+  std::vector<std::vector<uint64_t>> m_words;                 ///< one bitmap per type and subtype in use
+};
+
+}  // end namespace papas
+
+#endif /* IdBitset_h */
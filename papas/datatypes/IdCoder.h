@@ -23,9 +23,13 @@ namespace papas {
  The identifier is 64 bits wide and stores info as follows
  from left: bits 64 to 61 = PFOBJECTTYPE enumeration eg ECAL, HCAL, PARTICLE (max value = 7)
  bits 60 to 53 = subtype - a single char eg 'g'
- bits 52 to 20 = encoded float value eg energy
+ bits 52 to 22 = encoded float value eg energy
  bits 21 to 1 = index (max value = 2097152 -1)
 
+ The width of the index can be raised to N bits (at most 31) with PAPAS_ID_INDEX_BITS (cmake -Dpapas_id_index_bits=N).
+ The value field then keeps only the 53 - N most significant bits of the float, so values that differ by less than
+ about 2^(N-21-23) relative may no longer be ordered, and unique ids become 64 bit.
+
  Note that sorting on id will result in sorting by:
  type
  subtype
@@ -49,6 +53,11 @@ public:
   /// @enum the type of the item eg Particle, Cluster etc
   enum ItemType { kNone = 0, kEcalCluster = 1, kHcalCluster, kTrack, kParticle, kBlock };
   typedef char SubType;
+#if PAPAS_ID_INDEX_BITS > 21
+  typedef uint64_t UniqueId;  ///< type, subtype and index of an identifier (see uniqueId)
+#else
+  typedef uint32_t UniqueId;  ///< type, subtype and index of an identifier (see uniqueId)
+#endif
   /** Makes new identifier.
    @param[in]  index to collection in which object will be stored
    @param[in]  type is an enum IdCoder::ItemType to say whether this id is for a cluster, particle etc
@@ -94,11 +103,30 @@ public:
 
   /** Takes an identifier and returns a unique id component of it (excludes value information)
    @param[in] id: identifier
-   @return the index   */
-  static uint32_t uniqueId(Identifier id);  ///< Returns encoded unique id
+   @return the unique id, 32 bits wide with the default identifier layout */
+  static UniqueId uniqueId(Identifier id);  ///< Returns encoded unique id
 
   static char typeLetter(Identifier id);  ///< One letter short code eg 'e' for ecal, 't' for track, 'x' for unknown
   static std::string typeAndSubtype(Identifier id);  ///< Two letter string of type and subtype eg "em"
+
+  /** Returns the type and subtype of the identifier packed into one small integer (the type in the upper 3 bits, the
+   subtype char in the lower 8 bits). It is a single shift of the identifier and can be used to index an array, or to
+   compare the type and subtype of two identifiers without building strings.
+   @param[in] id: identifier
+   @return packed type and subtype, always less than kTypeAndSubtypeKeys
+   */
+  static uint32_t typeAndSubtypeKey(Identifier id) { return (uint32_t)(id >> m_bitshift2); }
+
+  /** Returns the packed type and subtype, as would be returned by typeAndSubtypeKey(id) for an identifier of this
+   type and subtype.
+   @param[in] type: an enum IdCoder::ItemType eg kEcalCluster
+   @param[in] subtype: single letter subtype code eg 'm' for merged
+   @return packed type and subtype, always less than kTypeAndSubtypeKeys
+   */
+  static uint32_t typeAndSubtypeKey(ItemType type, SubType subtype) {
+    return ((uint32_t)type << (m_bitshift1 - m_bitshift2)) | (uint32_t) static_cast<unsigned char>(subtype);
+  }
+  static const uint32_t kTypeAndSubtypeKeys = 1 << 11;  ///< number of distinct packed type and subtype values
   static std::string pretty(Identifier id);  ///< Pretty string Id name eg "es101" for a smeared ecal with index 101;
   /** boolean test of whether identifier is from an ecal cluster
   @param ident: identifier
@@ -149,10 +177,13 @@ public:
 private:
   static const uint32_t m_bitshift1 = 61;  ///< encoding parameter
   static const uint32_t m_bitshift2 = 53;  ///< encoding parameter
-  static const uint32_t m_bitshift = 21;   ///< encoding parameter (max size of counter)
+  static const uint32_t m_bitshift = PAPAS_ID_INDEX_BITS;  ///< encoding parameter (max size of counter)
+  static_assert(m_bitshift >= 21 && m_bitshift <= 31, "PAPAS_ID_INDEX_BITS must be between 21 and 31");
+  /// number of low bits of the float that are dropped to make room for the index
+  static const uint32_t m_droppedValueBits = m_bitshift - 21;
   /// checks that the identifier can be correctly decoded
   static bool checkValid(Identifier id, ItemType type, char subt, float val, uint32_t uid);
-  static bool checkUIDValid(Identifier id, uint32_t uniqueid);
+  static bool checkUIDValid(Identifier id, UniqueId uniqueid);
   static uint64_t floatToBits(float value);  /// convert float into binary
   static float bitsToFloat(uint64_t bits);   /// convert binary into float
 };
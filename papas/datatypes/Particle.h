@@ -16,6 +16,10 @@ class Path;
 ///
 /// Contains 4-momentum vector, particle id and accessor functions
 /// Intended to be used as the base for derived Particle classes
+///
+/// The path is shared by copies of the particle. Its points at the detector cylinders may be computed lazily, the
+/// first time they are read, from cylinders owned by the Detector: the Detector must outlive the particle, and a
+/// particle (or a copy of it) must not be read from several threads at once.
 
 class Particle {
 public:
@@ -47,7 +51,7 @@ public:
   double mass() const { return m_tlv.M(); }   ///< mass
   int pdgId() const { return m_pdgId; }       ///< particle type (an integer value)
   double charge() const { return m_charge; }  ///< particle charge
-  bool status() const { return m_status; }    ///<status code, e.g. from generator. 1:stable.
+  double status() const { return m_status; }  ///<status code, e.g. from generator. 1:stable.
   const TVector3& startVertex() const { return m_startVertex; }  ///<start vertex (3d point)
   std::string info() const;                                      ///< text descriptor of the particle
   void setPath(std::shared_ptr<Path> path) { m_path = path; }    ///< set the Particle path
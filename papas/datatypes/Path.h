@@ -2,6 +2,7 @@
 #define path_h
 
 #include <map>
+#include <vector>
 
 #include "TLorentzVector.h"
 #include "TVector3.h"
@@ -9,12 +10,17 @@
 #include "papas/datatypes/Definitions.h"
 
 namespace papas {
+class SurfaceCylinder;
 
 /// @brief Path followed by a particle in 3D space.
 ///
 /// Assumes constant speed magnitude both along the z axis and in the transverse plane.
 /// Path base class is essentially a straightline but can be inherited from to make Helix etc
 ///
+/// Points where the path crosses a detector cylinder may be added lazily (addLazyPoint). They are only computed,
+/// from the path parameters, the first time they are asked for and are then stored like any other point.
+/// This memoisation is not thread safe: a path must not be read from several threads at once.
+///
 class Path {
 public:
   typedef std::map<papas::Position, TVector3> Points;  ///< Map of path points indexed by position
@@ -36,7 +42,19 @@ public:
    * @param layer for the new point which is used to index unordered map of points
    * @param vec new point to be added
   */
-  void addPoint(papas::Position layer, const TVector3& vec) { m_points[layer] = vec; }
+  void addPoint(papas::Position layer, const TVector3& vec);
+  /** Add a point that is computed only when it is first needed: the point where the path crosses a cylinder.
+   * If the path never crosses the cylinder no point is added. When several cylinders share a layer the last one
+   * added that the path crosses is used, as if each had been propagated to in turn.
+   * @param cyl cylinder whose layer indexes the point, it is not copied and must outlive the path
+   */
+  void addLazyPoint(const SurfaceCylinder& cyl) { m_lazyCylinders.push_back(&cyl); }
+  /** Finds where the path crosses a cylinder
+   * @param[in] cyl the cylinder
+   * @param[out] point the crossing point
+   * @return false if the path does not reach the cylinder
+   */
+  virtual bool intersect(const SurfaceCylinder& cyl, TVector3& point) const;
   /** Time when particle gets to point z on z axis
    * @param z position on z axis
   */
@@ -65,16 +83,25 @@ public:
    @return the 3d location of the particle along the path at time
    */
   virtual TVector3 pointAtTime(double time) const;
-  const Points& points() const { return m_points; }  ///< Returns all path points
-  double field() const { return m_field; }           ///< Returns magnetic field for Helix (or 0 for straighline)
+  /// Returns all path points (computing any lazy points first)
+  const Points& points() const {
+    if (!m_lazyCylinders.empty()) computeLazyPoints();
+    return m_points;
+  }
+  double field() const { return m_field; }  ///< Returns magnetic field for Helix (or 0 for straighline)
 
 protected:
   TLorentzVector m_p4;       ///< 4-momentum
   TVector3 m_unitDirection;  ///< unit direction of velocity (3d)
   double m_speed;            ///< Speed magnitude
   TVector3 m_origin;         ///< start vertex (3d)
-  Points m_points;           ///< Map of path points indexed by position
+  mutable Points m_points;    ///< Map of path points indexed by position
   double m_field;            ///< Magnetic field which is set to 0 for a straightline
+  mutable std::vector<const SurfaceCylinder*> m_lazyCylinders;  ///< cylinders whose points are not yet computed
+
+private:
+  void computeLazyPoints(papas::Position layer) const;  ///< computes the lazy point for one layer
+  void computeLazyPoints() const;                       ///< computes all lazy points
 };
 
 /// Alternative name for Path class
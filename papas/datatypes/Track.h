@@ -17,6 +17,10 @@ attributes:
  - charge : particle charge
  - path : contains the trajectory parameters and points
 
+The path is shared by copies of the track. Its points at the detector cylinders may be computed lazily, the first
+time they are read, from cylinders owned by the Detector: the Detector must outlive the track, and a track (or a copy
+of it) must not be read from several threads at once.
+
 */
 class Track {
 public:
@@ -10,42 +10,31 @@ namespace papas {
 /// Event holds pointers to collections of particles, clusters etc and the address of the history associated with
 /// an event
 
-Event::Event(Nodes& hist)
-    : m_ecalClustersFolder(),
-      m_hcalClustersFolder(),
-      m_tracksFolder(),
-      m_particlesFolder(),
-      m_blocksFolder(),
-      m_history(hist){};
+Event::Event(Nodes& hist) : m_folders(), m_history(hist) { m_folders.fill(nullptr); };
 
 void Event::addCollectionToFolder(const Clusters& clusters) {
-  // decide if the clusters are from Ecal or Hcal and add to appropriate collection
-  if (clusters.size() == 0) return;
-  if (IdCoder::isEcal(clusters.begin()->first))
-    addCollectionToFolderInternal<Cluster>(clusters, m_ecalClustersFolder);
-  else
-    addCollectionToFolderInternal<Cluster>(clusters, m_hcalClustersFolder);
+  // Ecal and Hcal clusters are held in separate slots, the slot is decided by the type of the identifiers
+  addCollectionToFolderInternal<Cluster>(clusters,
+                                         (1u << IdCoder::kEcalCluster) | (1u << IdCoder::kHcalCluster));
 }
 
 void Event::addCollectionToFolder(const Tracks& tracks) {
-  addCollectionToFolderInternal<Track>(tracks, m_tracksFolder);
+  addCollectionToFolderInternal<Track>(tracks, 1u << IdCoder::kTrack);
 };
 
 void Event::addCollectionToFolder(const Particles& particles) {
-  addCollectionToFolderInternal<Particle>(particles, m_particlesFolder);
+  addCollectionToFolderInternal<Particle>(particles, 1u << IdCoder::kParticle);
 };
 
 void Event::addCollectionToFolder(const Blocks& blocks) {
-  addCollectionToFolderInternal<PFBlock>(blocks, m_blocksFolder);
+  addCollectionToFolderInternal<PFBlock>(blocks, 1u << IdCoder::kBlock);
 };
 
 const Clusters& Event::clusters(IdCoder::ItemType type, const IdCoder::SubType subtype) const {
   // return the corresponding collection
-  if (!hasCollection(type, subtype)) return m_emptyClusters;
-  if (type == IdCoder::ItemType::kEcalCluster)
-    return *(m_ecalClustersFolder.at(subtype));
-  else
-    return *(m_hcalClustersFolder.at(subtype));
+  if (type != IdCoder::kEcalCluster && type != IdCoder::kHcalCluster) return m_emptyClusters;
+  auto found = folder<Cluster>(type, subtype);
+  return found ? *found : m_emptyClusters;
 };
 
 const Clusters& Event::clusters(Identifier id) const {
@@ -87,46 +76,26 @@ Ids Event::collectionIds(const std::string& typeAndSubtype) const {
 }
 
 const Tracks& Event::tracks(const IdCoder::SubType subtype) const {
-  if (!hasCollection(IdCoder::ItemType::kTrack, subtype)) return m_emptyTracks;
-  return *m_tracksFolder.at(subtype);
+  auto found = folder<Track>(IdCoder::kTrack, subtype);
+  return found ? *found : m_emptyTracks;
 }
 
 const Particles& Event::particles(const IdCoder::SubType subtype) const {
-  if (!hasCollection(IdCoder::ItemType::kParticle, subtype)) return m_emptyParticles;
-  return *m_particlesFolder.at(subtype);
+  auto found = folder<Particle>(IdCoder::kParticle, subtype);
+  return found ? *found : m_emptyParticles;
 }
 
 const Blocks& Event::blocks(const IdCoder::SubType subtype) const {
-  if (!hasCollection(IdCoder::ItemType::kBlock, subtype)) return m_emptyBlocks;
-  return *m_blocksFolder.at(subtype);
+  auto found = folder<PFBlock>(IdCoder::kBlock, subtype);
+  return found ? *found : m_emptyBlocks;
 }
 
 bool Event::hasCollection(IdCoder::ItemType type, const IdCoder::SubType subtype) const {
   // Check if this collection is present
-  bool found = false;
-  switch (type) {
-  case IdCoder::kEcalCluster:
-    found = (m_ecalClustersFolder.find(subtype) != m_ecalClustersFolder.end());
-    break;
-  case IdCoder::kHcalCluster:
-    found = (m_hcalClustersFolder.find(subtype) != m_hcalClustersFolder.end());
-    break;
-  case IdCoder::kTrack:
-    found = (m_tracksFolder.find(subtype) != m_tracksFolder.end());
-    break;
-  case IdCoder::kBlock:
-    found = (m_blocksFolder.find(subtype) != m_blocksFolder.end());
-    break;
-  case IdCoder::kParticle:
-    found = (m_particlesFolder.find(subtype) != m_particlesFolder.end());
-    break;
-  default:
-    break;
-  }
-  return found;
+  return m_folders[IdCoder::typeAndSubtypeKey(type, subtype)] != nullptr;
 };
 
-bool Event::hasCollection(Identifier id) const { return hasCollection(IdCoder::type(id), IdCoder::subtype(id)); };
+bool Event::hasCollection(Identifier id) const { return m_folders[IdCoder::typeAndSubtypeKey(id)] != nullptr; };
 
 bool Event::hasObject(Identifier id) const {
   // check if this object id is present
@@ -157,45 +126,55 @@ bool Event::hasObject(Identifier id) const {
 void Event::extendHistory(const Nodes& history) {
   // A separate history is created at each stage.
   // the following adds this history into the papasevent history
+  // the stages have already chosen which links to record, so they are all copied
   for (const auto& node : history) {
     for (const auto& c : node.second.children()) {
-      makeHistoryLink(node.first, c->value(), m_history);
+      addHistoryLink(node.first, c->value(), m_history);
     }
   }
 }
 
 void Event::clear() {
-  m_ecalClustersFolder.clear();
-  m_hcalClustersFolder.clear();
-  m_tracksFolder.clear();
-  m_particlesFolder.clear();
-  m_blocksFolder.clear();
+  m_folders.fill(nullptr);
   m_history.clear();
 }
 
+void Event::removeCollection(IdCoder::ItemType type, IdCoder::SubType subtype) {
+  m_folders[IdCoder::typeAndSubtypeKey(type, subtype)] = nullptr;
+}
+
 std::string Event::info() const {
   fmt::MemoryWriter out;
   out.write("Papas::Event: {}\n", m_eventNo);
   out.write("\thistory = {}", m_history.size());
-  out.write("\n\tecals =");
-  for (auto c : m_ecalClustersFolder) {
-    out.write(" {}({}) +", c.first, c.second->size());
-  }
-  out.write("\n\thcals =");
-  for (auto c : m_hcalClustersFolder) {
-    out.write(" {}({}) +", c.first, c.second->size());
-  }
-  out.write("\n\ttracks =");
-  for (auto c : m_tracksFolder) {
-    out.write(" {}({}) +", c.first, c.second->size());
-  }
-  out.write("\n\tblocks =");
-  for (auto c : m_blocksFolder) {
-    out.write(" {}({}) +", c.first, c.second->size());
-  }
-  out.write("\n\tparticles =");
-  for (auto c : m_particlesFolder) {
-    out.write(" {}({}) +", c.first, c.second->size());
+  const std::array<std::pair<const char*, IdCoder::ItemType>, 5> folders{{{"ecals", IdCoder::kEcalCluster},
+                                                                           {"hcals", IdCoder::kHcalCluster},
+                                                                           {"tracks", IdCoder::kTrack},
+                                                                           {"blocks", IdCoder::kBlock},
+                                                                           {"particles", IdCoder::kParticle}}};
+  for (const auto& f : folders) {
+    out.write("\n\t{} =", f.first);
+    for (unsigned s = 0; s < 256; ++s) {
+      auto subtype = static_cast<IdCoder::SubType>(s);
+      if (!hasCollection(f.second, subtype)) continue;
+      std::size_t size = 0;
+      switch (f.second) {
+      case IdCoder::kEcalCluster:
+      case IdCoder::kHcalCluster:
+        size = clusters(f.second, subtype).size();
+        break;
+      case IdCoder::kTrack:
+        size = tracks(subtype).size();
+        break;
+      case IdCoder::kBlock:
+        size = blocks(subtype).size();
+        break;
+      default:
+        size = particles(subtype).size();
+        break;
+      }
+      out.write(" {}({}) +", subtype, size);
+    }
   }
   out.write("\n");
   return out.str();
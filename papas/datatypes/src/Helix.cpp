@@ -2,7 +2,9 @@
 
 #include <array>
 
+#include "papas/detectors/SurfaceCylinder.h"
 #include "papas/utility/DeltaR.h"
+#include "papas/utility/GeoTools.h"
 
 namespace papas {
 extern double gconstc;
@@ -70,6 +72,30 @@ TVector3 Helix::pointAtPhi(double phi) const {
   return pointAtTime(time);
 }
 
+bool Helix::intersect(const SurfaceCylinder& cyl, TVector3& point) const {
+  bool is_looper = m_extremePointXY.Mag() < cyl.radius();
+  double udir_z = m_unitDirection.Z();
+  if (!is_looper) {
+    try {
+      auto intersect = circleIntersection(m_centerXY.X(), m_centerXY.Y(), m_rho, cyl.radius());
+      double phi_m = phi(intersect[0].first, intersect[0].second);
+      double phi_p = phi(intersect[1].first, intersect[1].second);
+      point = pointAtPhi(phi_p);
+      if (point.Z() * udir_z < 0.) {
+        point = pointAtPhi(phi_m);
+      }
+      if (fabs(point.Z()) < cyl.z()) return true;
+    } catch (std::string s) {
+      return false;
+    }
+  }
+  // looper, or the helix leaves through the end cap
+  double destz = cyl.z();
+  if (udir_z < 0.) destz = -destz;
+  point = pointAtZ(destz);
+  return true;
+}
+
 double Helix::maxTime() const {
   double maxz = 0;
   double minz = 0;
@@ -77,7 +103,7 @@ double Helix::maxTime() const {
   if (hasNamedPoint(kHcalIn)) {
     return timeAtZ(namedPoint(kHcalIn).Z());
   }
-  for (const auto& p : m_points) {
+  for (const auto& p : points()) {
     if (p.second.Z() > 0)
       maxz = fmax(maxz, p.second.Z());
     else
@@ -6,21 +6,26 @@ namespace papas {
 
 HistoryHelper::HistoryHelper(const Event& event) : m_event(event) {}
 
+const PFNode& HistoryHelper::node(Identifier id) const { return m_event.history().at(id); }
+
 Ids HistoryHelper::linkedIds(Identifier id, DAG::enumVisitType direction) const {
-  const auto& history = m_event.history();
-  const auto& startnode = history.at(id);
-  DAG::BFSRecurseVisitor<PFNode> bfs;
-  const auto& nodes = bfs.traverseNodes(startnode, direction);
   Ids ids;
-  for (const auto& node : nodes) {
-    ids.insert(node->value());
-  }
+  visitLinkedIds(id, direction, [&ids](Identifier linkedId) {
+    ids.insert(linkedId);
+    return true;
+  });
   return ids;
 }
 
 Ids HistoryHelper::linkedIds(Identifier id, const std::string& typeAndSubtype, DAG::enumVisitType direction) const {
-  auto ids = linkedIds(id, direction);
-  auto fids = filteredIds(ids, typeAndSubtype);
+  // filter as we go rather than collecting everything that is linked
+  Ids fids;
+  if (typeAndSubtype.size() != 2) return fids;
+  visitLinkedIds(id, direction, [&fids, &typeAndSubtype](Identifier linkedId) {
+    if (IdCoder::typeLetter(linkedId) == typeAndSubtype[0] && IdCoder::subtype(linkedId) == typeAndSubtype[1])
+      fids.insert(linkedId);
+    return true;
+  });
   return fids;
 }
 
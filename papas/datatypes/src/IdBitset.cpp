@@ -0,0 +1,42 @@
+#include "papas/datatypes/IdBitset.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace papas {
+
+IdBitset::IdBitset() : m_slots(), m_words() { m_slots.fill(0); }
+
+std::vector<uint64_t>& IdBitset::words(Identifier id, uint32_t index) {
+  auto& slot = m_slots[IdCoder::typeAndSubtypeKey(id)];
+  if (slot == 0) {
+    if (m_words.size() == 255) throw "IdBitset: too many different types and subtypes";
+    m_words.emplace_back();
+    slot = m_words.size();
+  }
+  auto& words = m_words[slot - 1];
+  if ((index >> 6) >= words.size()) words.resize((index >> 6) + 1, 0);
+  return words;
+}
+
+void IdBitset::clear() {
+  for (auto& words : m_words)
+    std::fill(words.begin(), words.end(), 0);
+}
+
+std::size_t IdBitset::count() const {
+  std::size_t count = 0;
+  for (const auto& words : m_words)
+    for (auto w : words)
+      count += std::bitset<64>(w).count();
+  return count;
+}
+
+bool IdBitset::empty() const {
+  for (const auto& words : m_words)
+    for (auto w : words)
+      if (w) return false;
+  return true;
+}
+
+}  // end namespace papas
@@ -1,5 +1,6 @@
 #include "papas/datatypes/IdCoder.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <bitset>
 #include <cmath>
@@ -31,7 +32,8 @@ Identifier IdCoder::makeId(uint32_t index, ItemType type, char subt, float val)
   // if the m_bitshift is 32 or more the shift is undefined and can return 0
 
   Identifier typeShift = (uint64_t)type << m_bitshift1;
-  Identifier valueShift = (uint64_t)floatToBits(val) << m_bitshift;
+  // with a wider index only the most significant bits of the float are kept (so the ordering by value is kept)
+  Identifier valueShift = ((floatToBits(val) & 0xFFFFFFFFull) >> m_droppedValueBits) << m_bitshift;
   Identifier subtypeShift = (uint64_t) static_cast<int>(tolower(subt)) << m_bitshift2;
   Identifier uid = (uint64_t)subtypeShift | (uint64_t)valueShift | (uint64_t)typeShift | index;
 
@@ -49,21 +51,22 @@ char IdCoder::subtype(Identifier id) {
 
 float IdCoder::value(Identifier id) {
   // shift to extract the required bits
-  int bitvalue = id >> m_bitshift & (uint64_t)(pow(2, m_bitshift2 - m_bitshift) - 1);
+  uint64_t bitvalue = (id >> m_bitshift & ((1ull << (m_bitshift2 - m_bitshift)) - 1)) << m_droppedValueBits;
   // convert bits back to float
   return bitsToFloat(bitvalue);
 }
 
-uint32_t IdCoder::index(Identifier id) { return id & (uint64_t)(pow(2, m_bitshift) - 1); }
+uint32_t IdCoder::index(Identifier id) { return id & ((1ull << m_bitshift) - 1); }
 
-uint32_t IdCoder::uniqueId(Identifier id) {
+IdCoder::UniqueId IdCoder::uniqueId(Identifier id) {
   // For some purposes we want a smaller uniqueid without the value information
-  // here we consruct a 32 bit uniqueid out of the index and the type and subtype
+  // here we consruct a 32 bit uniqueid (64 bit if the index is wider than 21 bits) out of the index and the type and
+  // subtype
   uint32_t bitshift = m_bitshift + m_bitshift1 - m_bitshift2;
-  Identifier typeShift = (uint32_t)type(id) << bitshift;
-  Identifier subtypeShift = (uint32_t) static_cast<uint32_t>(tolower(subtype(id))) << m_bitshift;
+  UniqueId typeShift = (UniqueId)type(id) << bitshift;
+  UniqueId subtypeShift = (UniqueId) static_cast<uint32_t>(tolower(subtype(id))) << m_bitshift;
   // binary printout std::cout <<"Index" << std::bitset<32>(IdCoder::index(id)) <<std::endl;
-  uint32_t uniqueid = (uint32_t)subtypeShift | (uint32_t)typeShift | (uint32_t)index(id);
+  UniqueId uniqueid = subtypeShift | typeShift | (UniqueId)index(id);
   if (!checkUIDValid(id, uniqueid)) throw "unique id part of identifier not valid";
   return uniqueid;
 }
@@ -81,10 +84,22 @@ char IdCoder::typeLetter(Identifier id) {
 
 IdCoder::ItemType IdCoder::type(char s) {
   // converts from the a single letter decriptor eg 'e' into the type enumeration such as kEcalCluster
-  std::string typelist = ".ehtpb";
-  auto found = typelist.find(s);
-  if (found == typelist.npos) throw "type not found";
-  return (ItemType)found;
+  switch (s) {
+  case 'e':
+    return kEcalCluster;
+  case 'h':
+    return kHcalCluster;
+  case 't':
+    return kTrack;
+  case 'p':
+    return kParticle;
+  case 'b':
+    return kBlock;
+  case '.':
+    return kNone;
+  default:
+    throw "type not found";
+  }
 }
 
 std::string IdCoder::typeAndSubtype(Identifier id) {
@@ -124,17 +139,20 @@ bool IdCoder::checkValid(Identifier uid, ItemType itype, char subt, float val, u
   // verify that it all works, the id should match the items from which it was constructed
   if (index(uid) != indx) return false;
   if (val != 0) {
-    if ((fabs(value(uid) - val) >= fabs(val) * 10e-6) | (type(uid) != itype) | (subtype(uid) != subt)) return false;
+    // the value loses precision when low bits of the float are dropped for a wider index
+    const double tolerance = std::max(10e-6, 1. / (1u << (22 - m_droppedValueBits)));
+    if ((fabs(value(uid) - val) >= fabs(val) * tolerance) | (type(uid) != itype) | (subtype(uid) != subt))
+      return false;
   }
   return true;
 }
 
-bool IdCoder::checkUIDValid(Identifier id, uint32_t uniqueid) {
+bool IdCoder::checkUIDValid(Identifier id, UniqueId uniqueid) {
   uint32_t bitshift = m_bitshift + m_bitshift1 - m_bitshift2;
   // verify that it all works, the uniqueid should match the items from which it was constructed
-  ItemType it = static_cast<ItemType>((uniqueid >> bitshift) & (uint32_t)(pow(2, 3) - 1));
-  char st = static_cast<char>((uniqueid >> m_bitshift) & (uint64_t)(pow(2, bitshift - m_bitshift) - 1));
-  uint32_t idx = ((uniqueid) & (uint32_t)(pow(2, m_bitshift) - 1));
+  ItemType it = static_cast<ItemType>((uniqueid >> bitshift) & 7);
+  char st = static_cast<char>((uniqueid >> m_bitshift) & ((1ull << (bitshift - m_bitshift)) - 1));
+  uint32_t idx = (uint32_t)(uniqueid & ((1ull << m_bitshift) - 1));
   if (it != type(id) || st != subtype(id) || idx != index(id)) return false;
   return true;
 }
@@ -1,7 +1,11 @@
 #include "papas/datatypes/Path.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+#include "papas/detectors/SurfaceCylinder.h"
+
 namespace papas {
 
 double gconstc = 299792458.0;  // TODO constants.c)
@@ -49,7 +53,71 @@ double Path::vPerp() const {
   return m_speed * m_unitDirection.Perp();
 }
 
-bool Path::hasNamedPoint(papas::Position layer) const { return (m_points.find(layer) != m_points.end()); }
+void Path::addPoint(papas::Position layer, const TVector3& vec) {
+  // an explicit point replaces any lazy point for the same layer
+  if (!m_lazyCylinders.empty())
+    m_lazyCylinders.erase(std::remove_if(m_lazyCylinders.begin(), m_lazyCylinders.end(),
+                                         [layer](const SurfaceCylinder* cyl) { return cyl->layer() == layer; }),
+                          m_lazyCylinders.end());
+  m_points[layer] = vec;
+}
+
+bool Path::intersect(const SurfaceCylinder& cyl, TVector3& point) const {
+  double cylinderz = cyl.z();
+  double cylinderradius = cyl.radius();
+  double theta = m_unitDirection.Theta();
+  // particle created outside the cylinder
+  if (fabs(m_origin.Z()) > cylinderz || m_origin.Perp() > cylinderradius) return false;
+  double zbar = m_unitDirection.Z();  // Z of unit direction vector
+  if (zbar == 0) return false;
+  double destz = (zbar > 0) ? cylinderz : -cylinderz;
+  double length = (destz - m_origin.Z()) / cos(theta);  // TODO check Length >0
+  point = m_origin + m_unitDirection * length;
+  double rdest = point.Perp();
+  if (rdest > cylinderradius) {
+    TVector3 udirxy = TVector3(m_unitDirection.X(), m_unitDirection.Y(), 0.);
+    TVector3 originxy = TVector3(m_origin.X(), m_origin.Y(), 0.);
+    // solve 2nd degree equation for intersection
+    // between the straight line and the cylinder
+    // in the xy plane to get k,
+    // the propagation length
+    double a = udirxy.Mag2();
+    double b = 2 * udirxy.Dot(originxy);
+    double c = originxy.Mag2() - pow(cylinderradius, 2);
+    double delta = pow(b, 2) - 4 * a * c;
+    // double km = (-b - sqrt(delta))/(2*a);
+    // positive propagation -> correct solution.
+    double kp = (-b + sqrt(delta)) / (2 * a);
+    point = m_origin + m_unitDirection * kp;
+    // TODO deal with Z == 0
+    // TODO deal with overlapping cylinders
+  }
+  return true;
+}
+
+void Path::computeLazyPoints(papas::Position layer) const {
+  // the last cylinder that is crossed wins, as it would have overwritten the others if they were propagated in turn
+  TVector3 point;
+  for (auto it = m_lazyCylinders.rbegin(); it != m_lazyCylinders.rend(); ++it) {
+    if ((*it)->layer() == layer && intersect(**it, point)) {
+      m_points[layer] = point;
+      break;
+    }
+  }
+  m_lazyCylinders.erase(std::remove_if(m_lazyCylinders.begin(), m_lazyCylinders.end(),
+                                       [layer](const SurfaceCylinder* cyl) { return cyl->layer() == layer; }),
+                        m_lazyCylinders.end());
+}
+
+void Path::computeLazyPoints() const {
+  while (!m_lazyCylinders.empty())
+    computeLazyPoints(m_lazyCylinders.back()->layer());
+}
+
+bool Path::hasNamedPoint(papas::Position layer) const {
+  if (!m_lazyCylinders.empty()) computeLazyPoints(layer);
+  return (m_points.find(layer) != m_points.end());
+}
 
 const TVector3& Path::namedPoint(papas::Position layer) const {
   if (hasNamedPoint(layer)) {
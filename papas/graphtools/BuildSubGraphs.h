@@ -6,6 +6,7 @@
 #include <list>
 
 namespace papas {
+class EdgeStore;
 
 /**
  * buildSubGraphs is a function taking a list of identifiers and an unordered map of associated edges containing
@@ -34,5 +35,14 @@ namespace papas {
  */
 std::list<Ids> buildSubGraphs(const Ids& ids, const Edges& edges);
 
+/** buildSubGraphs function using a compact EdgeStore
+ * Gives the same subgraphs, in the same order, as the Edges version. Only the linked edges in the store that join
+ * two of the ids are used, so the ids may be a small part of a large store (eg the elements of one block).
+ * @param[in] ids : vector of identifiers eg of tracks, clusters etc
+ * @param[in] edges : EdgeStore containing (at least) the linked edges between the ids
+ * @param[in] unlinked : keys of edges in the store that are to be treated as unlinked
+ */
+std::list<Ids> buildSubGraphs(const Ids& ids, const EdgeStore& edges, const EdgeKeys& unlinked = EdgeKeys());
+
 }  // end namespace papas
 #endif /* BuildSubGraphs_h */
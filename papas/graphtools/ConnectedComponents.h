@@ -0,0 +1,49 @@
+#ifndef GRAPHTOOLS_CONNECTEDCOMPONENTS_H
+#define GRAPHTOOLS_CONNECTEDCOMPONENTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace papas {
+
+/** Finds the connected components of an undirected graph given as a list of edges between nodes 0 .. nNodes - 1.
+ *
+ * Each node is labelled with the smallest node of its component. The labels therefore do not depend on the order
+ * in which the edges are processed or on the number of threads, so anything ordered by them (eg block ids) is
+ * reproducible.
+ *
+ * Small graphs are done with a serial union-find. Graphs with at least minParallelEdges() edges are split across
+ * threads, which share a lock-free union-find: roots are only ever hooked under a smaller root (by compare and
+ * swap), so every parent is smaller than its child and the final root of a component is its smallest node.
+ *
+ * Usage:
+ * @code
+ *   std::vector<ConnectedComponents::Link> links{{0, 2}, {3, 1}};
+ *   auto labels = ConnectedComponents::labels(4, links);  // {0, 1, 0, 1}
+ * @endcode
+ */
+class ConnectedComponents {
+public:
+  typedef std::pair<uint32_t, uint32_t> Link;  ///< an edge between two nodes
+  /** Labels each node with the smallest node of its component
+   * @param[in] nNodes number of nodes
+   * @param[in] links edges between the nodes (each end must be less than nNodes)
+   * @return the label of each node
+   */
+  static std::vector<uint32_t> labels(uint32_t nNodes, const std::vector<Link>& links);
+  /// Sets the number of threads used for large graphs (0 = one per hardware thread, which is the default)
+  static void setThreads(unsigned int nThreads) { s_threads = nThreads; }
+  static unsigned int threads();  ///< number of threads used for large graphs
+  /// Sets the number of edges from which the graph is split across threads
+  static void setMinParallelEdges(std::size_t nEdges) { s_minParallelEdges = nEdges; }
+  static std::size_t minParallelEdges() { return s_minParallelEdges; }  ///< see setMinParallelEdges
+
+private:
+  static std::atomic<unsigned int> s_threads;          ///< threads for large graphs, 0 = hardware concurrency
+  static std::atomic<std::size_t> s_minParallelEdges;  ///< smaller graphs are done serially
+};
+
+}  // end namespace papas
+#endif /* GRAPHTOOLS_CONNECTEDCOMPONENTS_H */
@@ -4,7 +4,9 @@
 #include "papas/datatypes/Definitions.h"
 #include "papas/datatypes/IdCoder.h"
 #include "papas/graphtools/DirectedAcyclicGraph.h"
+#include "papas/utility/Metrics.h"
 
+#include <atomic>
 #include <list>
 #include <map>
 
@@ -14,26 +16,73 @@ typedef DAG::Node<Identifier> PFNode;
 typedef std::map<Identifier, PFNode> Nodes;
 typedef std::list<const Nodes*> ListNodes;  ///< collection of Nodes
 
+/// How much history (links between the items) is recorded by the simulation and reconstruction stages
+enum class HistoryLevel {
+  kNone,   ///< only the links from simulated particles to their tracks (see makeTrackHistoryLink)
+  kTruth,  ///< links from each object to the objects it was made from, but no blocks: a reconstructed particle is
+           ///< linked to its own tracks and clusters, which lead back to the simulated particles
+  kFull    ///< every link (the default)
+};
+
+inline std::atomic<HistoryLevel>& historyLevelSetting() {
+  static std::atomic<HistoryLevel> level(HistoryLevel::kFull);
+  return level;
+}
+/// Sets the history level used by all the stages
+inline void setHistoryLevel(HistoryLevel level) { historyLevelSetting().store(level, std::memory_order_relaxed); }
+inline HistoryLevel historyLevel() { return historyLevelSetting().load(std::memory_order_relaxed); }
+
 inline PFNode& findOrMakeNode(Identifier id, Nodes& history) {
   if (history.empty() || (history.find(id) == history.end())) {
     PFNode newnode(id);
     history.emplace(id, newnode);
+    Metrics::add(Metrics::kHistoryNodes);
   }
   return history.at(id);
 }
 
-inline void makeHistoryLink(Identifier parentid, Identifier childid, Nodes& history) {
+/// Links parent to child whatever the history level (eg when copying a history)
+inline void addHistoryLink(Identifier parentid, Identifier childid, Nodes& history) {
   findOrMakeNode(parentid, history).addChild(findOrMakeNode(childid, history));
+  Metrics::add(Metrics::kHistoryLinks);
+}
+
+/// Links parent to child unless the history level is kNone
+inline void makeHistoryLink(Identifier parentid, Identifier childid, Nodes& history) {
+  if (historyLevel() != HistoryLevel::kNone) addHistoryLink(parentid, childid, history);
 }
 
+/// Links a simulated particle to its track, or a track to its smeared track. These links are recorded at every
+/// history level because the truth based identification of muons and electrons in the reconstruction uses them.
+inline void makeTrackHistoryLink(Identifier parentid, Identifier childid, Nodes& history) {
+  addHistoryLink(parentid, childid, history);
+}
+
+/// Links every parent to every child unless the history level is kNone
 inline void makeHistoryLinks(const Ids& parentids, const Ids& childids, Nodes& history) {
+  if (historyLevel() == HistoryLevel::kNone) return;
   for (const auto pid : parentids) {
     for (const auto cid : childids) {
-      makeHistoryLink(pid, cid, history);
+      addHistoryLink(pid, cid, history);
     }
   }
 }
 
+/// Links every parent to one child unless the history level is kNone. The parents may be any list of ids, eg
+/// {blockid, elementid}, so that no set of ids is made.
+template <typename P>
+inline void makeHistoryLinks(const P& parentids, Identifier childid, Nodes& history) {
+  if (historyLevel() == HistoryLevel::kNone) return;
+  for (const auto pid : parentids)
+    addHistoryLink(pid, childid, history);
+}
+
+/// Links the elements of a block to the block. Only the full history has blocks, they group every element that
+/// is linked so they are not needed to go between simulated and reconstructed particles.
+inline void makeBlockHistoryLinks(const Ids& elementids, Identifier blockid, Nodes& history) {
+  if (historyLevel() == HistoryLevel::kFull) makeHistoryLinks(elementids, blockid, history);
+}
+
 inline void printHistory(const Nodes& history) {
   for (const auto& node : history)
     for (const auto& cnode : node.second.children())
@@ -1,8 +1,10 @@
 #ifndef DirectedAcyclicGraph_h
 #define DirectedAcyclicGraph_h
 
+#include <cstdint>
 #include <queue>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 /// Directed Acyclic Graph
@@ -61,6 +63,8 @@ using Nodeset = std::unordered_set<const N*>;  ///<set of Nodes which allows fin
 template <typename N>
 using Nodevector = std::vector<const N*>;  ///<vector of Nodes typically used to return results
 enum class enumVisitType { CHILDREN, PARENTS, UNDIRECTED };
+template <typename N>
+class BFSTraverser;
 
 /// Visitor class interface for the DirectedAcyclicGraph
 /**Defines the visitor class interface for the DirectedAcyclicGraph
@@ -148,6 +152,112 @@ private:
   virtual void traverse(const DAG::Nodeset<N>& nodes, typename DAG::enumVisitType visittype, int depth) override;
 };
 
+/// Breadth First Search that does not allocate once its queue has grown to the size of the largest search
+/**
+ The nodes reached are marked in a hash table owned by the traverser: each slot records the epoch (a number unique
+ to each traversal of this traverser) at which it was filled, so starting a new traversal only means taking a new
+ epoch and the table is kept from one traversal to the next. The nodes are not modified, so several traversers
+ (eg one per thread) can search the same nodes at the same time. A traverser itself must only be used by one
+ thread at a time (and no traversal may be started from inside a callback).
+ Each node reached is passed to a callback, bool callback(const N* node), which can for example filter on the node
+ value. The traversal stops as soon as the callback returns false.
+ @tparam N the Node
+ */
+template <typename N>
+class BFSTraverser {
+public:
+  BFSTraverser() : m_epoch(0), m_marked(0), m_slots(16, Slot{nullptr, 0}) { reset(); }  ///< Constructor
+  /// Starts a new traversal, afterwards no node counts as visited
+  void reset() {
+    ++m_epoch;
+    m_marked = 0;
+  }
+  bool visited(const N* node) const { return m_slots[find(node)].epoch == m_epoch; }  ///< Whether reached since reset
+  /**
+   Visits the start node and the nodes linked to it that have not been reached since the last reset, in the same
+   order as BFSVisitor
+   @param startnode the node to start from
+   @param visittype CHILDREN/PARENTS/UNDIRECTED
+   @param callback called for each node reached, returns false to stop the traversal
+   @param depth how many levels to visit (-1 = everything, 0 = start node, 2 = start node plus 2 levels)
+   @return false if the callback stopped the traversal
+   */
+  template <typename F>
+  bool visit(const N& startnode, DAG::enumVisitType visittype, F&& callback, int depth = -1);
+  /// Starts a new traversal (reset) and visits the nodes linked to the start node, see visit
+  template <typename F>
+  bool traverse(const N& startnode, DAG::enumVisitType visittype, F&& callback, int depth = -1) {
+    reset();
+    return visit(startnode, visittype, std::forward<F>(callback), depth);
+  }
+
+private:
+  /// a slot of the table of marked nodes, it is empty unless its epoch is the current one
+  struct Slot {
+    const N* node;
+    uint64_t epoch;
+  };
+  /// slot holding node in this traversal, or the empty slot where it would go (open addressing, linear probing)
+  std::size_t find(const N* node) const {
+    std::size_t mask = m_slots.size() - 1;
+    std::size_t i = (std::size_t)(((uintptr_t)node >> 3) * 0x9E3779B97F4A7C15ull >> 32) & mask;
+    while (m_slots[i].epoch == m_epoch && m_slots[i].node != node)
+      i = (i + 1) & mask;
+    return i;
+  }
+  /// marks node as reached, returns false if it already was
+  bool mark(const N* node) {
+    std::size_t i = find(node);
+    if (m_slots[i].epoch == m_epoch) return false;
+    if (2 * (m_marked + 1) > m_slots.size()) {  // keep the table at most half full
+      grow();
+      i = find(node);
+    }
+    m_slots[i] = Slot{node, m_epoch};
+    ++m_marked;
+    return true;
+  }
+  void grow() {
+    std::vector<Slot> old(2 * m_slots.size(), Slot{nullptr, 0});
+    old.swap(m_slots);
+    for (const auto& slot : old)
+      if (slot.epoch == m_epoch) m_slots[find(slot.node)] = slot;
+  }
+  uint64_t m_epoch;                               ///< epoch of the current traversal
+  std::size_t m_marked;                           ///< nodes marked in the current traversal
+  std::vector<Slot> m_slots;                      ///< marked nodes, the size is a power of 2
+  std::vector<std::pair<const N*, int>> m_queue;  ///< nodes and their depths, reused from one traversal to the next
+};
+
+template <typename N>
+template <typename F>
+bool BFSTraverser<N>::visit(const N& startnode, DAG::enumVisitType visittype, F&& callback, int depth) {
+  typedef typename DAG::enumVisitType pt;
+  if (!mark(&startnode)) return true;
+  bool useChildren = (visittype == pt::CHILDREN) | (visittype == pt::UNDIRECTED);
+  bool useParents = (visittype == pt::PARENTS) | (visittype == pt::UNDIRECTED);
+  // every node goes onto the queue once, so the queue is a vector read from the front and never popped
+  m_queue.clear();
+  m_queue.emplace_back(&startnode, 0);
+  for (std::size_t head = 0; head < m_queue.size(); ++head) {
+    const N* node = m_queue[head].first;
+    int curdepth = m_queue[head].second;
+    if (!callback(node)) return false;
+    if (depth >= 0 && curdepth >= depth) continue;  // NB depth=-1 means we are visiting everything
+    if (useChildren) {
+      for (const N* child : node->children()) {
+        if (mark(child)) m_queue.emplace_back(child, curdepth + 1);
+      }
+    }
+    if (useParents) {
+      for (const N* parent : node->parents()) {
+        if (mark(parent)) m_queue.emplace_back(parent, curdepth + 1);
+      }
+    }
+  }
+  return true;
+}
+
 /// Constructor
 template <typename T>
 Node<T>::Node(const T& v) : m_val(v) {}
@@ -2,6 +2,7 @@
 #define RECONSTRUCTION_EDGE_H
 
 #include "papas/datatypes/Definitions.h"
+#include "papas/datatypes/IdCoder.h"
 
 #include <array>
 #include <iostream>
@@ -29,7 +30,7 @@ public:
    eg for one track and one ecal the type will always be kEcalTrack (and never be a kTrackEcal)
    */
   enum EdgeType { kUnknown = 0, kEcalHcal, kEcalEcal, kEcalTrack, kHcalTrack, kHcalHcal, kTrackTrack };
-  typedef uint64_t EdgeKey;
+  typedef papas::EdgeKey EdgeKey;
   /// Constructor
   Edge() : m_endIds({{0, 0}}), m_isLinked(false), m_distance(0){};  // extra braces to shut buggy xcode warning
 
@@ -63,6 +64,11 @@ public:
   static EdgeKey
   makeKey(Identifier id1,
           Identifier id2);  ///<static function to create a unique key, key is indep of the ordering of id1 and id2
+  /** Returns the unique id (see IdCoder::uniqueId) of one end of the edge with this key
+   * @param[in] key edge key
+   * @param[in] end 0 for the end with the larger identifier, 1 for the other end
+   */
+  static IdCoder::UniqueId keyEnd(EdgeKey key, unsigned int end);
 private:
   std::array<Identifier, 2> m_endIds;  ///< long identifiers for the two ends
   bool m_isLinked;                     ///< boolean to day if there is a link between the two edges
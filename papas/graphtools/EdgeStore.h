@@ -0,0 +1,110 @@
+#ifndef RECONSTRUCTION_EDGESTORE_H
+#define RECONSTRUCTION_EDGESTORE_H
+
+#include "papas/datatypes/DefinitionsCollections.h"
+#include "papas/graphtools/Edge.h"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace papas {
+/**
+ *  @brief An EdgeStore is a compact collection of the edges between a set of elements (eg clusters and tracks)
+ *
+ *  Only edges that are linked are kept, together with (optionally) unlinked edges whose distance is not more than
+ *  a configurable maximum. All other edges are dropped as they are added, so the memory needed grows with the
+ *  number of candidate links rather than with the number of pairs of elements.
+ *
+ *  Each element identifier is given a 31 bit local index when it is added to the store, and the edges are held
+ *  as a sorted vector of small structs that refer to the local indices and store the distance as a float.
+ *  A store may also keep the exact (double) distances alongside, for small stores such as that of a block made
+ *  from Edges, so that the edges it returns are identical to those it was given.
+ *  Edge objects are created on request. For each element the local indices of the elements it is linked to are
+ *  also kept so that the links of one element can be found without looking through all the edges.
+ *
+ *  Usage example:
+ *  @code
+ *   EdgeStore store;
+ *   store.addEdge(id1, id2, dist.isLinked(), dist.distance());
+ *   auto subGraphs = buildSubGraphs(ids, store);
+ *  @endcode
+ */
+class EdgeStore {
+public:
+  /// Compact (12 byte) representation of one edge. end1 < end2 are the local indices of the two ends
+  struct Link {
+    uint32_t end1;          ///< local index of one end (the smaller one)
+    uint32_t end2 : 31;     ///< local index of the other end
+    uint32_t isLinked : 1;  ///< whether the two ends are linked
+    float distance;         ///< distance between the two ends
+  };
+  static const uint32_t kMaxIds = 1u << 31;  ///< local indices must fit in the 31 bits of Link::end2
+  typedef std::vector<Link> Links;  ///< collection of compact edges
+
+  /** Constructor
+   * @param[in] maxUnlinkedDistance unlinked edges with a distance not more than this are also kept. Negative values
+   *            (the default) mean that only linked edges are kept.
+   * @param[in] exactDistances whether the exact distances are kept as well as the float ones in the links
+   */
+  EdgeStore(double maxUnlinkedDistance = -1., bool exactDistances = false);
+
+  /** Adds an element identifier to the store (if it is not already there). Throws std::length_error if the store
+   * already has kMaxIds identifiers.
+   * @param[in] id element identifier
+   * @return the local index of the identifier
+   */
+  uint32_t addId(Identifier id);
+
+  /** Adds an edge to the store, provided that it is linked or is within the maximum unlinked distance.
+   * The ids are added to the store if needed. Each edge should only be added once.
+   * @param[in] id1 identifier of one end
+   * @param[in] id2 identifier of the other end
+   * @param[in] isLinked whether the two ends are linked
+   * @param[in] distance distance between the two ends
+   * @return true if the edge was kept
+   */
+  bool addEdge(Identifier id1, Identifier id2, bool isLinked, double distance);
+
+  /// is the id in the store
+  bool hasId(Identifier id) const { return m_indices.find(IdCoder::uniqueId(id)) != m_indices.end(); }
+  /// local index of id (throws if not present)
+  uint32_t index(Identifier id) const { return m_indices.at(IdCoder::uniqueId(id)); }
+  Identifier id(uint32_t index) const { return m_ids[index]; }      ///< identifier corresponding to a local index
+  std::size_t numIds() const { return m_ids.size(); }               ///< number of element ids in the store
+  std::size_t size() const { return m_links.size(); }               ///< number of edges kept
+  const Links& links() const { return m_links; }  ///< all edges kept, ordered by (end1, end2)
+  /// the edges kept whose smaller local index (end1) is "index", a range of links()
+  std::pair<Links::const_iterator, Links::const_iterator> linksFrom(uint32_t index) const;
+  /// local indices of the elements that have a linked edge to the element with local index "index"
+  const std::vector<uint32_t>& linkedNeighbours(uint32_t index) const { return m_linkedNeighbours[index]; }
+  double maxUnlinkedDistance() const { return m_maxUnlinkedDistance; }  ///< limit on the distance of unlinked edges
+  bool hasEdge(Identifier id1, Identifier id2) const;  ///< check if an edge between id1 and id2 was kept
+
+  /** Returns the edge between id1 and id2 (order does not matter). Throws std::range_error if it was not kept
+   * @param[in] id1 : is the Identifier of one end of the required edge
+   * @param[in] id2 : is the Identifier of other end of the required edge
+   */
+  Edge edge(Identifier id1, Identifier id2) const;
+  Edge edge(Edge::EdgeKey key) const;  ///< returns the edge with this key. Throws std::range_error if it was not kept
+  Edge edge(const Link& link) const;  ///< makes the Edge object corresponding to a compact edge (one of links())
+
+private:
+  const Link* find(Identifier id1, Identifier id2) const;  ///< finds the compact edge or nullptr
+  const Link* findUnique(IdCoder::UniqueId uid1, IdCoder::UniqueId uid2) const;  ///< same, from unique ids
+  static bool linkLess(const Link& l1, const Link& l2) {
+    return l1.end1 < l2.end1 || (l1.end1 == l2.end1 && l1.end2 < l2.end2);
+  }
+
+  double m_maxUnlinkedDistance;                      ///< unlinked edges are kept if within this distance
+  std::vector<Identifier> m_ids;                     ///< element identifiers indexed by local index
+  std::unordered_map<IdCoder::UniqueId, uint32_t> m_indices;  ///< local index for each element (by unique id)
+  Links m_links;                                     ///< the edges that are kept ordered by (end1, end2)
+  bool m_keepExactDistances;                         ///< whether m_exactDistances is filled
+  std::vector<double> m_exactDistances;              ///< exact distance of each link, if kept
+  std::vector<std::vector<uint32_t>> m_linkedNeighbours;  ///< for each local index, the linked local indices
+};
+
+}  // end namespace papas
+
+#endif /* RECONSTRUCTION_EDGESTORE_H */
@@ -15,7 +15,7 @@ namespace DAG {
 /// FloodFill creates blocks of connected elements
 ///  @tparam T is the content of a Node
 ///
-///   FLOODFILL uses the DAG BFSVisitor to find connected groups of nodes
+///   FLOODFILL uses the DAG BFSTraverser to find connected groups of nodes
 ///
 /// Example usage:
 /**
@@ -56,7 +56,7 @@ public:
   traverse(Nodemap&);  ///< runs floodfull algorithm; each element of return vector is a group of connected nodes
 
 private:
-  Nodeset m_visited;  ///< Nodes that have been visited (reset each time a traversal is made)
+  BFSTraverser<TNode> m_bfs;  ///< marks the nodes that have been visited (reset each time a traversal is made)
 };
 
 template <typename T>
@@ -66,19 +66,18 @@ template <typename T>
 std::vector<typename FloodFill<T>::Nodevector> FloodFill<T>::traverse(FloodFill<T>::Nodemap& nodes) {
   std::vector<Nodevector> resultsVector;
 
-  m_visited.clear();
-  BFSVisitor<TNode> bfs;
-
+  m_bfs.reset();
   for (const auto& elem : nodes) {
 
-    if (m_visited.find(&elem.second) != m_visited.end()) continue;  // already done this node so skip the rest
-
-    // do a BFS search on any node that has not yet been visited
-    Nodevector result = bfs.traverseUndirected(elem.second);
-    for (const TNode* n : result)
-      m_visited.insert(n);  // mark these as visited
+    if (m_bfs.visited(&elem.second)) continue;  // already done this node so skip the rest
 
-    resultsVector.push_back(result);
+    // do a BFS search on any node that has not yet been visited, the marks are kept from one group to the next
+    Nodevector result;
+    m_bfs.visit(elem.second, enumVisitType::UNDIRECTED, [&result](const TNode* node) {
+      result.push_back(node);
+      return true;
+    });
+    resultsVector.push_back(std::move(result));
   }
   return resultsVector;  // Move
 }
@@ -1,9 +1,15 @@
 #include "papas/graphtools/BuildSubGraphs.h"
 
+#include "papas/graphtools/ConnectedComponents.h"
 #include "papas/graphtools/DefinitionsNodes.h"
 #include "papas/graphtools/Edge.h"
+#include "papas/graphtools/EdgeStore.h"
 #include "papas/graphtools/FloodFill.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 namespace papas {
 
 std::list<Ids> buildSubGraphs(const Ids& ids, const Edges& edges) {
@@ -34,4 +40,39 @@ std::list<Ids> buildSubGraphs(const Ids& ids, const Edges& edges) {
   return subGraphs;
 }
 
+std::list<Ids> buildSubGraphs(const Ids& ids, const EdgeStore& edges, const EdgeKeys& unlinked) {
+  // work with local positions in the sorted ids, so the cost depends on the number of ids and not on the size of
+  // the store. The FloodFill version produces the subgraphs in order of their smallest id, so do the same here
+  std::vector<Identifier> sortedIds(ids.begin(), ids.end());
+  std::sort(sortedIds.begin(), sortedIds.end());
+  std::unordered_map<uint32_t, uint32_t> positions;  // local index in store -> position in sortedIds
+  positions.reserve(sortedIds.size());
+  for (uint32_t i = 0; i < sortedIds.size(); ++i) {
+    if (edges.hasId(sortedIds[i])) positions.emplace(edges.index(sortedIds[i]), i);
+  }
+  // collect the links between positions, the label of each subgraph is then its smallest position (ie id)
+  std::vector<ConnectedComponents::Link> links;
+  for (const auto& position : positions) {
+    auto i = position.second;
+    for (auto neighbour : edges.linkedNeighbours(position.first)) {
+      auto found = positions.find(neighbour);
+      if (found == positions.end() || found->second < i) continue;  // not wanted or already seen from other end
+      if (!unlinked.empty() && unlinked.count(Edge::makeKey(sortedIds[i], sortedIds[found->second]))) continue;
+      links.emplace_back(i, found->second);
+    }
+  }
+  auto labels = ConnectedComponents::labels(sortedIds.size(), links);
+  std::list<Ids> subGraphs;
+  std::vector<Ids*> groupOfRoot(sortedIds.size(), nullptr);
+  for (uint32_t i = 0; i < sortedIds.size(); ++i) {
+    auto r = labels[i];
+    if (groupOfRoot[r] == nullptr) {
+      subGraphs.push_back(Ids());
+      groupOfRoot[r] = &subGraphs.back();
+    }
+    groupOfRoot[r]->insert(sortedIds[i]);
+  }
+  return subGraphs;
+}
+
 }  // end namespace papas
@@ -0,0 +1,104 @@
+#include "papas/graphtools/ConnectedComponents.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+namespace papas {
+
+std::atomic<unsigned int> ConnectedComponents::s_threads(0);
+std::atomic<std::size_t> ConnectedComponents::s_minParallelEdges(1 << 16);
+
+unsigned int ConnectedComponents::threads() {
+  unsigned int n = s_threads;
+  if (n == 0) n = std::thread::hardware_concurrency();
+  return std::max(n, 1u);
+}
+
+namespace {
+
+std::vector<uint32_t> serialLabels(uint32_t nNodes, const std::vector<ConnectedComponents::Link>& links) {
+  std::vector<uint32_t> parent(nNodes);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto root = [&parent](uint32_t i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  for (const auto& link : links) {
+    auto r1 = root(link.first);
+    auto r2 = root(link.second);
+    if (r1 != r2) parent[std::max(r1, r2)] = std::min(r1, r2);
+  }
+  for (uint32_t i = 0; i < nNodes; ++i)
+    parent[i] = root(i);
+  return parent;
+}
+
+/// union-find shared between threads, every parent is smaller than its child
+class ConcurrentForest {
+public:
+  ConcurrentForest(uint32_t nNodes) : m_parent(new std::atomic<uint32_t>[nNodes]) {
+    for (uint32_t i = 0; i < nNodes; ++i)
+      m_parent[i].store(i, std::memory_order_relaxed);
+  }
+  uint32_t root(uint32_t i) {
+    while (true) {
+      uint32_t p = m_parent[i].load(std::memory_order_relaxed);
+      if (p == i) return i;
+      uint32_t gp = m_parent[p].load(std::memory_order_relaxed);
+      // path halving, it does not matter if another thread got there first
+      if (gp != p) m_parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+      i = gp;
+    }
+  }
+  void join(uint32_t a, uint32_t b) {
+    while (true) {
+      uint32_t r1 = root(a);
+      uint32_t r2 = root(b);
+      if (r1 == r2) return;
+      if (r1 < r2) std::swap(r1, r2);
+      // hook the larger root under the smaller one, unless it stopped being a root in the meantime
+      if (m_parent[r1].compare_exchange_strong(r1, r2, std::memory_order_acq_rel)) return;
+    }
+  }
+
+private:
+  std::unique_ptr<std::atomic<uint32_t>[]> m_parent;
+};
+
+/// runs f(begin, end) over [0, n) split into one contiguous range per thread
+template <typename F>
+void parallelFor(std::size_t n, unsigned int nThreads, F f) {
+  std::vector<std::thread> workers;
+  std::size_t chunk = (n + nThreads - 1) / nThreads;
+  for (std::size_t begin = chunk; begin < n; begin += chunk)
+    workers.emplace_back(f, begin, std::min(begin + chunk, n));
+  f(std::size_t(0), std::min(chunk, n));
+  for (auto& worker : workers)
+    worker.join();
+}
+
+}  // end anonymous namespace
+
+std::vector<uint32_t> ConnectedComponents::labels(uint32_t nNodes, const std::vector<Link>& links) {
+  unsigned int nThreads = threads();
+  if (nThreads < 2 || links.size() < s_minParallelEdges || links.size() < nThreads) return serialLabels(nNodes, links);
+  ConcurrentForest forest(nNodes);
+  parallelFor(links.size(), nThreads, [&forest, &links](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i)
+      forest.join(links[i].first, links[i].second);
+  });
+  // the threads have been joined so every root is final
+  std::vector<uint32_t> labels(nNodes);
+  parallelFor(nNodes, nThreads, [&forest, &labels](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i)
+      labels[i] = forest.root(i);
+  });
+  return labels;
+}
+
+}  // end namespace papas
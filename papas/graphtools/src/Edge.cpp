@@ -14,14 +14,24 @@ Edge::Edge(Identifier endId1, Identifier endId2, bool isLinked, double distance)
 /** Static function. Makes a unique key that can be used to locate the required edge
  */
 Edge::EdgeKey Edge::makeKey(Identifier id1, Identifier id2) {
-  EdgeKey key;
-  Identifier uid1 = IdCoder::uniqueId(id1);
-  Identifier uid2 = IdCoder::uniqueId(id2);
+  IdCoder::UniqueId uid1 = IdCoder::uniqueId(id1);
+  IdCoder::UniqueId uid2 = IdCoder::uniqueId(id2);
 
   if (id1 < id2)  // ensure that the order of the ids does not matter
     std::swap(uid1, uid2);
-  key = (((uint64_t)uid1) << 32) | ((uint64_t)uid2);
-  return key;
+#if PAPAS_ID_INDEX_BITS > 21
+  return EdgeKey{uid1, uid2};
+#else
+  return (((uint64_t)uid1) << 32) | ((uint64_t)uid2);
+#endif
+}
+
+IdCoder::UniqueId Edge::keyEnd(EdgeKey key, unsigned int end) {
+#if PAPAS_ID_INDEX_BITS > 21
+  return end ? key.uid2 : key.uid1;
+#else
+  return end ? (IdCoder::UniqueId)(key & 0xFFFFFFFF) : (IdCoder::UniqueId)(key >> 32);
+#endif
 }
 
 Identifier Edge::otherId(Identifier id) const {
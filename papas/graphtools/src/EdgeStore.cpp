@@ -0,0 +1,89 @@
+#include "papas/graphtools/EdgeStore.h"
+
+#include "papas/utility/Metrics.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace papas {
+
+EdgeStore::EdgeStore(double maxUnlinkedDistance, bool exactDistances)
+    : m_maxUnlinkedDistance(maxUnlinkedDistance), m_keepExactDistances(exactDistances) {}
+
+uint32_t EdgeStore::addId(Identifier id) {
+  auto found = m_indices.find(IdCoder::uniqueId(id));
+  if (found != m_indices.end()) return found->second;
+  if (m_ids.size() >= kMaxIds) throw std::length_error("EdgeStore: too many element ids for a 31 bit local index");
+  uint32_t index = m_ids.size();
+  m_ids.push_back(id);
+  m_indices.emplace(IdCoder::uniqueId(id), index);
+  m_linkedNeighbours.emplace_back();
+  return index;
+}
+
+bool EdgeStore::addEdge(Identifier id1, Identifier id2, bool isLinked, double distance) {
+  // unlinked edges are only wanted if they are close enough
+  if (!isLinked && (m_maxUnlinkedDistance < 0 || distance > m_maxUnlinkedDistance)) return false;
+  Metrics::add(Metrics::kEdgesCreated);
+  if (isLinked) Metrics::add(Metrics::kEdgesLinked);
+  uint32_t end1 = addId(id1);
+  uint32_t end2 = addId(id2);
+  if (end1 > end2) std::swap(end1, end2);
+  Link link{end1, end2, isLinked, (float)distance};
+  // edges are normally added in order, in which case this is just a push_back
+  auto position = m_links.end();
+  if (!m_links.empty() && !linkLess(m_links.back(), link))
+    position = std::lower_bound(m_links.begin(), m_links.end(), link, linkLess);
+  if (m_keepExactDistances) m_exactDistances.insert(m_exactDistances.begin() + (position - m_links.begin()), distance);
+  m_links.insert(position, link);
+  if (isLinked) {
+    m_linkedNeighbours[end1].push_back(end2);
+    m_linkedNeighbours[end2].push_back(end1);
+  }
+  return true;
+}
+
+const EdgeStore::Link* EdgeStore::find(Identifier id1, Identifier id2) const {
+  return findUnique(IdCoder::uniqueId(id1), IdCoder::uniqueId(id2));
+}
+
+const EdgeStore::Link* EdgeStore::findUnique(IdCoder::UniqueId uid1, IdCoder::UniqueId uid2) const {
+  auto found1 = m_indices.find(uid1);
+  auto found2 = m_indices.find(uid2);
+  if (found1 == m_indices.end() || found2 == m_indices.end()) return nullptr;
+  Link link{std::min(found1->second, found2->second), std::max(found1->second, found2->second), false, 0};
+  auto found = std::lower_bound(m_links.begin(), m_links.end(), link, linkLess);
+  if (found == m_links.end() || found->end1 != link.end1 || found->end2 != link.end2) return nullptr;
+  return &(*found);
+}
+
+bool EdgeStore::hasEdge(Identifier id1, Identifier id2) const { return find(id1, id2) != nullptr; }
+
+Edge EdgeStore::edge(Identifier id1, Identifier id2) const {
+  const Link* link = find(id1, id2);
+  if (link == nullptr) throw std::range_error("Edge not found");
+  return edge(*link);
+}
+
+Edge EdgeStore::edge(Edge::EdgeKey key) const {
+  const Link* link = findUnique(Edge::keyEnd(key, 0), Edge::keyEnd(key, 1));
+  if (link == nullptr) throw std::range_error("Edge not found");
+  return edge(*link);
+}
+
+std::pair<EdgeStore::Links::const_iterator, EdgeStore::Links::const_iterator> EdgeStore::linksFrom(
+    uint32_t index) const {
+  // the links are ordered by end1, so those from index are together
+  auto first = std::lower_bound(m_links.begin(), m_links.end(), index,
+                                [](const Link& link, uint32_t end1) { return link.end1 < end1; });
+  auto last = std::upper_bound(first, m_links.end(), index,
+                               [](uint32_t end1, const Link& link) { return end1 < link.end1; });
+  return std::make_pair(first, last);
+}
+
+Edge EdgeStore::edge(const Link& link) const {
+  double distance = m_keepExactDistances ? m_exactDistances[&link - m_links.data()] : link.distance;
+  return Edge(m_ids[link.end1], m_ids[link.end2], link.isLinked != 0, distance);
+}
+
+}  // end namespace papas
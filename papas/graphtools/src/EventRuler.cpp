@@ -2,6 +2,7 @@
 
 #include "papas/datatypes/Event.h"
 #include "papas/graphtools/Distance.h"
+#include "papas/utility/Metrics.h"
 
 namespace papas {
 
@@ -9,6 +10,7 @@ EventRuler::EventRuler(const Event& papasevent) : m_ruler(), m_event(papasevent)
 
 Distance EventRuler::distance(Identifier id1, Identifier id2) const {
   // figure out the object types and then call ClusterCluster or ClusterTrack distance measures
+  Metrics::add(Metrics::kDistanceEvaluations);
   if (IdCoder::isCluster(id1) && IdCoder::isCluster(id2))
     if (IdCoder::type(id1) == IdCoder::type(id2))
       return clusterClusterDistance(id1, id2);
@@ -5,10 +5,12 @@
 #include "papas/datatypes/IdCoder.h"
 #include "papas/graphtools/DefinitionsNodes.h"
 
+#include <memory>
 #include <string>
 
 namespace papas {
 class Event;
+class EdgeStore;
 
 /**
 Takes collections of tracks and clusters from an event and calculates the
@@ -20,9 +22,10 @@ connected objects. Blocks of connected items, PFBlocks,are created from the subg
 * @param[in] trackSubtype which tracks collection to use, eg 's' for smeared
 * @param[inout] blocks external collection into which new blocks will be added
 * @param[inout] history external collection of Nodes to which parent child relations can be added
+* @param[in] maxUnlinkedDistance unlinked edges within this distance are kept in the blocks (negative: none are kept)
 */
 void buildPFBlocks(const Event& event, IdCoder::SubType ecalSubtype, IdCoder::SubType hcalSubtype, char trackSubtype,
-                   Blocks& blocks, Nodes& history);
+                   Blocks& blocks, Nodes& history, double maxUnlinkedDistance = -1.);
 
 /**
  * Takes a list of Ids and an unordered map of associated edges which have distance and link info
@@ -45,5 +48,18 @@ void buildPFBlocks(const Event& event, IdCoder::SubType ecalSubtype, IdCoder::Su
  */
 void buildPFBlocks(const Ids& ids, const Edges& edges, char subtype, Blocks& blocks, Nodes& history);
 
+/**
+ * As above but the edges come from a compact EdgeStore, which need only contain the linked edges.
+ * The blocks that are made share the EdgeStore.
+ * @param[in] ids list of identifiers eg of tracks, clusters etc
+ * @param[in] edges EdgeStore containing (at least) the linked edges between the ids
+ * @param[in] subtype the subtype (eg 'r') which will be given to newly created blocks
+ * @param[inout] blocks external collection into which new blocks will be added
+ * @param[inout] history external collection of Nodes to which parent child relations can be added
+ * @param[in] unlinked keys of edges in the store that are to be treated as unlinked
+ */
+void buildPFBlocks(const Ids& ids, std::shared_ptr<const EdgeStore> edges, char subtype, Blocks& blocks,
+                   Nodes& history, const EdgeKeys& unlinked = EdgeKeys());
+
 }  // end namespace papas
 #endif /* BUILDPFBLOCKS_h */
@@ -0,0 +1,39 @@
+#ifndef RECONSTRUCTION_MERGEANDBUILDBLOCKS_H
+#define RECONSTRUCTION_MERGEANDBUILDBLOCKS_H
+
+#include "papas/datatypes/DefinitionsCollections.h"
+#include "papas/datatypes/IdCoder.h"
+#include "papas/graphtools/DefinitionsNodes.h"
+
+namespace papas {
+class Event;
+
+/**
+ Merges the ecal and the hcal clusters and links the merged clusters to the tracks in one pass, making the blocks
+ directly. The merged clusters, blocks and history are the same as those made by
+ @code
+ mergeClusters(event, "es", ruler, mergedEcals, history);
+ mergeClusters(event, "hs", ruler, mergedHcals, history);
+ buildPFBlocks(event, 'm', 'm', 's', blocks, history);
+ @endcode
+ but the clusters and tracks are used directly rather than being found again in the Event from their ids, and the
+ subgraphs (of merged clusters and of blocks) are found from local indices rather than from sets of ids and
+ maps of edges.
+ (The order of the elements of an unsorted Ids set is not reproduced, so without WITHSORT the positions of the
+ merged clusters may differ in the last bits.)
+ * @param[in] event Contains the ecals, hcals and tracks
+ * @param[in] ecalSubtype which ecals collection to merge eg 's' for smeared ecals
+ * @param[in] hcalSubtype which hcals collection to merge
+ * @param[in] trackSubtype which tracks collection to use, eg 's' for smeared
+ * @param[inout] mergedEcals an empty collection into which the merged ecal clusters will be placed
+ * @param[inout] mergedHcals an empty collection into which the merged hcal clusters will be placed
+ * @param[inout] blocks external collection into which new blocks will be added
+ * @param[inout] history external collection of Nodes to which parent child relations can be added
+ * @param[in] maxUnlinkedDistance unlinked edges within this distance are kept in the blocks (negative: none are kept)
+ */
+void mergeAndBuildPFBlocks(const Event& event, IdCoder::SubType ecalSubtype, IdCoder::SubType hcalSubtype,
+                           char trackSubtype, Clusters& mergedEcals, Clusters& mergedHcals, Blocks& blocks,
+                           Nodes& history, double maxUnlinkedDistance = -1.);
+
+}  // end namespace papas
+#endif /* RECONSTRUCTION_MERGEANDBUILDBLOCKS_H */
@@ -13,7 +13,7 @@ class EventRuler;
 /**
  /// Function to take a collection of clusters and make new merged clusters that are added
  /// to a collection of merged clusters.
- /// It first creates a collection of edges describing the distances between every possible pair of clusters.
+ /// It first finds the distances between every possible pair of clusters and keeps the edges that are linked.
  /// The cluster ids and corresponding edges are then used to create distinct subgraphs.
  /// Each subgraph is a set of overlapping clusters and becomes a new merged cluster.
  /// Subgraphs with only one cluster will also create a new merged cluster (a copy of the original cluster)
@@ -25,8 +25,9 @@ class EventRuler;
  * @param[in] ruler measures distance between clusters
  * @param[in] merged an empty unordered_map into which the merged Clusters will be place
  * @param[inout] history an unordered_map into which new history will be added
+ * @param[in] maxUnlinkedDistance unlinked edges within this distance are also kept (negative: none are kept)
  */
 void mergeClusters(const Event& event, const std::string& typeAndSubtype, const EventRuler& ruler, Clusters& merged,
-                   Nodes& history);
+                   Nodes& history, double maxUnlinkedDistance = -1.);
 }  // end namespace papas
 #endif
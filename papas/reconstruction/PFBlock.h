@@ -3,23 +3,29 @@
 
 #include "papas/datatypes/DefinitionsCollections.h"
 #include "papas/graphtools/Edge.h"
+#include "papas/graphtools/EdgeStore.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 namespace papas {
 
 /** A Particle Flow Block (PFBlock) stores a set of element ids that are connected to each other
- together with the edge data (distances/linkage) for each possible edge combination
+ together with the edge data (distances/linkage) for the edges between the elements
 
  class attributes:
 
  Identifier m_id : the block's identifier generated from IdCoder class
  Ids m_elementIds : list of identifiers of its elements
 
- Edges m_edges : Unordered map of all the edge combinations in the block
+ std::shared_ptr<const EdgeStore> m_edgeStore : the (immutable) edges, usually shared by all the blocks of an event
+ EdgeKeys m_unlinkedKeys : keys of edges in the store that are treated as unlinked in this block
           use  edge(id1,id2) to find an edge
 
+ Blocks do not copy their edges: a simplified block shares the edge store with the block it came from and records
+ any links that were removed in its own (small) set of unlinked keys.
+
  Usage:
  block = PFBlock(element_ids,  edges, 'r')
  os << block;
@@ -30,13 +36,19 @@ class PFBlock {
 public:
   /** Constructor
    @param[in] element_ids vector of Identifiers of the elements to go in this block [id1,id2,...]
-   @param[inout] edges is an unordered map of edges, it must contain at least all needed edges. It is not a
-   problem if it contains additional edges as only the ones needed will be extracted. Note that edges that are
-   extracted will be removed from the Edges object and will become owned by the PFBlock
+   @param[in] edges is an unordered map of edges, it must contain at least all needed edges. It is not a
+   problem if it contains additional edges as only the ones needed will be copied into the block's own EdgeStore
+   @param[in] subtype The subtype for the identifier of the block eg 's' for split block
+   */
+  PFBlock(const Ids& elementIds, const Edges& edges, uint32_t index, char subtype = 'u');
+  /** Constructor
+   @param[in] element_ids vector of Identifiers of the elements to go in this block [id1,id2,...]
+   @param[in] edges shared store of edges which contains (at least) the edges between the elements. It is not copied.
    @param[in] subtype The subtype for the identifier of the block eg 's' for split block
+   @param[in] unlinkedKeys keys of edges in the store that are to be treated as unlinked within this block
    */
-  PFBlock(const Ids& elementIds, const Edges& edges, uint32_t index,
-          char subtype = 'u');           // relevant parts of edges will be removed and become owned by PFBlock
+  PFBlock(const Ids& elementIds, std::shared_ptr<const EdgeStore> edges, uint32_t index, char subtype = 'u',
+          const EdgeKeys& unlinkedKeys = EdgeKeys());
   PFBlock(PFBlock&& pfblock) = default;  // allow move
   ~PFBlock();                            /// destructor
   const Ids& elementIds() const { return m_elementIds; }  ///< returns vector of all ids in the block
@@ -64,7 +76,10 @@ public:
   int countTracks() const;        ///< Counts how many tracks are in the block
   int size() const { return m_elementIds.size(); }     ///< length of the element_unqiueids
   Identifier id() const { return m_id; };              ///<Unique ID of the block
-  const Edges& edges() const { return m_edges; }       ///<Unordered map of all the edges in a block
+  Edges edges() const;           ///<Unordered map of all the edges in a block (a copy, visitEdges avoids it)
+  std::size_t numEdges() const;  ///<number of edges between the elements of the block
+  const std::shared_ptr<const EdgeStore>& edgeStore() const { return m_edgeStore; }  ///<the shared edges
+  const EdgeKeys& unlinkedKeys() const { return m_unlinkedKeys; }  ///<edges in the store that are unlinked here
   std::string info() const;                            ///< printable one line summary of a Block
   std::string elementsString() const;                  ///< String listing all elements in a Block
   std::string edgeMatrixString() const;                ///< String representation of matrix of edges in a block
@@ -74,16 +89,39 @@ public:
    @param[in] id1 : is the Identifier of one end of the required edge
    @param[in] id2 : is the Identifier of other end of the required edge
   */
-  const Edge& edge(Identifier id1, Identifier id2) const;  ///<return edge corresponding to two ids
-  const Edge& edge(Edge::EdgeKey key) const;               ///<return edge corresponding to Edge key
+  Edge edge(Identifier id1, Identifier id2) const;  ///<return edge corresponding to two ids
+  Edge edge(Edge::EdgeKey key) const;               ///<return edge corresponding to Edge key
+
+  /** Calls a function for each edge between the elements of the block, without copying the edges. Only the links
+   of the shared store that start from an element of the block are looked at.
+   @param[in] callback void callback(const Edge& edge), the edge is unlinked if it is unlinked in this block
+   */
+  template <typename F>
+  void visitEdges(F&& callback) const {
+    for (auto id : m_elementIds) {
+      if (!m_edgeStore->hasId(id)) continue;
+      auto links = m_edgeStore->linksFrom(m_edgeStore->index(id));
+      for (auto link = links.first; link != links.second; ++link) {
+        if (!hasElement(m_edgeStore->id(link->end2))) continue;  // the store may be shared with other blocks
+        Edge e = m_edgeStore->edge(*link);
+        if (e.isLinked() && !m_unlinkedKeys.empty() && m_unlinkedKeys.find(e.key()) != m_unlinkedKeys.end())
+          e.setLinked(false);
+        callback(e);
+      }
+    }
+  }
+
 private:
   PFBlock(PFBlock& pfblock) = default;  // avoid copying of blocks
   PFBlock(const PFBlock& pfblock) = default;
   PFBlock& operator=(const PFBlock&) = default;
 
-  Identifier m_id;   ///<  identifier for this block
-  Ids m_elementIds;  ///<  ids of elements in this block ordered by type and decreasing energy
-  Edges m_edges;     ///< all the edges for elements in this block
+  bool hasElement(Identifier id) const { return m_elementIds.find(id) != m_elementIds.end(); }
+
+  Identifier m_id;                               ///<  identifier for this block
+  Ids m_elementIds;                              ///<  ids of elements ordered by type and decreasing energy
+  std::shared_ptr<const EdgeStore> m_edgeStore;  ///< edges for (at least) the elements in this block
+  EdgeKeys m_unlinkedKeys;                       ///< keys of edges in m_edgeStore that are unlinked in this block
 };
 
 std::ostream& operator<<(std::ostream& os, const PFBlock& block);
@@ -2,10 +2,13 @@
 #define PFReconstructor_h
 
 #include "papas/datatypes/DefinitionsCollections.h"
+#include "papas/datatypes/HistoryHelper.h"
+#include "papas/datatypes/IdBitset.h"
 #include "papas/graphtools/DefinitionsNodes.h"
 
+#include <array>
+#include <initializer_list>
 #include <memory>
-#include <unordered_map>
 
 #include "TVector3.h"
 
@@ -81,6 +84,11 @@ class PFReconstructor {
    @endcode
    */
 public:
+  /// Block topologies (in PFBlock::shortName terms) that have a specialised reconstruction.
+  /// Blocks of any other topology (kOther) use the general algorithm.
+  enum Topology { kE1 = 0, kH1, kT1, kE1T1, kH1T1, kOther, kNumTopologies };
+  typedef std::array<unsigned int, kNumTopologies> TopologyCounts;  ///< number of blocks of each topology
+
   /** Constructor
    event must contain PFBlocks of linked tracks and clusters of type blockSubtype
    blockSubtype single character describing which blocks to use eg 's' for split blocks
@@ -91,6 +99,9 @@ public:
   PFReconstructor(const Event& event, char blockSubtype, const Detector& detector, Particles& particles,
                   Nodes& history);
   ~PFReconstructor();
+  const TopologyCounts& topologyCounts() const { return m_topologyCounts; }  ///< blocks reconstructed per topology
+  static Topology topology(const PFBlock& block);  ///< finds the topology of a block
+  static const char* topologyName(Topology topology);  ///< name of a topology eg "E1T1" or "other"
 
   // const Particles& particles() const { return m_particles; }  //
 private:
@@ -98,32 +109,80 @@ private:
       block the block to be reconstructed
   */
   void reconstructBlock(const PFBlock& block);
+  /** General reconstruction algorithm, used for blocks which do not have a specialised topology
+   @param block the block to be reconstructed
+   */
+  void reconstructGeneralBlock(const PFBlock& block);
+  /** Reconstructs a block consisting of a single cluster (E1 or H1)
+   @param block the block to be reconstructed
+   @param clusterId the identifier of the cluster
+   @param layer papas::Layer::kEcal or papas::Layer::kHcal
+   */
+  void reconstructSingleCluster(const PFBlock& block, Identifier clusterId, papas::Layer layer);
+  /** Reconstructs a block consisting of a single track (T1)
+   @param block the block to be reconstructed
+   @param trackId the identifier of the track
+   */
+  void reconstructSingleTrack(const PFBlock& block, Identifier trackId);
+  /** Reconstructs a block consisting of an ecal linked to a track (E1T1)
+   @param block the block to be reconstructed
+   @param ecalId the identifier of the ecal cluster
+   @param trackId the identifier of the track
+   */
+  void reconstructEcalTrack(const PFBlock& block, Identifier ecalId, Identifier trackId);
+  /** Reconstructs a block consisting of an hcal linked to a track (H1T1)
+   @param block the block to be reconstructed
+   @param hcalId the identifier of the hcal cluster
+   @param trackId the identifier of the track
+   */
+  void reconstructHcalTrack(const PFBlock& block, Identifier hcalId, Identifier trackId);
+  /** Reconstructs a muon or electron from a track if the track comes from a simulated muon or electron
+   @param block the block to which the track belongs
+   @param trackId the identifier of the track
+   */
+  void reconstructLeptons(const PFBlock& block, Identifier trackId);
   /** Reconstructs particles from na hcal cluster
       @param block the block to which the hcal structure belongs
       @param hcalId the identifier of the Hcal cluster
   */
   void reconstructHcal(const PFBlock& block, Identifier hcalId);
+  /** Compares the energy of an hcal (and its ecals) with the energy of its linked tracks and makes a neutral hadron
+      and/or photon from any excess
+      @param block the block to which the hcal belongs
+      @param hcal the Hcal cluster
+      @param ecalIds the identifiers of the ecals linked to the tracks
+      @param ecalEnergy the total energy of the ecals
+      @param trackEnergy the total energy of the tracks linked to the hcal
+  */
+  void reconstructHcalExcess(const PFBlock& block, const Cluster& hcal, const Ids& ecalIds, double ecalEnergy,
+                             double trackEnergy);
   /** Reconstructs a charged hadron/electron/muon from an Hcal
    @param track the track which is to be reconstructed
    @param pdgId the type of particle to be reconstructed
-   @param parentIds ids of parent objects which will be recorded in the history
+   @param parentIds ids of parent objects which will be recorded in the history (Ids, or a list of ids)
    */
+  template <typename P>
   void reconstructTrack(const Track& track, int pdgId,
-                        const Ids& parentIds);  ///< constructs and returns particle(s) starting from a track
+                        const P& parentIds);  ///< constructs and returns particle(s) starting from a track
+  /// As above with the parents listed in place, eg {block.id(), trackId}, so that no set of ids is made
+  void reconstructTrack(const Track& track, int pdgId, std::initializer_list<Identifier> parentIds);
   /** Reconstruct photon (Ecal) of neutralHadron (hcal) from a cluster
   @param cluster cluster that is to be reconstructed into photon or neutral hadron
   @param layer Ecal or Hcal papas::Layer::kEcal or papas::Layer::kHcal
-  @param parentIds ids of parent objects which will be recorded in the history
+  @param parentIds ids of parent objects which will be recorded in the history (Ids, or a list of ids)
   @param energy Energy that is to be assigned to the particle, if not specified or if negative the cluster energy will
   be used
   @param vertex This will be the start vertex for the new particle
   */
+  template <typename P>
   void reconstructCluster(
-      const Cluster& cluster, papas::Layer layer, const Ids& parentIds, double energy = -1,
+      const Cluster& cluster, papas::Layer layer, const P& parentIds, double energy = -1,
       const TVector3& vertex = TVector3());  ///< constructs and returns a particles starting from a cluster
-                                             /** Identify any electrons in the block and reconstruct them
-                                              @param block Block in which to check for and reconstruct electrons
-                                             */
+  /// As above with the parents listed in place, eg {block.id(), clusterId}, so that no set of ids is made
+  void reconstructCluster(const Cluster& cluster, papas::Layer layer, std::initializer_list<Identifier> parentIds);
+  /** Identify any electrons in the block and reconstruct them
+   @param block Block in which to check for and reconstruct electrons
+   */
   void reconstructElectrons(const PFBlock& block);
   /** Identify any muons in the block and reconstruct them
    @param block Block in which to check for and reconstruct muons
@@ -131,11 +190,11 @@ private:
   void reconstructMuons(const PFBlock& block);
   // void insertParticle(const PFBlock& block, Particle&& particle);  ///< moves particle and adds into history
   /** Add new particle into history
-   @param Ids Identifiers of parents of the new particle
+   @param parentIds Identifiers of parents of the new particle (Ids, or a list of ids)
    @param newparticle New particle that is to be added into history
    */
-
-  void insertParticle(const Ids& parentIds, Particle& newparticle);
+  template <typename P>
+  void insertParticle(const P& parentIds, Particle& newparticle);
   /**  Checks if object identifier comes, directly or indirectly,
    from a particle of type typeAndSubtype, with this absolute pdgid.
    @param id Identifier of object
@@ -155,14 +214,16 @@ private:
    */
   double nsigmaHcal(const Cluster& cluster) const;
   std::shared_ptr<const Propagator> propagator(double charge) const;
-  const Event& m_event;        ///< Contains history information and collections of clusters/blocks/tracks
-  const Detector& m_detector;  ///< Detector
-  Particles& m_particles;      ///< the reconstructed particles created by this class
+  const Event& m_event;           ///< Contains history information and collections of clusters/blocks/tracks
+  HistoryHelper m_historyHelper;  ///< searches the history of m_event
+  const Detector& m_detector;     ///< Detector
+  Particles& m_particles;         ///< the reconstructed particles created by this class
   Nodes& m_history;  ///< History collection of Nodes (owned elsewhere) to which new history info will be added
-  Ids m_unused;      ///< List of ids (of clusters, tracks) which were not used in the particle reconstructions
-  std::unordered_map<Identifier, bool> m_locked;  ///< map of identifiers which have already been used in reconstruction
+  IdBitset m_unused;  ///< Flags ids (of clusters, tracks) which were not used in the particle reconstructions
+  IdBitset m_locked;  ///< Flags identifiers which have already been used in reconstruction (reset for each block)
   std::shared_ptr<StraightLinePropagator> m_propStraight;  ///<used to determine the path of uncharged particles
   std::shared_ptr<HelixPropagator> m_propHelix;            ///<used to determine the path of charged particles
+  TopologyCounts m_topologyCounts;                         ///<number of blocks reconstructed for each topology
 };
 }  // end namespace papas
 #endif /* PFReconstructor_h */
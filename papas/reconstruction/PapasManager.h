@@ -4,14 +4,19 @@
 #include "papas/datatypes/DefinitionsCollections.h"
 #include "papas/datatypes/Event.h"
 #include "papas/graphtools/DefinitionsNodes.h"
+#include "papas/reconstruction/PFReconstructor.h"
 
 #include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace papas {
 
 // forward declarations
 class Detector;
+class Path;
 
 /**
  *  @brief The PapasManager class is a high level class to own the clusters, particles etc created in an event and
@@ -30,6 +35,17 @@ class Detector;
    FCCSW framework.
  The PapasManager object must be cleared between events.
 
+ By default every collection is kept until clear(). With setRetention(Retention::kPruned) each stage declares
+ how many later stages will read the collections it makes, and a collection is released (removed from the Event
+ and deleted) as soon as its last reader has run: the true clusters and tracks once simulate is done, the raw
+ blocks once they have been simplified, and everything else except the reconstructed particles once
+ reconstruct is done. Merged clusters point to the clusters they were merged from, so those are released together.
+ Collections that were not made by the PapasManager (eg particles added with addParticles) are never released.
+
+ Reading an Event is not thread safe: the points where particle and track paths cross the detector are computed
+ and stored the first time they are asked for, and these paths refer to the Detector's cylinders. An Event must
+ only be read from one thread at a time, and the Detector must outlive the PapasManager and its Event.
+
  Usage example:
  @code
       papasManager.simulate(papasparticles);
@@ -46,6 +62,11 @@ class Detector;
 
 class PapasManager {
 public:
+  /// @enum how long the collections made by the PapasManager are kept
+  enum class Retention {
+    kKeepAll,  ///< until clear() (default)
+    kPruned    ///< until the last stage that reads them has run
+  };
   /** Constructor
    * @param[in] detector : the detector to be used in the simulation and reconstruction
    */
@@ -81,6 +102,21 @@ public:
    */
   void mergeClusters(const std::string& typeAndSubtype);
   void buildBlocks(char ecalSubtype = 'm', char hcalSubtype = 'm', char trackSubtype = 's');
+  /**
+   *   @brief  Merges the ecal and hcal clusters and builds blocks from the merged clusters and the tracks in one
+   *           stage, giving the same results as mergeClusters("es"), mergeClusters("hs") then buildBlocks()
+   *           (see mergeAndBuildPFBlocks). It is timed as block building.
+   *   @param[in]  ecalSubtype subtype of the ecal clusters to merge
+   *   @param[in]  hcalSubtype subtype of the hcal clusters to merge
+   *   @param[in]  trackSubtype subtype of the tracks
+   *
+   *   This method will create the following objects and add them to Event and to
+   *   the internal class lists of owned objects:
+   *       merged clusters "em" and "hm"
+   *       raw blocks "br"
+   *       history
+   */
+  void mergeAndBuildBlocks(char ecalSubtype = 's', char hcalSubtype = 's', char trackSubtype = 's');
   void simplifyBlocks(char blockSubtype);
   // void mergeHistories();
   void reconstruct(char blockSubtype);
@@ -88,16 +124,55 @@ public:
    *   @brief  return Event object
    *   @return  Event     */
   const Event& event() const { return m_event; }                          ///< Access the event
-  void addParticles(const Particles& particles);                          ///< Add particles collection to the event
+  /// Add particles collection to the event, making the path of any particle that has none (eg after a bulk import)
+  void addParticles(Particles& particles);
   const Detector& detector() const { return m_detector; }                 ///< Access the detector
   void setEventNo(unsigned int eventNo) { m_event.setEventNo(eventNo); }  ///< Set the event No
   void clear();                                                           ///<clears all owned objects and the Event
   Particles& createParticles();  ///< Create an empty concrete collection of particles for filling by an algorithm
-
-protected:
   Clusters& createClusters();  ///< Create an empty concrete collection of clusters ready for filling by an algorithm
   Tracks& createTracks();      ///<  Create an empty concrete collection of tracks ready for filling by an algorithm
+  /**
+   *   @brief  Adds clusters made outside PAPAS (eg from a full simulation) to the event in place of simulated ones,
+   *           so that mergeClusters, buildBlocks and reconstruct can be run on them. Normally the clusters will be
+   *           a collection made with createClusters, it is then released like the smeared clusters in pruned mode.
+   *   @param[in]  clusters ecal or hcal clusters, all with the same type and subtype eg "es"
+   */
+  void addClusters(const Clusters& clusters);
+  /**
+   *   @brief  Adds tracks made outside PAPAS to the event (see addClusters). Each track needs a path, see
+   *           makeTrackPath.
+   *   @param[in]  tracks tracks, all with the same subtype eg 's'
+   */
+  void addTracks(const Tracks& tracks);
+  /**
+   *   @brief  Makes the path of a charged track in the detector field. The points where it crosses the detector
+   *           cylinders are only computed if they are asked for (eg when the track is linked to a cluster).
+   *   @param[in]  p3 momentum of the track
+   *   @param[in]  charge charge of the track
+   *   @param[in]  vertex start of the track
+   */
+  std::shared_ptr<Path> makeTrackPath(const TVector3& p3, double charge, const TVector3& vertex) const;
+  /// Number of blocks of each topology reconstructed since construction or the last resetTopologyCounts
+  /// (not reset by clear)
+  const PFReconstructor::TopologyCounts& topologyCounts() const { return m_topologyCounts; }
+  void resetTopologyCounts() { m_topologyCounts.fill(0); }  ///< Set all topology counts to zero
+  /**
+   *   @brief  Sets how long collections are kept, it applies to the stages run after it is called.
+   *           Pruned retention assumes that each stage is run once per event, in the usual order.
+   *   @param[in]  retention kKeepAll or kPruned
+   *   @param[in]  kept collections that are never released in pruned mode eg {"es", "hs"}
+   */
+  void setRetention(Retention retention, const std::vector<std::string>& kept = {});
+  Retention retention() const { return m_retention; }  ///< see setRetention
+
+protected:
   Blocks& createBlocks();      ///<  Create an empty concrete collection of blocks ready for filling by an algorithm
+  /// Sets how many later stages will read a collection (pruned retention), it is released at once if there are none
+  void declareReaders(const std::string& typeAndSubtype, unsigned int nReaders);
+  /// A stage has read these collections, those with no readers left are released (pruned retention)
+  void read(const std::vector<std::string>& typeAndSubtypes);
+  void release(const std::string& typeAndSubtype);  ///< Removes a collection from the Event and deletes it
   const Detector& m_detector;
 
   std::list<Clusters> m_ownedClustersList;    ///<Holds all the clusters collections created during an event
@@ -105,7 +180,15 @@ protected:
   std::list<Blocks> m_ownedBlocksList;        ///<Holds all the blocks collections created during an event
   std::list<Particles> m_ownedParticlesList;  ///<Holds all the particles collections created during an event
   Nodes m_history;                            ///< Holds all the history information
+  PFReconstructor::TopologyCounts m_topologyCounts;  ///< blocks reconstructed for each topology, summed over events
   Event m_event;  ///< object that can be passed to algorithms to allow access to objects such as a track
+  Retention m_retention;                                    ///< how long collections are kept
+  std::vector<std::string> m_kept;                          ///< collections never released in pruned mode
+  std::unordered_map<std::string, unsigned int> m_readers;  ///< stages still to read each collection (pruned mode)
+  /// collections whose objects are referred to by the objects of a collection (eg "em" -> "es"), these are read
+  /// whenever it is read
+  std::unordered_map<std::string, std::vector<std::string>> m_sources;
+  std::vector<std::string> m_blockInputs;  ///< collections the blocks were built from, read by reconstruct
 
   // bool operator()(Identifier i, Identifier j);//todo reinstate was used for sorting ids
 };
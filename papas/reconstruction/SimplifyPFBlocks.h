@@ -14,7 +14,8 @@ class PFBlock;
  The goal is to remove, if needed, some links from the block so that each track links to
  at most one hcal within a block. In some cases this may separate a block into smaller
  blocks. The new smaller blocks are added into the externally owned simplifiedBlocks colelctions.
- If a block is unchanged its content will be copied into a new Block with a new Block Id and stored in simplifiedBlocks.
+ If a block is unchanged a new Block with a new Block Id, which shares the edges of the original block, is stored in
+ simplifiedBlocks.
  The history is updated so that the simplified blocks will have the tracks and cluster elements as parents.
 
  Usage example:
@@ -36,20 +37,22 @@ void simplifyPFBlocks(const Event& event, char blockSubtype, Blocks& simplifiedb
 /**
  * Does the main work to simplify a block and add to the simplifiedBlocks collection
    The function takes each block in turn and looks to see if any links can be dropped.
-   It then uses the new links to create the simplified blocks.
-   The new blocks are placed in separate blocks collection with subtype 's'.
-   Note: For any blocks that are not simplified, a copy of the original PFBlock is taken and placed in the simplified
-    blocks collection. The simplified block collection is therefore complete and free standing.
- * @param[in] edges contains collections of tracks, clusters and history
+   It then uses the new links to regroup the elements of the block into the simplified blocks.
+   The new blocks are placed in separate blocks collection with subtype 's'. They share the EdgeStore of the original
+   block and record the removed links as unlinked edge keys, so no edges are copied.
+   Note: For any blocks that are not simplified, a new PFBlock with the same elements and edges is placed in the
+    simplified blocks collection. The simplified block collection is therefore complete.
+ * @param[in] toUnlink keys of the edges that are to be unlinked
  * @param[in] block Block which is to be simplified
  * @param[inout] simplifiedBlocks externally owned structure into which simplified blocks will be added
  * @param[inout] history externally owned structure to which history information will be added
 */
-void simplifyPFBlock(const Edges& edges, const PFBlock& block, Blocks& simplifiedblocks, Nodes& history);
+void simplifyPFBlock(const EdgeKeys& toUnlink, const PFBlock& block, Blocks& simplifiedblocks, Nodes& history);
 
-/** Checks PFBlock and removes unneeded edge links
+/** Checks PFBlock and finds unneeded edge links
  * @param[in] block Block which is to be simplified
+ * @return keys of the edges that should be unlinked
  */
-Edges edgesToUnlink(const PFBlock& block);
+EdgeKeys edgesToUnlink(const PFBlock& block);
 }  // end namespace papas
 #endif /* SimplifyPFBlocks_h */
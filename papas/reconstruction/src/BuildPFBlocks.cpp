@@ -3,6 +3,7 @@
 #include "papas/datatypes/Event.h"
 #include "papas/graphtools/BuildSubGraphs.h"
 #include "papas/graphtools/Distance.h"
+#include "papas/graphtools/EdgeStore.h"
 #include "papas/graphtools/EventRuler.h"
 #include "papas/graphtools/FloodFill.h"
 #include "papas/utility/PDebug.h"
@@ -10,31 +11,31 @@
 namespace papas {
 
 void buildPFBlocks(const Event& event, IdCoder::SubType ecalSubtype, IdCoder::SubType hcalSubtype, char trackSubtype,
-                   Blocks& blocks, Nodes& history) {
+                   Blocks& blocks, Nodes& history, double maxUnlinkedDistance) {
 
   auto ecalids = event.collectionIds(IdCoder::ItemType::kEcalCluster, ecalSubtype);
   auto hcalids = event.collectionIds(IdCoder::ItemType::kHcalCluster, hcalSubtype);
   auto trackids = event.collectionIds(IdCoder::ItemType::kTrack, trackSubtype);
-  // the ids should all be in the right order, so I wonder what the most efficient way to merge them would be?
 
-  Edges edges;
+  // only the linked (or nearby) edges are kept.
+  // The ids are registered ecals, hcals then tracks so that the edges below are added in sorted order
+  auto edges = std::make_shared<EdgeStore>(maxUnlinkedDistance);
+  for (const auto* collection : {&ecalids, &hcalids, &trackids})
+    for (auto id : *collection)
+      edges->addId(id);
   // distances/links for tracks to ecals
   EventRuler ruler(event);
   for (auto id1 : ecalids) {
     for (auto id2 : trackids) {
       Distance dist = ruler.distance(id1, id2);
-      Edge edge{id1, id2, dist.isLinked(), dist.distance()};
-      // the edge object is added into the edges dictionary
-      edges.emplace(edge.key(), std::move(edge));
+      edges->addEdge(id1, id2, dist.isLinked(), dist.distance());
     }
   }
   // distances/links for tracks to hcals
   for (auto id1 : hcalids) {
-    for (auto id2 : trackids) {  // trac
+    for (auto id2 : trackids) {
       Distance dist = ruler.distance(id1, id2);
-      Edge edge{id1, id2, dist.isLinked(), dist.distance()};
-      // the edge object is added into the edges dictionary
-      edges.emplace(edge.key(), std::move(edge));
+      edges->addEdge(id1, id2, dist.isLinked(), dist.distance());
     }
   }
   // the ids should all be in the right order, so I wonder what the most efficient way to merge them would be?
@@ -51,7 +52,19 @@ void buildPFBlocks(const Ids& ids, const Edges& edges, char subtype, Blocks& blo
     PDebug::write("Made {}", block);
     // put the block in the unordered map of blocks using move
     Identifier id = block.id();
-    makeHistoryLinks(block.elementIds(), {id}, history);
+    makeBlockHistoryLinks(block.elementIds(), id, history);
+    blocks.emplace(id, std::move(block));
+  }
+}
+
+void buildPFBlocks(const Ids& ids, std::shared_ptr<const EdgeStore> edges, char subtype, Blocks& blocks,
+                   Nodes& history, const EdgeKeys& unlinked) {
+  std::list<Ids> subGraphs = buildSubGraphs(ids, *edges, unlinked);
+  for (const auto& elementIds : subGraphs) {
+    PFBlock block(elementIds, edges, blocks.size(), subtype, unlinked);  // make the block, the edges are shared
+    PDebug::write("Made {}", block);
+    Identifier id = block.id();
+    makeBlockHistoryLinks(block.elementIds(), id, history);
     blocks.emplace(id, std::move(block));
   }
 }
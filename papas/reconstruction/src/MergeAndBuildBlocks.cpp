@@ -0,0 +1,131 @@
+#include "papas/reconstruction/MergeAndBuildBlocks.h"
+
+#include "papas/datatypes/Event.h"
+#include "papas/graphtools/ConnectedComponents.h"
+#include "papas/graphtools/Distance.h"
+#include "papas/graphtools/EdgeStore.h"
+#include "papas/graphtools/Ruler.h"
+#include "papas/reconstruction/PFBlock.h"
+#include "papas/utility/Metrics.h"
+#include "papas/utility/PDebug.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace papas {
+
+namespace {
+
+/// the objects of a collection in decreasing id order, which is the order of the ids in a (sorted) Ids set
+template <class T>
+std::vector<const T*> byDecreasingId(const std::unordered_map<Identifier, T>& collection) {
+  std::vector<const T*> objects;
+  objects.reserve(collection.size());
+  for (const auto& it : collection)
+    objects.push_back(&it.second);
+  std::sort(objects.begin(), objects.end(), [](const T* a, const T* b) { return a->id() > b->id(); });
+  return objects;
+}
+
+/// merges the clusters as mergeClusters does and returns the merged clusters in decreasing id order
+std::vector<const Cluster*> merge(const Clusters& clusters, const Ruler& ruler, Clusters& merged, Nodes& history) {
+  auto sorted = byDecreasingId(clusters);
+  uint32_t n = sorted.size();
+  // the links use positions in increasing id order, so position n - 1 - i is sorted[i]
+  std::vector<ConnectedComponents::Link> links;
+  for (uint32_t i = 0; i < n; ++i) {
+    for (uint32_t j = i + 1; j < n; ++j) {
+      Distance dist = ruler.clusterClusterDistance(*sorted[j], *sorted[i]);  // smaller id first
+      if (dist.isLinked()) links.emplace_back(n - 1 - j, n - 1 - i);
+    }
+  }
+  Metrics::add(Metrics::kClustersIn, n);
+  Metrics::add(Metrics::kDistanceEvaluations, n > 1 ? (uint64_t)n * (n - 1) / 2 : 0);
+  Metrics::add(Metrics::kEdgesCreated, links.size());
+  Metrics::add(Metrics::kEdgesLinked, links.size());
+
+  // the subgraphs in order of their smallest id, each with its clusters in decreasing id order
+  auto labels = ConnectedComponents::labels(n, links);
+  std::vector<std::list<const Cluster*>> subGraphs;
+  std::vector<int> subGraphOfLabel(n, -1);
+  for (uint32_t p = 0; p < n; ++p) {
+    auto& s = subGraphOfLabel[labels[p]];
+    if (s < 0) {
+      s = subGraphs.size();
+      subGraphs.emplace_back();
+    }
+    subGraphs[s].push_front(sorted[n - 1 - p]);
+  }
+  Metrics::add(Metrics::kMergedClustersOut, subGraphs.size());
+  for (const auto& overlappingClusters : subGraphs) {
+    Ids parentIds;
+    for (const auto* cluster : overlappingClusters)
+      parentIds.insert(cluster->id());
+    Cluster mergedCluster(overlappingClusters, merged.size(), 'm');
+    makeHistoryLinks(parentIds, {mergedCluster.id()}, history);
+    PDebug::write("Made Merged{}", mergedCluster);
+    merged.emplace(mergedCluster.id(), std::move(mergedCluster));
+  }
+  return byDecreasingId(merged);
+}
+
+}  // end anonymous namespace
+
+void mergeAndBuildPFBlocks(const Event& event, IdCoder::SubType ecalSubtype, IdCoder::SubType hcalSubtype,
+                           char trackSubtype, Clusters& mergedEcals, Clusters& mergedHcals, Blocks& blocks,
+                           Nodes& history, double maxUnlinkedDistance) {
+  Ruler ruler;
+  auto ecals = merge(event.clusters(IdCoder::kEcalCluster, ecalSubtype), ruler, mergedEcals, history);
+  auto hcals = merge(event.clusters(IdCoder::kHcalCluster, hcalSubtype), ruler, mergedHcals, history);
+  auto tracks = byDecreasingId(event.tracks(trackSubtype));
+
+  // the store is filled exactly as buildPFBlocks does: ecals, hcals then tracks, each in Ids order
+  auto edges = std::make_shared<EdgeStore>(maxUnlinkedDistance);
+  for (const auto* clusters : {&ecals, &hcals})
+    for (const auto* cluster : *clusters)
+      edges->addId(cluster->id());
+  for (const auto* track : tracks)
+    edges->addId(track->id());
+  for (const auto* clusters : {&ecals, &hcals}) {
+    for (const auto* cluster : *clusters) {
+      for (const auto* track : tracks) {
+        Distance dist = ruler.clusterTrackDistance(*cluster, *track);
+        edges->addEdge(cluster->id(), track->id(), dist.isLinked(), dist.distance());
+      }
+    }
+  }
+  Metrics::add(Metrics::kDistanceEvaluations, (ecals.size() + hcals.size()) * tracks.size());
+
+  // connected components of the local indices of the store, the blocks are made in order of their smallest id
+  // which means going through each of the ecal, hcal and track ranges of the store backwards
+  uint32_t nIds = edges->numIds();
+  std::vector<ConnectedComponents::Link> links;
+  for (const auto& link : edges->links())
+    if (link.isLinked) links.emplace_back(link.end1, link.end2);
+  auto labels = ConnectedComponents::labels(nIds, links);
+  std::vector<Ids> subGraphs;
+  std::vector<int> subGraphOfLabel(nIds, -1);
+  uint32_t begin = 0;
+  for (std::size_t size : {ecals.size(), hcals.size(), tracks.size()}) {
+    for (uint32_t i = begin + size; i-- > begin;) {
+      auto& s = subGraphOfLabel[labels[i]];
+      if (s < 0) {
+        s = subGraphs.size();
+        subGraphs.emplace_back();
+      }
+      subGraphs[s].insert(edges->id(i));
+    }
+    begin += size;
+  }
+  for (const auto& elementIds : subGraphs) {
+    PFBlock block(elementIds, edges, blocks.size(), 'r');  // the edges are shared
+    PDebug::write("Made {}", block);
+    Identifier id = block.id();
+    makeBlockHistoryLinks(block.elementIds(), id, history);
+    blocks.emplace(id, std::move(block));
+  }
+}
+
+}  // end namespace papas
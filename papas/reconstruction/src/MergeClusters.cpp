@@ -3,32 +3,39 @@
 #include "papas/datatypes/Event.h"
 #include "papas/graphtools/BuildSubGraphs.h"
 #include "papas/graphtools/Distance.h"
+#include "papas/graphtools/EdgeStore.h"
 #include "papas/graphtools/EventRuler.h"
+#include "papas/utility/Metrics.h"
 #include "papas/utility/PDebug.h"
 
 #include <algorithm>
+#include <vector>
 
 namespace papas {
 
 void mergeClusters(const Event& event, const std::string& typeAndSubtype, const EventRuler& ruler, Clusters& merged,
-                   Nodes& history) {
+                   Nodes& history, double maxUnlinkedDistance) {
   auto ids = event.collectionIds(typeAndSubtype);
 
-  // create unordered map containing all edge combinations, index them by edgeKey
-  // the edges describe the distance between pairs of clusters
-  Edges edges;
-  for (auto id1 : ids) {
-    for (auto id2 : ids) {
-      if (id1 < id2) {
-        Distance dist = ruler.distance(id1, id2);
-        Edge edge{id1, id2, dist.isLinked(), dist.distance()};
-        edges.emplace(edge.key(), std::move(edge));
-      }
+  // find the distance between every pair of clusters but only keep the edges that are linked (or are within
+  // maxUnlinkedDistance). The ids are registered first so that the edges are added to the store in sorted order
+  std::vector<Identifier> idvec(ids.begin(), ids.end());
+  EdgeStore edges(maxUnlinkedDistance);
+  for (auto id : idvec)
+    edges.addId(id);
+  for (std::size_t i = 0; i < idvec.size(); ++i) {
+    for (std::size_t j = i + 1; j < idvec.size(); ++j) {
+      auto id1 = std::min(idvec[i], idvec[j]);
+      auto id2 = std::max(idvec[i], idvec[j]);
+      Distance dist = ruler.distance(id1, id2);
+      edges.addEdge(id1, id2, dist.isLinked(), dist.distance());
     }
   }
   // create a graph using the ids and the edges this will produces subgroups of ids each of which will form
   // a new merged cluster.
   auto subGraphs = buildSubGraphs(ids, edges);
+  Metrics::add(Metrics::kClustersIn, ids.size());
+  Metrics::add(Metrics::kMergedClustersOut, subGraphs.size());
 
   /* Note on debate as to safety of storing const Cluster* in overlappingClusters.
     In particular the question "Could the Clusters that are being pointed to move and thus the pointers become
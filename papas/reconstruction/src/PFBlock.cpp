@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <iomanip>  //needed for lxplus
+#include <limits>
 #include <vector>
 
+#include "papas/graphtools/EdgeStore.h"
 #include "papas/utility/PDebug.h"
 
 namespace papas {
@@ -20,24 +22,35 @@ PFBlock::~PFBlock() {
   // everything looks fine just before (the Block prints correctly) but
   // when this point is reached it has id of zero and a ridiculous size for m_edges.
   m_elementIds.clear();
-  m_edges.clear();
+  m_unlinkedKeys.clear();
 };
 
 PFBlock::PFBlock(const Ids& element_ids, const Edges& edges, uint32_t index, char subtype)
     : m_id(IdCoder::makeId(index, IdCoder::kBlock, subtype, element_ids.size())), m_elementIds(element_ids) {
-  // copy the relevant parts of the complete set of edges and store this within the block
+  // copy the relevant parts of the complete set of edges into an EdgeStore owned by this block
+  // all of the edges are kept, including unlinked ones, with their exact distances
+  auto store = std::make_shared<EdgeStore>(std::numeric_limits<double>::max(), true);
+  for (auto id : m_elementIds)
+    store->addId(id);
   for (auto id1 : m_elementIds) {
     for (auto id2 : m_elementIds) {
       if (id1 >= id2) continue;
-      // copy the edge from one unordered map to the other
       auto e = edges.find(Edge::makeKey(id1, id2));
       if (e != edges.end()) {
-        m_edges.emplace(e->first, e->second);  // I checked - this copies the edge
+        store->addEdge(e->second.endIds()[0], e->second.endIds()[1], e->second.isLinked(), e->second.distance());
       }
     }
   }
+  m_edgeStore = store;
 }
 
+PFBlock::PFBlock(const Ids& element_ids, std::shared_ptr<const EdgeStore> edges, uint32_t index, char subtype,
+                 const EdgeKeys& unlinkedKeys)
+    : m_id(IdCoder::makeId(index, IdCoder::kBlock, subtype, element_ids.size())),
+      m_elementIds(element_ids),
+      m_edgeStore(edges),
+      m_unlinkedKeys(unlinkedKeys) {}
+
 int PFBlock::countEcal() const {
   // Counts how many ecal cluster ids are in the block
   return std::count_if(m_elementIds.begin(), m_elementIds.end(), [](Identifier elem) { return IdCoder::isEcal(elem); });
@@ -64,23 +77,43 @@ std::string PFBlock::shortName() const {
   return out.str();
 }
 
-const Edge& PFBlock::edge(Edge::EdgeKey key) const {
-  auto edge = m_edges.find(key);
-  if (edge == m_edges.end()) throw std::range_error("Edge not found");
-  return edge->second;
+Edge PFBlock::edge(Edge::EdgeKey key) const {
+  Edge e = m_edgeStore->edge(key);  // the store is indexed by the unique ids that make up the key
+  if (!hasElement(e.endIds()[0]) || !hasElement(e.endIds()[1])) throw std::range_error("Edge not found");
+  if (e.isLinked() && m_unlinkedKeys.find(key) != m_unlinkedKeys.end()) e.setLinked(false);
+  return e;
+}
+
+Edge PFBlock::edge(Identifier id1, Identifier id2) const {
+  if (!hasElement(id1) || !hasElement(id2)) throw std::range_error("Edge not found");
+  Edge e = m_edgeStore->edge(id1, id2);
+  if (e.isLinked() && m_unlinkedKeys.find(e.key()) != m_unlinkedKeys.end()) e.setLinked(false);
+  return e;
 }
 
-const Edge& PFBlock::edge(Identifier id1, Identifier id2) const { return edge(Edge::makeKey(id1, id2)); }
+Edges PFBlock::edges() const {
+  Edges edges;
+  visitEdges([&edges](const Edge& e) { edges.emplace(e.key(), e); });
+  return edges;
+}
+
+std::size_t PFBlock::numEdges() const {
+  std::size_t count = 0;
+  visitEdges([&count](const Edge&) { ++count; });
+  return count;
+}
 
 std::list<Edge::EdgeKey> PFBlock::linkedEdgeKeys(Identifier id, Edge::EdgeType matchtype) const {
   std::list<Edge::EdgeKey> linkedEdgeKeys;
-  for (auto const& edge : m_edges) {
-    // if this is an edge that includes the id
-    if (edge.second.isLinked() && edge.second.otherId(id) > 0) {
-      // include in list if either no matchtype is specified or if the edge is of the same matchtype
-      if ((matchtype == Edge::EdgeType::kUnknown) || matchtype == edge.second.edgeType())
-        linkedEdgeKeys.push_back(edge.first);
-    }
+  if (!hasElement(id) || !m_edgeStore->hasId(id)) return linkedEdgeKeys;
+  for (auto neighbour : m_edgeStore->linkedNeighbours(m_edgeStore->index(id))) {
+    auto otherId = m_edgeStore->id(neighbour);
+    if (!hasElement(otherId)) continue;  // the store may be shared with other blocks
+    auto key = Edge::makeKey(id, otherId);
+    if (m_unlinkedKeys.find(key) != m_unlinkedKeys.end()) continue;
+    // include in list if either no matchtype is specified or if the edge is of the same matchtype
+    if ((matchtype == Edge::EdgeType::kUnknown) || matchtype == Edge(id, otherId, true, 0).edgeType())
+      linkedEdgeKeys.push_back(key);
   }
   return linkedEdgeKeys;  // todo consider sorting
 }
@@ -88,10 +121,13 @@ std::list<Edge::EdgeKey> PFBlock::linkedEdgeKeys(Identifier id, Edge::EdgeType m
 Ids PFBlock::linkedIds(Identifier id, Edge::EdgeType edgetype) const {
   /// Returns list of all linked ids of a given edge type that are connected to a given id -
   Ids linkedIds;
-  for (auto key : linkedEdgeKeys(id, edgetype)) {
-    auto found = m_edges.find(key);
-    if (found == m_edges.end()) throw std::range_error("Required EdgeKey is missing from Linked Edges collection");
-    linkedIds.insert(found->second.otherId(id));
+  if (!hasElement(id) || !m_edgeStore->hasId(id)) return linkedIds;
+  for (auto neighbour : m_edgeStore->linkedNeighbours(m_edgeStore->index(id))) {
+    auto otherId = m_edgeStore->id(neighbour);
+    if (!hasElement(otherId)) continue;  // the store may be shared with other blocks
+    if (!m_unlinkedKeys.empty() && m_unlinkedKeys.find(Edge::makeKey(id, otherId)) != m_unlinkedKeys.end()) continue;
+    if ((edgetype == Edge::EdgeType::kUnknown) || edgetype == Edge(id, otherId, true, 0).edgeType())
+      linkedIds.insert(otherId);
   }
   return linkedIds;
 }
@@ -175,10 +211,7 @@ bool PFBlock::hasEdge(Identifier id1, Identifier id2) const {
   ///                      Note that make_key deals with whether it is get_edge(e1, e2) or get_edge(e2, e1) (either
   ///                      order gives same result)
   ///
-  bool found = true;
-  auto edge = m_edges.find(Edge::makeKey(id1, id2));
-  if (edge == m_edges.end()) found = false;
-  return found;
+  return hasElement(id1) && hasElement(id2) && m_edgeStore->hasEdge(id1, id2);
 }
 
 std::string PFBlock::info() const {  // One liner summary of PFBlock
@@ -191,7 +224,7 @@ std::string PFBlock::info() const {  // One liner summary of PFBlock
 std::ostream& operator<<(std::ostream& os, const PFBlock& block) {
   os << "block:" << block.info() << std::endl;
   os << block.elementsString();
-  if (block.edges().size() > 0) {
+  if (block.numEdges() > 0) {
     os << block.edgeMatrixString();
   }
   return os;
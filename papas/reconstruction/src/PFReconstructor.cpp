@@ -13,22 +13,35 @@
 #include "papas/graphtools/Edge.h"
 #include "papas/simulation/HelixPropagator.h"
 #include "papas/simulation/StraightLinePropagator.h"
+#include "papas/utility/Metrics.h"
 #include "papas/utility/PDebug.h"
+#include "papas/utility/Timeline.h"
 
 namespace papas {
 
 PFReconstructor::PFReconstructor(const Event& event, char blockSubtype, const Detector& detector, Particles& particles,
                                  Nodes& history)
-    : m_event(event), m_detector(detector), m_particles(particles), m_history(history) {
+    : m_event(event),
+      m_historyHelper(event),
+      m_detector(detector),
+      m_particles(particles),
+      m_history(history),
+      m_topologyCounts() {
   m_propHelix = std::make_shared<HelixPropagator>(detector.field());
   m_propStraight = std::make_shared<StraightLinePropagator>(detector.field());
   auto blockids = m_event.collectionIds(IdCoder::ItemType::kBlock, blockSubtype);
   for (auto bid : blockids) {
     reconstructBlock(m_event.block(bid));
   }
-  if (m_unused.size() > 0) {
+  if (!m_unused.empty()) {
     PDebug::write("unused elements ");
-    for (auto u : m_unused)
+    // collect the ids so that they are written out in order
+    Ids unused;
+    for (auto bid : blockids) {
+      for (auto id : m_event.block(bid).elementIds())
+        if (m_unused.test(id)) unused.insert(id);
+    }
+    for (auto u : unused)
       PDebug::write("{},", u);
     // TODO warning message
   }
@@ -40,29 +53,93 @@ PFReconstructor::~PFReconstructor() {  // needed to avoid seg fault (may be conn
   m_unused.clear();
 };
 
+PFReconstructor::Topology PFReconstructor::topology(const PFBlock& block) {
+  // classify using the types of the (at most two) elements
+  const auto& ids = block.elementIds();
+  if (ids.size() == 1) {
+    auto id = *ids.begin();
+    if (IdCoder::isEcal(id)) return kE1;
+    if (IdCoder::isHcal(id)) return kH1;
+    if (IdCoder::isTrack(id)) return kT1;
+  } else if (ids.size() == 2) {
+    auto id1 = *ids.begin();
+    auto id2 = *std::next(ids.begin());
+    if (IdCoder::isTrack(id1) != IdCoder::isTrack(id2)) {
+      auto clusterId = IdCoder::isTrack(id1) ? id2 : id1;
+      if (IdCoder::isEcal(clusterId)) return kE1T1;
+      if (IdCoder::isHcal(clusterId)) return kH1T1;
+    }
+  }
+  return kOther;
+}
+
+const char* PFReconstructor::topologyName(Topology topology) {
+  static const char* names[] = {"E1", "H1", "T1", "E1T1", "H1T1", "other"};
+  return (topology < kNumTopologies) ? names[topology] : "unknown";
+}
+
 void PFReconstructor::reconstructBlock(const PFBlock& block) {
   // see class description for summary of reconstruction approach
+  // The common small topologies are handled directly, they give exactly the same results as the general algorithm
+  Timeline::Span span("reconstruct block", "block", block.size());
   PDebug::write("Processing {}", block);
-  Ids ids = block.elementIds();
+  const Ids& ids = block.elementIds();
   for (auto id : ids) {
-    m_locked[id] = false;
+    m_locked.reset(id);
+  }
+  if (Metrics::isOn()) Metrics::addBlock(block.shortName(), block.size());
+  auto blockTopology = topology(block);
+  m_topologyCounts[blockTopology]++;
+  switch (blockTopology) {
+  case kE1:
+    reconstructSingleCluster(block, *ids.begin(), papas::Layer::kEcal);
+    break;
+  case kH1:
+    reconstructSingleCluster(block, *ids.begin(), papas::Layer::kHcal);
+    break;
+  case kT1:
+    reconstructSingleTrack(block, *ids.begin());
+    break;
+  case kE1T1:
+  case kH1T1: {
+    auto id1 = *ids.begin();
+    auto id2 = *std::next(ids.begin());
+    auto trackId = IdCoder::isTrack(id1) ? id1 : id2;
+    auto clusterId = IdCoder::isTrack(id1) ? id2 : id1;
+    if (blockTopology == kE1T1)
+      reconstructEcalTrack(block, clusterId, trackId);
+    else
+      reconstructHcalTrack(block, clusterId, trackId);
+    break;
   }
+  default:
+    reconstructGeneralBlock(block);
+  }
+  for (auto id : ids) {
+    if (!m_locked.test(id)) {
+      m_unused.set(id);
+    }
+  }
+  PDebug::write("Finished block", IdCoder::pretty(block.id()));
+}
+
+void PFReconstructor::reconstructGeneralBlock(const PFBlock& block) {
+  Ids ids = block.elementIds();
   reconstructMuons(block);
   reconstructElectrons(block);
   // keeping only the elements that have not been used so far
   Ids uids;
   for (auto id : ids) {
-    if (!m_locked[id]) uids.insert(id);
+    if (!m_locked.test(id)) uids.insert(id);
   }
   if (uids.size() == 1) {  //#TODO WARNING!!! LOTS OF MISSING CASES
     Identifier id = *uids.begin();
-    auto parentIds = Ids{block.id(), id};
     if (IdCoder::isEcal(id)) {
-      reconstructCluster(m_event.cluster(id), papas::Layer::kEcal, parentIds);
+      reconstructCluster(m_event.cluster(id), papas::Layer::kEcal, {block.id(), id});
     } else if (IdCoder::isHcal(id)) {
-      reconstructCluster(m_event.cluster(id), papas::Layer::kHcal, parentIds);
+      reconstructCluster(m_event.cluster(id), papas::Layer::kHcal, {block.id(), id});
     } else if (IdCoder::isTrack(id)) {
-      reconstructTrack(m_event.track(id), 211, parentIds);
+      reconstructTrack(m_event.track(id), 211, {block.id(), id});
     } else {  // ask Colin about energy balance - what happened to the associated clusters that one would expect?
               // TODO
     }
@@ -73,25 +150,60 @@ void PFReconstructor::reconstructBlock(const PFBlock& block) {
       }
     }
     for (auto id : ids) {
-      if (IdCoder::isTrack(id) && !m_locked[id]) {
+      if (IdCoder::isTrack(id) && !m_locked.test(id)) {
         /* unused tracks, so not linked to HCAL
          # reconstructing charged hadrons*/
-        auto parentIds = Ids{block.id(), id};
-        reconstructTrack(m_event.track(id), 211, parentIds);
+        reconstructTrack(m_event.track(id), 211, {block.id(), id});
         for (auto idlink : block.linkedIds(id, Edge::EdgeType::kEcalTrack)) {
           // TODO ask colin what happened to possible photons here:
           // TODO add in extra photons but decide where they should go?
-          m_locked[idlink] = true;
+          m_locked.set(idlink);
         }
       }
     }
   }
-  for (auto& id : ids) {
-    if (!m_locked[id]) {
-      m_unused.insert(id);
-    }
+}
+
+void PFReconstructor::reconstructSingleCluster(const PFBlock& block, Identifier clusterId, papas::Layer layer) {
+  reconstructCluster(m_event.cluster(clusterId), layer, {block.id(), clusterId});
+}
+
+void PFReconstructor::reconstructSingleTrack(const PFBlock& block, Identifier trackId) {
+  reconstructLeptons(block, trackId);
+  if (!m_locked.test(trackId)) reconstructTrack(m_event.track(trackId), 211, {block.id(), trackId});
+}
+
+void PFReconstructor::reconstructEcalTrack(const PFBlock& block, Identifier ecalId, Identifier trackId) {
+  reconstructLeptons(block, trackId);
+  if (m_locked.test(trackId)) {
+    // only the ecal is left
+    reconstructCluster(m_event.cluster(ecalId), papas::Layer::kEcal, {block.id(), ecalId});
+  } else {
+    reconstructTrack(m_event.track(trackId), 211, {block.id(), trackId});
+    // the two elements of a block are linked, so the ecal is used up by the track
+    m_locked.set(ecalId);
+  }
+}
+
+void PFReconstructor::reconstructHcalTrack(const PFBlock& block, Identifier hcalId, Identifier trackId) {
+  reconstructLeptons(block, trackId);
+  const Cluster& hcal = m_event.cluster(hcalId);
+  if (m_locked.test(trackId)) {
+    // only the hcal is left
+    reconstructCluster(hcal, papas::Layer::kHcal, {block.id(), hcalId});
+  } else {
+    // as reconstructHcal but with a single track and no ecals
+    const Track& track = m_event.track(trackId);
+    reconstructTrack(track, 211, {block.id(), trackId, hcalId});
+    reconstructHcalExcess(block, hcal, Ids(), 0., track.energy());
+    m_locked.set(hcalId);
   }
-  PDebug::write("Finished block", IdCoder::pretty(block.id()));
+}
+
+void PFReconstructor::reconstructLeptons(const PFBlock& block, Identifier trackId) {
+  // same as reconstructMuons followed by reconstructElectrons for a block with one track
+  if (isFromParticle(trackId, "ps", 13)) reconstructTrack(m_event.track(trackId), 13, {block.id(), trackId});
+  if (isFromParticle(trackId, "ps", 11)) reconstructTrack(m_event.track(trackId), 11, {block.id(), trackId});
 }
 
 void PFReconstructor::reconstructMuons(const PFBlock& block) {
@@ -100,8 +212,7 @@ void PFReconstructor::reconstructMuons(const PFBlock& block) {
   for (auto id : ids) {
     if (IdCoder::isTrack(id) && isFromParticle(id, "ps", 13)) {
 
-      auto parentIds = Ids{block.id(), id};
-      reconstructTrack(m_event.track(id), 13, parentIds);
+      reconstructTrack(m_event.track(id), 13, {block.id(), id});
     }
   }
 }
@@ -116,13 +227,13 @@ void PFReconstructor::reconstructElectrons(const PFBlock& block) {
   for (auto id : ids) {
     if (IdCoder::isTrack(id) && isFromParticle(id, "ps", 11)) {
 
-      auto parentIds = Ids{block.id(), id};
-      reconstructTrack(m_event.track(id), 11, parentIds);
+      reconstructTrack(m_event.track(id), 11, {block.id(), id});
     }
   }
 }
 
-void PFReconstructor::insertParticle(const Ids& parentIds, Particle& newparticle) {
+template <typename P>
+void PFReconstructor::insertParticle(const P& parentIds, Particle& newparticle) {
   /* The new particle will be inserted into the history_nodes (if present).
    A new node for the particle will be created if needed.
    It will have as its parents the block and all the elements of the block.
@@ -133,19 +244,27 @@ void PFReconstructor::insertParticle(const Ids& parentIds, Particle& newparticle
   // if (newparticle) :
   Identifier newid = newparticle.id();
   m_particles.emplace(newid, std::move(newparticle));
-  makeHistoryLinks(parentIds, {newid}, m_history);
+  if (historyLevel() == HistoryLevel::kTruth) {
+    // there are no blocks in the truth history, the particle is linked to the elements it was made from
+    for (auto id : parentIds)
+      if (!IdCoder::isBlock(id)) makeHistoryLink(id, newid, m_history);
+  } else
+    makeHistoryLinks(parentIds, newid, m_history);
 }
 
 bool PFReconstructor::isFromParticle(Identifier id, const std::string& typeAndSubtype, int pdgid) const {
   /*returns: True if object identifier comes, directly or indirectly,
    from a particle of type type_and_subtype, with this absolute pdgid.
    */
-  auto historyHelper = HistoryHelper(m_event);
-  auto parentIds = historyHelper.linkedIds(id, typeAndSubtype, DAG::enumVisitType::PARENTS);
   bool isFromPdgId = false;
-  for (auto pid : parentIds) {
-    if (abs(m_event.particle(pid).pdgId()) == abs(pdgid)) isFromPdgId = true;
-  }
+  if (m_event.history().find(id) == m_event.history().end()) return false;  // no history was recorded
+  // stops at the first matching parent
+  m_historyHelper.visitLinkedIds(id, DAG::enumVisitType::PARENTS, [&](Identifier pid) {
+    if (IdCoder::typeLetter(pid) == typeAndSubtype[0] && IdCoder::subtype(pid) == typeAndSubtype[1] &&
+        abs(m_event.particle(pid).pdgId()) == abs(pdgid))
+      isFromPdgId = true;
+    return !isFromPdgId;
+  });
   return isFromPdgId;
 }
 
@@ -196,9 +315,9 @@ void PFReconstructor::reconstructHcal(const PFBlock& block, Identifier hcalId) {
        # Maybe we want to link ecals to their closest track etc?
        # this might help with history work
        # ask colin.*/
-      if (!m_locked[ecalId]) {
+      if (!m_locked.test(ecalId)) {
         ecalIds.insert(ecalId);
-        m_locked[ecalId] = true;
+        m_locked.set(ecalId);
       }
     }
   }
@@ -222,45 +341,57 @@ void PFReconstructor::reconstructHcal(const PFBlock& block, Identifier hcalId) {
     for (auto id : ecalIds) {
       ecalEnergy += m_event.cluster(id).energy();
     }
-    double deltaERel = (hcalEnergy + ecalEnergy) / trackEnergy - 1.;
-    double caloERes = neutralHadronEnergyResolution(trackEnergy, hcal.eta());
-    if (deltaERel > nsigmaHcal(hcal) * caloERes) {  //# approx means hcal energy + ecal energies > track energies
-
-      double excess = deltaERel * trackEnergy;  // energy in excess of track energies
-      // print( 'excess = {excess:5.2f}, ecal_E = {ecal_e:5.2f}, diff = {diff:5.2f}'.format(
-      //   excess=excess, ecal_e = ecal_energy, diff=excess-ecal_energy))
-      if (excess <= ecalEnergy) { /* # approx means hcal energy > track energies
-                                   # Make a photon from the ecal energy
-                                   # We make only one photon using only the combined ecal energies*/
+    reconstructHcalExcess(block, hcal, ecalIds, ecalEnergy, trackEnergy);
+  } else {  //  case whether there are no tracks make a neutral hadron for each hcal
+            // note that hcal-ecal links have been removed so hcal should only be linked to
+            // other hcals
+    reconstructCluster(hcal, papas::Layer::kHcal, {block.id(), hcalId});
+  }
+  m_locked.set(hcalId);
+}
+
+void PFReconstructor::reconstructHcalExcess(const PFBlock& block, const Cluster& hcal, const Ids& ecalIds,
+                                            double ecalEnergy, double trackEnergy) {
+  double hcalEnergy = hcal.energy();
+  Identifier hcalId = hcal.id();
+  double deltaERel = (hcalEnergy + ecalEnergy) / trackEnergy - 1.;
+  double caloERes = neutralHadronEnergyResolution(trackEnergy, hcal.eta());
+  if (deltaERel > nsigmaHcal(hcal) * caloERes) {  //# approx means hcal energy + ecal energies > track energies
+
+    double excess = deltaERel * trackEnergy;  // energy in excess of track energies
+    // print( 'excess = {excess:5.2f}, ecal_E = {ecal_e:5.2f}, diff = {diff:5.2f}'.format(
+    //   excess=excess, ecal_e = ecal_energy, diff=excess-ecal_energy))
+    if (excess <= ecalEnergy) { /* # approx means hcal energy > track energies
+                                 # Make a photon from the ecal energy
+                                 # We make only one photon using only the combined ecal energies*/
+      auto parentIds = ecalIds;
+      parentIds.insert(block.id());
+      reconstructCluster(hcal, papas::Layer::kEcal, parentIds, excess);
+    }
+
+    else {  // approx means that hcal energy>track energies so we must have a neutral hadron
+            // excess-ecal_energy is approximately hcal energy  - track energies
+      auto parentIds = Ids{block.id(), hcalId};
+      reconstructCluster(hcal, papas::Layer::kHcal, parentIds, excess - ecalEnergy);
+      if (ecalEnergy) {
+        // make a photon from the remaining ecal energies
+        // again history is confusingbecause hcal is used to provide direction
+        // be better to make several smaller photons one per ecal?
         auto parentIds = ecalIds;
         parentIds.insert(block.id());
-        reconstructCluster(hcal, papas::Layer::kEcal, parentIds, excess);
-      }
-
-      else {  // approx means that hcal energy>track energies so we must have a neutral hadron
-              // excess-ecal_energy is approximately hcal energy  - track energies
-        auto parentIds = Ids{block.id(), hcalId};
-        reconstructCluster(hcal, papas::Layer::kHcal, parentIds, excess - ecalEnergy);
-        if (ecalEnergy) {
-          // make a photon from the remaining ecal energies
-          // again history is confusingbecause hcal is used to provide direction
-          // be better to make several smaller photons one per ecal?
-          auto parentIds = ecalIds;
-          parentIds.insert(block.id());
-          reconstructCluster(hcal, papas::Layer::kEcal, parentIds, ecalEnergy);
-        }
+        reconstructCluster(hcal, papas::Layer::kEcal, parentIds, ecalEnergy);
       }
     }
-  } else {  //  case whether there are no tracks make a neutral hadron for each hcal
-            // note that hcal-ecal links have been removed so hcal should only be linked to
-            // other hcals
-    auto parentIds = Ids{block.id(), hcalId};
-    reconstructCluster(hcal, papas::Layer::kHcal, parentIds);
   }
-  m_locked[hcalId] = true;
 }
 
-void PFReconstructor::reconstructCluster(const Cluster& cluster, papas::Layer layer, const Ids& parentIds,
+void PFReconstructor::reconstructCluster(const Cluster& cluster, papas::Layer layer,
+                                         std::initializer_list<Identifier> parentIds) {
+  reconstructCluster<std::initializer_list<Identifier>>(cluster, layer, parentIds);
+}
+
+template <typename P>
+void PFReconstructor::reconstructCluster(const Cluster& cluster, papas::Layer layer, const P& parentIds,
                                          double energy, const TVector3& vertex) {
   // construct a photon if it is an ecal
   // construct a neutral hadron if it is an hcal
@@ -291,7 +422,8 @@ void PFReconstructor::reconstructCluster(const Cluster& cluster, papas::Layer la
   TLorentzVector p4(p3.Px(), p3.Py(), p3.Pz(), energy);  // mass is not accurate here
   Particle particle(pdgId, 0., p4, m_particles.size(), 'r', vertex);
   propagator(particle.charge())->setPath(particle);
-  propagator(particle.charge())->propagateOne(particle, m_detector.ecal()->volumeCylinder().inner());
+  // the ecal entry point is only computed if it is asked for
+  particle.path()->addLazyPoint(m_detector.ecal()->volumeCylinder().inner());
   if (layer == papas::Layer::kHcal) {  // alice not sure
     particle.path()->addPoint(papas::Position::kHcalIn, cluster.position());
   }
@@ -301,15 +433,20 @@ void PFReconstructor::reconstructCluster(const Cluster& cluster, papas::Layer la
   // path where the point is actually that
   // of the hcal?
   // nb this only is problem if the cluster and the assigned layer are different
-  m_locked[cluster.id()] = true;  // alice : just OK but not nice if hcal used to make ecal.
+  m_locked.set(cluster.id());  // alice : just OK but not nice if hcal used to make ecal.
   PDebug::write("Made {} from Merged{}", particle, cluster);
   insertParticle(parentIds, particle);
 }
 
-void PFReconstructor::reconstructTrack(const Track& track, int pdgId, const Ids& parentIds) {
+void PFReconstructor::reconstructTrack(const Track& track, int pdgId, std::initializer_list<Identifier> parentIds) {
+  reconstructTrack<std::initializer_list<Identifier>>(track, pdgId, parentIds);
+}
+
+template <typename P>
+void PFReconstructor::reconstructTrack(const Track& track, int pdgId, const P& parentIds) {
   /*construct a charged hadron/electron/muon from the track
   */
-  if (m_locked[track.id()]) return;
+  if (m_locked.test(track.id())) return;
   pdgId = pdgId * track.charge();
   TLorentzVector p4 = TLorentzVector();
   p4.SetVectM(track.p3(), ParticlePData::particleMass(pdgId));
@@ -318,7 +455,7 @@ void PFReconstructor::reconstructTrack(const Track& track, int pdgId, const Ids&
 
   //#todo fix this so it picks up smeared track points (need to propagate smeared track)
   propagator(particle.charge())->setPath(particle);
-  m_locked[track.id()] = true;
+  m_locked.set(track.id());
   PDebug::write("Made {} from Smeared{}", particle, track);
   insertParticle(parentIds, particle);
 }
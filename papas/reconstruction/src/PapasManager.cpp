@@ -1,19 +1,81 @@
 #include "papas/reconstruction/PapasManager.h"
 
+#include "papas/datatypes/Helix.h"
+#include "papas/datatypes/ParticlePData.h"
+#include "papas/datatypes/Path.h"
+#include "papas/detectors/Detector.h"
+#include "papas/detectors/Field.h"
 #include "papas/graphtools/EventRuler.h"
 #include "papas/reconstruction/BuildPFBlocks.h"
+#include "papas/reconstruction/MergeAndBuildBlocks.h"
 #include "papas/reconstruction/MergeClusters.h"
 #include "papas/reconstruction/PFReconstructor.h"
 #include "papas/reconstruction/SimplifyPFBlocks.h"
+#include "papas/simulation/HelixPropagator.h"
 #include "papas/simulation/Simulator.h"
+#include "papas/simulation/StraightLinePropagator.h"
+#include "papas/utility/AllocTracker.h"
+#include "papas/utility/Metrics.h"
+#include "papas/utility/PerfCounters.h"
+#include "papas/utility/Timeline.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace papas {
 
-PapasManager::PapasManager(const Detector& detector) : m_detector(detector), m_history(), m_event(m_history) {}
+PapasManager::PapasManager(const Detector& detector)
+    : m_detector(detector), m_history(), m_topologyCounts(), m_event(m_history), m_retention(Retention::kKeepAll) {}
+
+void PapasManager::addParticles(Particles& particles) {
+  // the path is made on the particle held by the Event, so that the simulation adds its points there
+  std::shared_ptr<const Propagator> helix, straight;
+  for (auto& p : particles) {
+    auto& ptc = p.second;
+    if (ptc.path() != nullptr) continue;
+    if (fabs(ptc.charge()) < 0.5) {
+      if (!straight) straight = std::make_shared<StraightLinePropagator>(m_detector.field());
+      straight->setPath(ptc);
+    } else {
+      if (!helix) helix = std::make_shared<HelixPropagator>(m_detector.field());
+      helix->setPath(ptc);
+    }
+  }
+  m_event.addCollectionToFolder(particles);
+}
+
+void PapasManager::addClusters(const Clusters& clusters) {
+  if (clusters.empty()) return;  // empty collections are not added to the Event
+  m_event.addCollectionToFolder(clusters);
+  // read like the smeared clusters made by simulate
+  declareReaders(IdCoder::typeAndSubtype(clusters.begin()->first), 3);
+}
+
+void PapasManager::addTracks(const Tracks& tracks) {
+  if (tracks.empty()) return;
+  m_event.addCollectionToFolder(tracks);
+  declareReaders(IdCoder::typeAndSubtype(tracks.begin()->first), 2);
+}
 
-void PapasManager::addParticles(const Particles& particles) { m_event.addCollectionToFolder(particles); }
+std::shared_ptr<Path> PapasManager::makeTrackPath(const TVector3& p3, double charge, const TVector3& vertex) const {
+  // the mass only sets the speed along the path, tracks are taken to be pions
+  TLorentzVector p4;
+  p4.SetVectM(p3, ParticlePData::particleMass(211));
+  std::shared_ptr<Path> path;
+  if (fabs(charge) < 0.5)
+    path = std::make_shared<Path>(p4, vertex);
+  else
+    path = std::make_shared<Helix>(p4, vertex, charge, m_detector.field()->getMagnitude());
+  for (const auto& el : m_detector.elements())
+    path->addLazyPoint(el->volumeCylinder().inner());
+  return path;
+}
 
 void PapasManager::simulate(char particleSubtype) {
+  Timeline::Span span("simulate", "stage");
+  AllocTracker::Scope allocScope(AllocTracker::kSimulate);
+  PerfCounters::Scope perfScope(PerfCounters::kSimulate);
+  if (PerfCounters::isOn()) perfScope.setObjects(m_event.particles(particleSubtype).size());
   // create empty collections that will be passed to simulator to fill
   // the new collection is to be a concrete class owned by the PapasManger
   // and stored in a list of collections.
@@ -38,37 +100,108 @@ void PapasManager::simulate(char particleSubtype) {
   m_event.addCollectionToFolder(smearedHcalClusters);
   m_event.addCollectionToFolder(tracks);
   m_event.addCollectionToFolder(smearedTracks);
+  // the true clusters and tracks are not read by any later stage. The smeared clusters are read by the merging and,
+  // through the merged clusters, by block building and reconstruction. The smeared tracks are read by the last two.
+  declareReaders("et", 0);
+  declareReaders("ht", 0);
+  declareReaders("tt", 0);
+  declareReaders("es", 3);
+  declareReaders("hs", 3);
+  declareReaders("ts", 2);
 }
 
 void PapasManager::mergeClusters(const std::string& typeAndSubtype) {
+  Timeline::Span span("merge clusters", "stage");
+  AllocTracker::Scope allocScope(AllocTracker::kMerge);
+  PerfCounters::Scope perfScope(PerfCounters::kMerge);
+  if (PerfCounters::isOn()) perfScope.setObjects(m_event.clusters(typeAndSubtype).size());
   EventRuler ruler(m_event);
   // create collections ready to receive outputs
   auto& mergedClusters = createClusters();
   papas::mergeClusters(m_event, typeAndSubtype, ruler, mergedClusters, m_history);
   // add outputs into event
   m_event.addCollectionToFolder(mergedClusters);
+  read({typeAndSubtype});
+  // merged clusters keep pointers to the clusters they were made from
+  auto mergedTypeAndSubtype = typeAndSubtype.substr(0, 1) + "m";
+  m_sources[mergedTypeAndSubtype] = {typeAndSubtype};
+  declareReaders(mergedTypeAndSubtype, 2);  // block building and reconstruction
 }
 
 void PapasManager::buildBlocks(const char ecalSubtype, char hcalSubtype, char trackSubtype) {
+  Timeline::Span span("build blocks", "stage");
+  AllocTracker::Scope allocScope(AllocTracker::kBlockBuild);
+  PerfCounters::Scope perfScope(PerfCounters::kBlockBuild);
+  if (PerfCounters::isOn())
+    perfScope.setObjects(m_event.clusters(IdCoder::kEcalCluster, ecalSubtype).size() +
+                         m_event.clusters(IdCoder::kHcalCluster, hcalSubtype).size() +
+                         m_event.tracks(trackSubtype).size());
   // create empty collections to hold the ouputs, the ouput will be added by the algorithm
   auto& blocks = createBlocks();
   buildPFBlocks(m_event, ecalSubtype, hcalSubtype, trackSubtype, blocks, m_history);
   // store a pointer to the ouputs into the event
   m_event.addCollectionToFolder(blocks);
+  m_blockInputs = {std::string{'e', ecalSubtype}, std::string{'h', hcalSubtype}, std::string{'t', trackSubtype}};
+  read(m_blockInputs);
+  declareReaders("br", 1);  // simplification, or reconstruction if the blocks are not simplified
+}
+
+void PapasManager::mergeAndBuildBlocks(char ecalSubtype, char hcalSubtype, char trackSubtype) {
+  Timeline::Span span("merge and build blocks", "stage");
+  AllocTracker::Scope allocScope(AllocTracker::kBlockBuild);
+  PerfCounters::Scope perfScope(PerfCounters::kBlockBuild);
+  if (PerfCounters::isOn())
+    perfScope.setObjects(m_event.clusters(IdCoder::kEcalCluster, ecalSubtype).size() +
+                         m_event.clusters(IdCoder::kHcalCluster, hcalSubtype).size() +
+                         m_event.tracks(trackSubtype).size());
+  auto& mergedEcals = createClusters();
+  auto& mergedHcals = createClusters();
+  auto& blocks = createBlocks();
+  mergeAndBuildPFBlocks(m_event, ecalSubtype, hcalSubtype, trackSubtype, mergedEcals, mergedHcals, blocks, m_history);
+  m_event.addCollectionToFolder(mergedEcals);
+  m_event.addCollectionToFolder(mergedHcals);
+  m_event.addCollectionToFolder(blocks);
+  // the same readers as for the separate stages
+  std::string ecals{'e', ecalSubtype};
+  std::string hcals{'h', hcalSubtype};
+  read({ecals, hcals});
+  m_sources["em"] = {ecals};
+  m_sources["hm"] = {hcals};
+  declareReaders("em", 2);
+  declareReaders("hm", 2);
+  m_blockInputs = {"em", "hm", std::string{'t', trackSubtype}};
+  read(m_blockInputs);
+  declareReaders("br", 1);
 }
 
 void PapasManager::simplifyBlocks(char blockSubtype) {
+  Timeline::Span span("simplify blocks", "stage");
+  AllocTracker::Scope allocScope(AllocTracker::kSimplify);
+  PerfCounters::Scope perfScope(PerfCounters::kSimplify);
+  if (PerfCounters::isOn()) perfScope.setObjects(m_event.blocks(blockSubtype).size());
   // create empty collections to hold the ouputs, the ouput will be added by the algorithm
   auto& simplifiedblocks = createBlocks();
   simplifyPFBlocks(m_event, blockSubtype, simplifiedblocks, m_history);
   // store a pointer to the outputs into the event
   m_event.addCollectionToFolder(simplifiedblocks);
+  read({std::string{'b', blockSubtype}});
+  declareReaders("bs", 1);  // reconstruction
 }
 
 void PapasManager::reconstruct(char blockSubtype) {
+  Timeline::Span span("reconstruct", "stage");
+  AllocTracker::Scope allocScope(AllocTracker::kReconstruct);
+  PerfCounters::Scope perfScope(PerfCounters::kReconstruct);
+  if (PerfCounters::isOn()) perfScope.setObjects(m_event.blocks(blockSubtype).size());
   auto& recParticles = createParticles();
   PFReconstructor pfReconstructor(m_event, blockSubtype, m_detector, recParticles, m_history);
+  for (unsigned int i = 0; i < PFReconstructor::kNumTopologies; ++i)
+    m_topologyCounts[i] += pfReconstructor.topologyCounts()[i];
+  Metrics::add(Metrics::kParticlesReconstructed, recParticles.size());
   m_event.addCollectionToFolder(recParticles);
+  // the blocks and the clusters and tracks in them
+  read({std::string{'b', blockSubtype}});
+  read(m_blockInputs);
 }
 
 void PapasManager::clear() {
@@ -78,6 +211,72 @@ void PapasManager::clear() {
   m_ownedTracksList.clear();
   m_ownedBlocksList.clear();
   m_ownedParticlesList.clear();
+  m_readers.clear();
+  m_sources.clear();
+  m_blockInputs.clear();
+}
+
+void PapasManager::setRetention(Retention retention, const std::vector<std::string>& kept) {
+  m_retention = retention;
+  m_kept = kept;
+}
+
+void PapasManager::declareReaders(const std::string& typeAndSubtype, unsigned int nReaders) {
+  if (m_retention != Retention::kPruned) return;
+  if (nReaders == 0)
+    release(typeAndSubtype);
+  else
+    m_readers[typeAndSubtype] = nReaders;
+}
+
+void PapasManager::read(const std::vector<std::string>& typeAndSubtypes) {
+  if (m_retention != Retention::kPruned) return;
+  for (const auto& typeAndSubtype : typeAndSubtypes) {
+    auto found = m_readers.find(typeAndSubtype);
+    if (found == m_readers.end()) continue;  // not made by a stage or already released
+    auto sources = m_sources.find(typeAndSubtype);
+    if (sources != m_sources.end()) read(sources->second);
+    if (--found->second > 0) continue;
+    m_readers.erase(found);
+    release(typeAndSubtype);
+  }
+}
+
+namespace {
+/// deletes the collection if it is one of the owned collections and returns whether it was
+template <class T>
+bool eraseOwned(std::list<T>& owned, const T& collection) {
+  auto found = std::find_if(owned.begin(), owned.end(), [&collection](const T& c) { return &c == &collection; });
+  if (found == owned.end()) return false;
+  owned.erase(found);
+  return true;
+}
+}  // end anonymous namespace
+
+void PapasManager::release(const std::string& typeAndSubtype) {
+  if (std::find(m_kept.begin(), m_kept.end(), typeAndSubtype) != m_kept.end()) return;
+  auto type = IdCoder::type(typeAndSubtype[0]);
+  auto subtype = typeAndSubtype[1];
+  if (!m_event.hasCollection(type, subtype)) return;  // empty collections are not added to the Event
+  bool owned = false;
+  switch (type) {
+  case IdCoder::kEcalCluster:
+  case IdCoder::kHcalCluster:
+    owned = eraseOwned(m_ownedClustersList, m_event.clusters(type, subtype));
+    break;
+  case IdCoder::kTrack:
+    owned = eraseOwned(m_ownedTracksList, m_event.tracks(subtype));
+    break;
+  case IdCoder::kBlock:
+    owned = eraseOwned(m_ownedBlocksList, m_event.blocks(subtype));
+    break;
+  case IdCoder::kParticle:
+    owned = eraseOwned(m_ownedParticlesList, m_event.particles(subtype));
+    break;
+  default:
+    break;
+  }
+  if (owned) m_event.removeCollection(type, subtype);
 }
 
 Clusters& PapasManager::createClusters() {
@@ -3,6 +3,7 @@
 #include "papas/datatypes/Event.h"
 #include "papas/reconstruction/BuildPFBlocks.h"
 #include "papas/utility/PDebug.h"
+#include "papas/utility/Timeline.h"
 
 namespace papas {
 
@@ -14,40 +15,36 @@ void simplifyPFBlocks(const Event& event, char blockSubtype, Blocks& simplifiedb
   // Note that the old block will be marked as disactivated
   for (auto bid : blockids) {
     const auto& block = event.block(bid);
+    Timeline::Span span("simplify block", "block", block.size());
     PDebug::write("Splitting {}", block);
     auto unlink = edgesToUnlink(block);
     simplifyPFBlock(unlink, block, simplifiedblocks, history);
   }
 }
 
-void simplifyPFBlock(const Edges& toUnlink, const PFBlock& block, Blocks& simplifiedBlocks, Nodes& history) {
+void simplifyPFBlock(const EdgeKeys& toUnlink, const PFBlock& block, Blocks& simplifiedBlocks, Nodes& history) {
   // take a block, unlink some of the edges and
   // create smaller blocks or a simplified blocks
-  // or if nothing has changed take a copy of the original block
+  // or if nothing has changed make a new block that shares the edges of the original block
   if (toUnlink.size() == 0) {
-    // no change needed, just make a copy of block
-    PFBlock newblock(block.elementIds(), block.edges(), simplifiedBlocks.size(), 's');  // will copy edges and ids
+    // no change needed, the edges are shared and not copied
+    PFBlock newblock(block.elementIds(), block.edgeStore(), simplifiedBlocks.size(), 's', block.unlinkedKeys());
     PDebug::write("Made {}", newblock);
     auto id = newblock.id();
     simplifiedBlocks.emplace(id, std::move(newblock));
     // update history
-    makeHistoryLinks(block.elementIds(), {id}, history);
+    makeBlockHistoryLinks(block.elementIds(), id, history);
   } else {
-    Edges modifiedEdges;
-    for (auto edge : block.edges()) {  // copying edges
-      Edge e = edge.second;
-      if (toUnlink.find(edge.first) != toUnlink.end()) {
-        e.setLinked(false);
-      }
-      modifiedEdges.emplace(e.key(), e);
-    }
-    // create new blocks and add into simplifiedBlocks
-    buildPFBlocks(block.elementIds(), modifiedEdges, 's', simplifiedBlocks, history);
+    // the new blocks share the edges of the original block, the removed links are recorded as unlinked keys
+    // and only the elements of this block are regrouped
+    EdgeKeys unlinked(block.unlinkedKeys());
+    unlinked.insert(toUnlink.begin(), toUnlink.end());
+    buildPFBlocks(block.elementIds(), block.edgeStore(), 's', simplifiedBlocks, history, unlinked);
   }
 }
 
-Edges edgesToUnlink(const PFBlock& block) {
-  Edges toUnlink;
+EdgeKeys edgesToUnlink(const PFBlock& block) {
+  EdgeKeys toUnlink;
   Ids ids = block.elementIds();
   if (ids.size() > 1) {
     Ids linkedIds;
@@ -68,10 +65,8 @@ Edges edgesToUnlink(const PFBlock& block) {
           }
           // unlink anything that is greater than minimum distance
           for (auto elem : linkedIds) {
-            auto key = Edge::makeKey(id, elem);
-            auto& edge = block.edge(id, elem);
-            if (edge.distance() > minDist) {  // (could be more than one at zero distance)
-              toUnlink[key] = edge;           // should toUnlink be list of keys rather than edges
+            if (block.edge(id, elem).distance() > minDist) {  // (could be more than one at zero distance)
+              toUnlink.insert(Edge::makeKey(id, elem));
             }
           }
         }
@@ -0,0 +1,58 @@
+#ifndef ParticleGun_h
+#define ParticleGun_h
+
+#include "papas/datatypes/DefinitionsCollections.h"
+
+#include <random>
+
+namespace papas {
+// forward declarations
+class Detector;
+
+/** @brief ParticleGun makes collections of random (stable) papas Particles, with their paths, ready for simulation.
+ *
+ * It is intended for benchmarks and tests which need events of a chosen size without an external generator.
+ * The particles are a mix of photons, charged and neutral hadrons and a few leptons. They are either spread
+ * uniformly in eta and phi or grouped into a number of jet-like cones. The gun has its own random number generator
+ * so the events it makes depend only on its seed (and not on the random numbers used by the simulation).
+ *
+ * Usage example:
+ * @code
+ *   ParticleGun gun(detector, seed);
+ *   auto& particles = papasManager.createParticles();
+ *   gun.makeParticles(1000, particles);
+ *   papasManager.addParticles(particles);
+ *   papasManager.simulate();
+ * @endcode
+ */
+class ParticleGun {
+public:
+  /** Constructor
+   * @param[in] detector the detector, used to find the magnetic field for the paths of charged particles
+   * @param[in] seed seed for the random number generator
+   */
+  ParticleGun(const Detector& detector, unsigned int seed = 1);
+  /** Makes new particles and adds them to a particles collection.
+   * @param[in] nParticles number of particles to make
+   * @param[inout] particles collection into which the new particles (subtype 's') are added
+   * @param[in] nJets if 0 the particles are spread uniformly otherwise they are shared between nJets cones
+   */
+  void makeParticles(unsigned int nParticles, Particles& particles, unsigned int nJets = 0);
+  void setEnergyRange(double emin, double emax);           ///< energies are between emin and emax (GeV)
+  void setEtaMax(double etaMax) { m_etaMax = etaMax; }     ///< particles (or jet axes) are within |eta| < etaMax
+  void setConeSize(double coneSize) { m_coneSize = coneSize; }  ///< size in eta and phi of the jet cones
+  void seed(unsigned int seed) { m_generator.seed(seed); }      ///< reseed the random number generator
+
+private:
+  double uniform(double a, double b) { return std::uniform_real_distribution<double>(a, b)(m_generator); }
+  const Detector& m_detector;  ///< detector
+  std::mt19937 m_generator;    ///< random number generator
+  double m_emin;               ///< minimum energy
+  double m_emax;               ///< maximum energy
+  double m_etaMax;             ///< maximum |eta| of particles (or of jet axes)
+  double m_coneSize;           ///< size of the jet cones in eta and phi
+};
+
+}  // end namespace papas
+
+#endif /* ParticleGun_h */
@@ -0,0 +1,88 @@
+#ifndef PileupMixer_h
+#define PileupMixer_h
+
+#include "papas/datatypes/DefinitionsCollections.h"
+
+#include "TLorentzVector.h"
+#include "TVector3.h"
+
+#include <random>
+#include <vector>
+
+namespace papas {
+// forward declarations
+class Detector;
+class ParticleGun;
+
+/** @brief PileupMixer overlays minimum-bias (pileup) interactions on a signal event before it is simulated.
+ *
+ * It holds a pool of minimum-bias events which is filled once, either from the native ParticleGun or from
+ * particles read from a file (see PythiaConnector::fillPileupPool), so no file is read again while mixing. For each
+ * signal event the mixer draws a number of interactions (fixed or Poisson distributed around the mean pileup),
+ * picks each one at random from the pool (events are reused), displaces it to a vertex drawn from the luminous
+ * region along z, and adds its particles, with their paths, to the signal particles collection.
+ * The pool is stored as one flat array of compact particles, so mixing touches no more memory than needed.
+ *
+ * Usage example:
+ * @code
+ *   PileupMixer mixer(detector, 200);
+ *   ParticleGun minbias(detector, 2);
+ *   minbias.setEnergyRange(0.2, 5);
+ *   mixer.fillPool(minbias, 500, 40);
+ *   auto& particles = papasManager.createParticles();
+ *   gun.makeParticles(100, particles);  // signal
+ *   mixer.mix(particles);
+ *   papasManager.addParticles(particles);
+ *   papasManager.simulate();
+ * @endcode
+ */
+class PileupMixer {
+public:
+  /// Minimum-bias particle as it is stored in the pool
+  struct PoolParticle {
+    int pdgid;
+    float charge;
+    TLorentzVector p4;
+    TVector3 vertex;  ///< production vertex (m) before displacement
+  };
+
+  /** Constructor
+   * @param[in] detector the detector, used to find the magnetic field for the paths of charged particles
+   * @param[in] meanPileup mean number of minimum-bias interactions overlaid on each event, throws if negative
+   * @param[in] seed seed for the random number generator
+   */
+  PileupMixer(const Detector& detector, double meanPileup, unsigned int seed = 1);
+  /** Adds a minimum-bias event to the pool
+   * @param[in] particles the stable particles of the event
+   */
+  void addPoolEvent(const std::vector<PoolParticle>& particles);
+  /** Fills the pool with events made by a ParticleGun (the native generator)
+   * @param[in] gun the generator, which should be set up for soft particles
+   * @param[in] nEvents number of events to add to the pool
+   * @param[in] nParticles number of particles in each event
+   */
+  void fillPool(ParticleGun& gun, unsigned int nEvents, unsigned int nParticles);
+  /** Overlays pileup interactions on an event
+   * @param[inout] particles the signal particles, to which the pileup particles (subtype 's') are added
+   * @return number of interactions overlaid
+   */
+  unsigned int mix(Particles& particles);
+  std::size_t poolSize() const { return m_eventStarts.size(); }   ///< number of events in the pool
+  void setMeanPileup(double meanPileup);                          ///< mean number of interactions, throws if negative
+  void setFluctuate(bool fluctuate) { m_fluctuate = fluctuate; }  ///< Poisson distributed number of interactions
+  void setVertexSpread(double sigmaZ) { m_sigmaZ = sigmaZ; }      ///< rms length of the luminous region (m)
+  void seed(unsigned int seed) { m_generator.seed(seed); }        ///< reseed the random number generator
+
+private:
+  const Detector& m_detector;              ///< detector
+  std::mt19937 m_generator;                ///< random number generator
+  double m_meanPileup;                     ///< mean number of interactions per event
+  bool m_fluctuate;                        ///< whether the number of interactions is Poisson distributed
+  double m_sigmaZ;                         ///< rms of the z position of the interaction vertices (m)
+  std::vector<PoolParticle> m_particles;   ///< particles of all the pool events, one event after another
+  std::vector<std::size_t> m_eventStarts;  ///< index in m_particles of the first particle of each pool event
+};
+
+}  // end namespace papas
+
+#endif /* PileupMixer_h */
@@ -27,9 +27,10 @@ public:
    */
   virtual void propagateOne(const Particle& ptc, const SurfaceCylinder& cyl) const = 0;
 
-  /**  Propagate particle all cylinders of the detector
+  /**  Propagate particle all cylinders of the detector.
+    The points are added lazily to the particle path: each one is computed when it is first asked for.
     @param[in] ptc particle that is to be propagated
-    @param[in] detector  Detector through which to propagate
+    @param[in] detector  Detector through which to propagate (must outlive the particle path)
     */
   void propagate(const Particle& ptc, const Detector& detector) const;
 
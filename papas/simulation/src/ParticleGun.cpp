@@ -0,0 +1,66 @@
+#include "papas/simulation/ParticleGun.h"
+
+#include "papas/datatypes/Helix.h"
+#include "papas/datatypes/Particle.h"
+#include "papas/datatypes/ParticlePData.h"
+#include "papas/datatypes/Path.h"
+#include "papas/detectors/Detector.h"
+#include "papas/detectors/Field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace papas {
+
+ParticleGun::ParticleGun(const Detector& detector, unsigned int seed)
+    : m_detector(detector), m_generator(seed), m_emin(1.), m_emax(40.), m_etaMax(2.5), m_coneSize(0.15) {}
+
+void ParticleGun::setEnergyRange(double emin, double emax) {
+  if (emin <= 0 || emax < emin) throw "ParticleGun: energy range is not valid";
+  m_emin = emin;
+  m_emax = emax;
+}
+
+void ParticleGun::makeParticles(unsigned int nParticles, Particles& particles, unsigned int nJets) {
+  // particle types and charges, repeated entries make them more likely
+  static const std::vector<std::pair<int, double>> species = {
+      {22, 0},   {22, 0},    {22, 0},  {211, 1}, {-211, -1}, {211, 1},  {-211, -1},
+      {130, 0},  {2112, 0},  {321, 1}, {-321, -1}, {11, -1}, {-13, 1}};
+  std::vector<std::pair<double, double>> axes;  // eta, phi of jet axes
+  for (unsigned int j = 0; j < nJets; ++j) {
+    axes.emplace_back(uniform(-m_etaMax, m_etaMax), uniform(-M_PI, M_PI));
+  }
+  for (unsigned int i = 0; i < nParticles; ++i) {
+    const auto& type = species[(std::size_t)uniform(0, species.size()) % species.size()];
+    double eta, phi;
+    if (nJets == 0) {
+      eta = uniform(-m_etaMax, m_etaMax);
+      phi = uniform(-M_PI, M_PI);
+    } else {
+      const auto& axis = axes[(std::size_t)uniform(0, nJets) % nJets];
+      eta = axis.first + uniform(-m_coneSize, m_coneSize);
+      phi = axis.second + uniform(-m_coneSize, m_coneSize);
+    }
+    // softer particles are more common
+    double u = uniform(0, 1);
+    double energy = m_emin + (m_emax - m_emin) * u * u;
+    double mass = ParticlePData::particleMass(std::abs(type.first));
+    double momentum = std::sqrt(std::max(energy * energy - mass * mass, 0.01));
+    double theta = 2 * std::atan(std::exp(-eta));
+    TLorentzVector p4(momentum * std::sin(theta) * std::cos(phi), momentum * std::sin(theta) * std::sin(phi),
+                      momentum * std::cos(theta), std::sqrt(momentum * momentum + mass * mass));
+    Particle particle(type.first, type.second, p4, particles.size(), 's');
+    // set the particles papas path (allows particles to be const when passed to simulator)
+    std::shared_ptr<Path> ppath;
+    if (std::fabs(particle.charge()) < 0.5)
+      ppath = std::make_shared<Path>(particle.p4(), particle.startVertex(), particle.charge());
+    else
+      ppath = std::make_shared<Helix>(particle.p4(), particle.startVertex(), particle.charge(),
+                                      m_detector.field()->getMagnitude());
+    particle.setPath(ppath);
+    particles.emplace(particle.id(), std::move(particle));
+  }
+}
+
+}  // end namespace papas
@@ -0,0 +1,81 @@
+#include "papas/simulation/PileupMixer.h"
+
+#include "papas/datatypes/Helix.h"
+#include "papas/datatypes/Particle.h"
+#include "papas/datatypes/Path.h"
+#include "papas/detectors/Detector.h"
+#include "papas/detectors/Field.h"
+#include "papas/simulation/ParticleGun.h"
+
+#include <cmath>
+
+namespace papas {
+
+PileupMixer::PileupMixer(const Detector& detector, double meanPileup, unsigned int seed)
+    : m_detector(detector), m_generator(seed), m_meanPileup(0), m_fluctuate(true), m_sigmaZ(0.05) {
+  setMeanPileup(meanPileup);
+}
+
+void PileupMixer::setMeanPileup(double meanPileup) {
+  if (!(meanPileup >= 0)) throw "PileupMixer: the mean pileup must not be negative";
+  m_meanPileup = meanPileup;
+}
+
+void PileupMixer::addPoolEvent(const std::vector<PoolParticle>& particles) {
+  m_eventStarts.push_back(m_particles.size());
+  m_particles.insert(m_particles.end(), particles.begin(), particles.end());
+}
+
+void PileupMixer::fillPool(ParticleGun& gun, unsigned int nEvents, unsigned int nParticles) {
+  std::vector<PoolParticle> event;
+  for (unsigned int i = 0; i < nEvents; ++i) {
+    Particles particles;
+    gun.makeParticles(nParticles, particles);
+    event.clear();
+    for (const auto& p : particles) {
+      const Particle& particle = p.second;
+      event.push_back(PoolParticle{particle.pdgId(), (float)particle.charge(), particle.p4(), particle.startVertex()});
+    }
+    addPoolEvent(event);
+  }
+}
+
+unsigned int PileupMixer::mix(Particles& particles) {
+  if (m_eventStarts.empty()) throw "PileupMixer: the pool of minimum-bias events is empty";
+  unsigned int nInteractions = 0;  // a Poisson distribution needs a mean above 0
+  if (m_meanPileup > 0)
+    nInteractions = m_fluctuate ? std::poisson_distribution<unsigned int>(m_meanPileup)(m_generator)
+                                : static_cast<unsigned int>(m_meanPileup + 0.5);
+  std::uniform_int_distribution<std::size_t> pick(0, m_eventStarts.size() - 1);
+  std::normal_distribution<double> vertexZ(0., m_sigmaZ);
+  // draw the interactions first so that the collection is only rehashed once
+  std::vector<std::pair<std::size_t, double>> interactions;  // pool event, z of vertex
+  std::size_t nParticles = 0;
+  for (unsigned int i = 0; i < nInteractions; ++i) {
+    std::size_t event = pick(m_generator);
+    std::size_t end = (event + 1 < m_eventStarts.size()) ? m_eventStarts[event + 1] : m_particles.size();
+    nParticles += end - m_eventStarts[event];
+    interactions.emplace_back(event, vertexZ(m_generator));
+  }
+  particles.reserve(particles.size() + nParticles);
+  double field = m_detector.field()->getMagnitude();
+  for (const auto& interaction : interactions) {
+    std::size_t event = interaction.first;
+    std::size_t end = (event + 1 < m_eventStarts.size()) ? m_eventStarts[event + 1] : m_particles.size();
+    TVector3 displacement(0, 0, interaction.second);
+    for (std::size_t i = m_eventStarts[event]; i < end; ++i) {
+      const PoolParticle& p = m_particles[i];
+      Particle particle(p.pdgid, p.charge, p.p4, particles.size(), 's', p.vertex + displacement);
+      std::shared_ptr<Path> ppath;
+      if (std::fabs(particle.charge()) < 0.5)
+        ppath = std::make_shared<Path>(particle.p4(), particle.startVertex(), particle.charge());
+      else
+        ppath = std::make_shared<Helix>(particle.p4(), particle.startVertex(), particle.charge(), field);
+      particle.setPath(ppath);
+      particles.emplace(particle.id(), std::move(particle));
+    }
+  }
+  return nInteractions;
+}
+
+}  // end namespace papas
@@ -1,11 +1,14 @@
 #include "papas/simulation/Propagator.h"
 
+#include "papas/datatypes/Particle.h"
+#include "papas/datatypes/Path.h"
 #include "papas/detectors/Detector.h"
 #include "papas/detectors/Field.h"
 
 namespace papas {
 void Propagator::propagate(const Particle& ptc, const Detector& detector) const {
-  for (const auto el : detector.elements())
-    propagateOne(ptc, el->volumeCylinder().inner());
+  // the crossing points are only computed if they are asked for
+  for (const auto& el : detector.elements())
+    ptc.path()->addLazyPoint(el->volumeCylinder().inner());
 }
 }  // end namespace papas
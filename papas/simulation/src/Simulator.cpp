@@ -33,11 +33,14 @@ Simulator::Simulator(const Event& papasevent, char particleSubtype, const Detect
   m_propStraight = std::make_shared<StraightLinePropagator>(detector.field());
   // make sure we can process the particles in order if needed (highest energy first)
   Ids ids;
-  auto particles = papasevent.particles(particleSubtype);
-  for (auto& p : particles)
+  const auto& particles = papasevent.particles(particleSubtype);
+  for (const auto& p : particles)
     ids.insert(p.first);
   for (auto& id : ids) {
-    simulateParticle(particles.at(id));
+    const auto& ptc = particles.at(id);
+    // the points found by the propagation are added to the path that the particle in the Event holds
+    if (ptc.path() == nullptr) throw "Simulator: particle has no path, see PapasManager::addParticles";
+    simulateParticle(ptc);
   }
 }
 
@@ -301,14 +304,14 @@ const Track& Simulator::makeAndStoreTrack(const Particle& ptc) {
   Identifier id = track.id();
   PDebug::write("Made {}", track);
   m_tracks.emplace(id, std::move(track));
-  makeHistoryLink(ptc.id(), id, m_history);
+  makeTrackHistoryLink(ptc.id(), id, m_history);
   return m_tracks.at(id);
 }
 
 void Simulator::storeSmearedTrack(Track&& track, Identifier parentId) {
   Identifier id = track.id();
   m_smearedTracks.emplace(id, std::move(track));
-  makeHistoryLink(parentId, id, m_history);
+  makeTrackHistoryLink(parentId, id, m_history);
 }
 
 Track Simulator::smearTrack(const Track& track, double resolution) const {
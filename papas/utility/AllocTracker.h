@@ -0,0 +1,85 @@
+#ifndef utility_alloctracker_h
+#define utility_alloctracker_h
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace papas {
+
+/** Counts heap allocations and attributes them to the pipeline stage that is running
+ *
+ * Allocation tracking is opt-in: it is only compiled in when PAPAS_ALLOC_TRACKING is defined (cmake option
+ * papas_alloc_tracking), in which case the global operator new and delete are replaced by versions that count the
+ * number of allocations, the bytes requested and the number of deallocations. Each count is added to the stage
+ * of the innermost active Scope on the calling thread (or to "unscoped"). The bytes currently allocated, and their
+ * peak since resetPeak(), are also followed. Without PAPAS_ALLOC_TRACKING a Scope does nothing and all the counts
+ * are zero.
+ *
+ * Usage:
+ * @code
+ *   {
+ *     AllocTracker::Scope scope(AllocTracker::kSimulate);
+ *     ...
+ *   }
+ *   auto eventCounts = AllocTracker::endEvent();  // counts since the previous endEvent
+ *   std::cout << AllocTracker::summary(AllocTracker::runTotals(), AllocTracker::numEvents());
+ * @endcode
+ */
+class AllocTracker {
+public:
+  /// Stages to which allocations are attributed
+  enum Stage { kUnscoped = 0, kSimulate, kMerge, kBlockBuild, kSimplify, kReconstruct, kIO, kNumStages };
+  /// Allocation counts for one stage
+  struct Counts {
+    uint64_t allocations = 0;    ///< number of calls to operator new
+    uint64_t bytes = 0;          ///< bytes requested from operator new
+    uint64_t deallocations = 0;  ///< number of calls to operator delete (with a non null pointer)
+  };
+  typedef std::array<Counts, kNumStages> StageCounts;  ///< counts for every stage
+
+  /// Attributes the allocations made on this thread during its lifetime to a stage
+  class Scope {
+  public:
+#ifdef PAPAS_ALLOC_TRACKING
+    Scope(Stage stage) : m_previous(s_stage) { s_stage = stage; }
+    ~Scope() { s_stage = m_previous; }
+
+  private:
+    Stage m_previous;  ///< stage to go back to at the end of the scope
+#else
+    Scope(Stage) {}
+#endif
+  };
+
+  static bool isEnabled();                    ///< whether allocation tracking was compiled in
+  static StageCounts counts();                ///< counts since the start of the program
+  static StageCounts endEvent();              ///< counts since the previous endEvent, also added to the run totals
+  static const StageCounts& runTotals() { return s_runTotals; }  ///< sum of the counts of all ended events
+  static unsigned int numEvents() { return s_numEvents; }        ///< number of ended events
+  static void resetRun();                                        ///< clears the run totals and number of events
+  static uint64_t liveBytes();  ///< bytes currently allocated with operator new (all threads)
+  static uint64_t peakBytes();  ///< largest value of liveBytes since the last resetPeak
+  static void resetPeak();      ///< sets the peak to the current liveBytes
+  static const char* stageName(Stage stage);                     ///< eg "simulate"
+  /** Table of counts per stage
+   * @param[in] counts the counts to describe
+   * @param[in] nEvents number of events the counts are for, used to show averages per event
+   */
+  static std::string summary(const StageCounts& counts, unsigned int nEvents = 1);
+
+  static void recordAllocation(std::size_t size);    ///< used by operator new
+  static void recordDeallocation(std::size_t size);  ///< used by operator delete
+
+private:
+#ifdef PAPAS_ALLOC_TRACKING
+  static thread_local Stage s_stage;  ///< stage of the innermost scope on this thread
+#endif
+  static StageCounts s_lastEvent;     ///< counts when endEvent was last called
+  static StageCounts s_runTotals;     ///< sum over ended events
+  static unsigned int s_numEvents;    ///< number of ended events
+};
+}  // end namespace papas
+
+#endif /* utility_alloctracker_h */
@@ -0,0 +1,105 @@
+#ifndef utility_metrics_h
+#define utility_metrics_h
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace papas {
+
+/** Registry of counters describing the workload of each event (eg number of distance evaluations, edges, blocks)
+ *
+ * The algorithms add to the counters of the current event. At the end of each event the driver calls endEvent(),
+ * which adds a row to a CSV file (if one was given) and folds the event into the run totals and the per event
+ * histograms. At the end of the run writePrometheus() writes the totals and histograms in the Prometheus text
+ * exposition format.
+ *
+ * The counters are atomic so that they may be incremented from several threads, but all the threads should be
+ * working on the same event. When the registry is not started adding to a counter costs a single flag test.
+ *
+ * Usage:
+ * @code
+ *   Metrics::start("metrics.csv");
+ *   for (...) {
+ *     ... process event ...
+ *     Metrics::endEvent(eventNo, seconds);
+ *   }
+ *   Metrics::writePrometheus("metrics.prom");
+ * @endcode
+ */
+class Metrics {
+public:
+  /// Per event counters
+  enum Counter {
+    kClustersIn = 0,          ///< clusters read by cluster merging
+    kMergedClustersOut,       ///< merged clusters made
+    kDistanceEvaluations,     ///< distances computed by EventRuler
+    kEdgesCreated,            ///< edges kept by an EdgeStore (linked or nearby)
+    kEdgesLinked,             ///< edges kept that are linked
+    kBlocks,                  ///< blocks reconstructed
+    kHistoryNodes,            ///< history nodes created
+    kHistoryLinks,            ///< history links made
+    kParticlesReconstructed,  ///< reconstructed particles
+    kNumCounters
+  };
+  static const unsigned int kNumSizeBuckets = 10;  ///< number of finite buckets in the block size histogram
+
+  /** Starts collecting metrics and resets everything collected so far
+   * @param[in] csvName file for one row of counters per event, or empty for no CSV. Throws if it cannot be opened.
+   */
+  static void start(const std::string& csvName = "");
+  static void stop();  ///< stops collecting metrics and closes the CSV file
+  static bool isOn() { return s_on.load(std::memory_order_relaxed); }  ///< whether metrics are being collected
+  /// Adds n to a counter of the current event
+  static void add(Counter counter, uint64_t n = 1) {
+    if (isOn()) s_event[counter].fetch_add(n, std::memory_order_relaxed);
+  }
+  /** Records a reconstructed block
+   * @param[in] shortName block summary eg "E1H1T2" (see PFBlock::shortName)
+   * @param[in] size number of elements in the block
+   */
+  static void addBlock(const std::string& shortName, unsigned int size);
+  /** Ends the current event: writes its CSV row, adds it into the totals and histograms and resets the counters
+   * @param[in] eventNo event number
+   * @param[in] seconds time taken by the event, or negative if unknown
+   */
+  static void endEvent(unsigned int eventNo, double seconds = -1.);
+  static uint64_t value(Counter counter) { return s_event[counter].load(); }  ///< value for the current event
+  static uint64_t total(Counter counter);                                     ///< total over completed events
+  static unsigned int numEvents();                                            ///< number of completed events
+  static const char* name(Counter counter);  ///< name used in the outputs eg "distance_evaluations"
+  /** Writes the totals and histograms in Prometheus text exposition format. Throws if the file cannot be written.
+   * @param[in] fname output file name
+   */
+  static void writePrometheus(const std::string& fname);
+
+private:
+  /// Histogram with upper bounds 10^0 .. 10^(kNumDecades-1) used for the per event values
+  static const unsigned int kNumDecades = 8;
+  struct Histogram {
+    std::array<uint64_t, kNumDecades + 1> counts;  ///< last bucket is +Inf (not cumulative)
+    double sum;
+    void clear();
+    void fill(double value, double firstBound);
+  };
+
+  static std::atomic<bool> s_on;                                      ///< whether metrics are collected
+  static std::array<std::atomic<uint64_t>, kNumCounters> s_event;     ///< counters for the current event
+  static std::mutex s_mutex;                                          ///< protects everything below
+  static unsigned int s_numEvents;                                    ///< number of completed events
+  static uint64_t s_maxBlockSize;                                     ///< largest block in the current event
+  static std::array<uint64_t, kNumCounters> s_totals;                 ///< totals over completed events
+  static std::array<Histogram, kNumCounters> s_histograms;            ///< per event values of each counter
+  static Histogram s_eventSeconds;                                    ///< time per event
+  static std::array<uint64_t, kNumSizeBuckets + 1> s_blockSizes;      ///< block sizes, last bucket is +Inf
+  static uint64_t s_blockSizeSum;                                     ///< total elements in reconstructed blocks
+  static std::map<std::string, uint64_t> s_blockShortNames;           ///< number of blocks of each shortName
+  static FILE* s_csv;                                                 ///< per event CSV, or nullptr
+};
+}  // end namespace papas
+
+#endif /* utility_metrics_h */
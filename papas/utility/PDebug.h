@@ -1,6 +1,7 @@
 #ifndef utilty_pdebug_h
 #define utilty_pdebug_h
 
+#include "papas/utility/PTrace.h"
 #include "papas/utility/StringFormatter.h"
 #include "spdlog/sinks/null_sink.h"
 #include "spdlog/spdlog.h"
@@ -15,6 +16,8 @@ namespace papas {
  *   PDebug::File("papas.log");  //If not turned on nothing will be produced
  *  PDebug::write("problem with track not found :{}", id);
  * @endcode
+ * PDebug::BinaryFile("papas.trace") may be used instead of PDebug::File to write a compact binary trace (see PTrace)
+ * which can be turned back into text or compared with another trace using the papastrace tool.
 */
 class PDebug {
   // produce physics debug output
@@ -24,16 +27,26 @@ public:
     s_fname = "";
     slevel = spdlog::level::err;
     s_On = false;
+    s_binary = false;
   }
 
   /// Tells PDebug where to write output and sets output level to info
   /// @param[in] fname filename
   static void File(const std::string& fname) {
     s_On = true;
+    s_binary = false;
     s_fname = fname;
     slevel = spdlog::level::info;
   }
 
+  /// Tells PDebug to write a binary trace to this file instead of text
+  /// @param[in] fname filename
+  static void BinaryFile(const std::string& fname) {
+    PTrace::open(fname);
+    s_On = true;
+    s_binary = true;
+  }
+
   /// Write to output (this is either null or a file)
   template <typename T>
   static spdlog::details::line_logger write(const T& t) {
@@ -43,10 +56,18 @@ public:
   /// Write to output (this is either null or a file)
   template <typename... Args>
   static void write(const char* fmt, const Args&... args) {
-    if (s_On) log()->info(fmt, args...);
+    if (s_On) {
+      if (s_binary)
+        PTrace::write(fmt, args...);
+      else
+        log()->info(fmt, args...);
+    }
   }
 
-  static void flush() { PDebug::log()->flush(); }
+  static void flush() {
+    PDebug::log()->flush();
+    PTrace::flush();
+  }
   static std::shared_ptr<spdlog::logger> log();
 
 private:
@@ -62,6 +83,7 @@ private:
   static spdlog::level::level_enum slevel;  ///< either err or info
   static std::string s_fname;
   static bool s_On;  ///< Boolean which says whether PDebug is active
+  static bool s_binary;  ///< Boolean which says whether output goes to the binary trace
 };
 }
 
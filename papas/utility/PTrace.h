@@ -0,0 +1,138 @@
+#ifndef utility_ptrace_h
+#define utility_ptrace_h
+
+#include "papas/datatypes/Definitions.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "spdlog/details/format.h"
+
+namespace papas {
+
+class Cluster;
+class Track;
+class Particle;
+class PFBlock;
+
+/** Compact binary physics debug trace
+ *
+ * PTrace records the same information as the text PDebug output, but instead of formatting each line it appends a
+ * typed binary record to a file. Each record holds the format string (written once and afterwards referred to by
+ * its index) and the values of its arguments: for a Cluster, Track, Particle or PFBlock only the numbers needed to
+ * print it are kept. The text output can be rendered again, and two traces compared, with PTraceReader (see
+ * the papastrace tool).
+ *
+ * PTrace is normally used via PDebug:
+ * @code
+ *   PDebug::BinaryFile("physics.trace");  // instead of PDebug::File("physics.txt")
+ *   PDebug::write("Made {}", cluster);
+ * @endcode
+ *
+ * File layout (native byte order): the 8 byte header "PAPASTR1" followed by records
+ *   'F' uint32 index, uint8 kind, uint32 length, chars        - definition of a format string
+ *   'R' uint32 format index, uint8 kind, uint8 nargs, args     - one trace line
+ * where each argument is a tag character followed by its values (see PTrace::ArgTag).
+ */
+class PTrace {
+public:
+  /// What a trace record describes
+  enum RecordKind : uint8_t {
+    kMessage = 0,   ///< any other line eg "Simulating Photon"
+    kCreated,       ///< "Made {}": a cluster, track or particle was created
+    kSmeared,       ///< "Made Smeared{}"
+    kRejected,      ///< "Rejected Smeared{}"
+    kBlockMade,     ///< "Made {}" for a PFBlock
+    kReconstructed  ///< "Made {} from ..." a particle was reconstructed
+  };
+  /// Tags used to identify the type of an argument in the file
+  enum ArgTag : char {
+    kClusterArg = 'c',   ///< uint64 id, double energy, theta, phi, uint32 n, n x uint64 subcluster ids
+    kTrackArg = 't',     ///< uint64 id, double energy, pt, theta, phi
+    kParticleArg = 'p',  ///< uint64 id, int32 pdgid, double status, charge, e, theta, phi, mass
+    kBlockArg = 'b',     ///< uint64 id, uint8 has edges, uint32 n, n x uint64 element ids,
+                         ///< uint32 m, m x (uint32 row, uint32 column, double distance)
+    kIntArg = 'i',       ///< int64
+    kUnsignedArg = 'u',  ///< uint64
+    kDoubleArg = 'd',    ///< double
+    kStringArg = 's'     ///< uint32 length, chars
+  };
+
+  /** Opens the trace file (an existing file is overwritten). Throws if the file cannot be opened.
+   * @param[in] fname filename
+   */
+  static void open(const std::string& fname);
+  static void close();                        ///< flushes and closes the trace file
+  static void flush();                        ///< writes out buffered records
+  static bool isOpen() { return s_file != nullptr; }  ///< whether a trace file is open
+  static RecordKind kind(const char* fmt);    ///< kind of record for a format string
+
+  /// Adds a record to the trace (if it is open)
+  template <typename... Args>
+  static void write(const char* fmt, const Args&... args) {
+    if (s_file == nullptr) return;
+    std::lock_guard<std::mutex> guard(s_mutex);
+    beginRecord(fmt, sizeof...(args));
+    int dummy[] = {0, (addArg(args), 0)...};
+    (void)dummy;
+    endRecord();
+  }
+
+private:
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                 !std::is_same<T, char>::value>::type
+  addArg(const T& t) {
+    if (std::is_signed<T>::value)
+      addInteger(static_cast<int64_t>(t));
+    else
+      addUnsigned(static_cast<uint64_t>(t));
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type addArg(const T& t) {
+    addDouble(t);
+  }
+  template <typename T>
+  static typename std::enable_if<!std::is_arithmetic<T>::value || std::is_same<T, bool>::value ||
+                                 std::is_same<T, char>::value>::type
+  addArg(const T& t) {
+    addObject(t);
+  }
+  static void addObject(const Cluster& cluster);
+  static void addObject(const Track& track);
+  static void addObject(const Particle& particle);
+  static void addObject(const PFBlock& block);
+  static void addObject(const std::string& s) { addString(s); }
+  static void addObject(const char* s) { addString(s); }
+  /// Anything else is stored as the text that PDebug would have written
+  template <typename T>
+  static void addObject(const T& t) {
+    addString(fmt::format("{}", t));
+  }
+  static void addInteger(int64_t value);
+  static void addUnsigned(uint64_t value);
+  static void addDouble(double value);
+  static void addString(const std::string& s);
+  static void beginRecord(const char* fmt, std::size_t nargs);
+  static void endRecord();
+  template <typename T>
+  static void put(const T& value);  ///< appends the bytes of value to the record being built
+
+  static FILE* s_file;                    ///< trace file, or nullptr when tracing is off
+  static std::mutex s_mutex;              ///< records may be written from several threads
+  static std::vector<char> s_record;      ///< record being built
+  static std::size_t s_kindPosition;      ///< position of the kind byte within s_record
+  static bool s_firstArg;                 ///< whether the next argument is the first in the record
+  static std::vector<std::string> s_formatStrings;  ///< format strings seen so far, in order of their index
+  static std::vector<RecordKind> s_formatKinds;     ///< kind of each format string
+  static std::unordered_map<const char*, uint32_t> s_formatPointers;  ///< format index for each format address
+  static std::unordered_map<std::string, uint32_t> s_formatIndices;   ///< format index for each format string
+};
+}  // end namespace papas
+
+#endif /* utility_ptrace_h */
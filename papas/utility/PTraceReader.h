@@ -0,0 +1,90 @@
+#ifndef utility_ptracereader_h
+#define utility_ptracereader_h
+
+#include "papas/utility/PTrace.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace papas {
+
+/// One argument of a trace record, the meaning of the values depends on the tag (see PTrace::ArgTag)
+struct PTraceArg {
+  PTrace::ArgTag tag;             ///< type of argument
+  Identifier id = 0;              ///< identifier of a Cluster, Track, Particle or PFBlock, or an unsigned value
+  std::vector<int64_t> integers;  ///< integer values eg pdgid, or for a block whether it has edges followed by the
+                                  ///< row and column of each distance
+  std::vector<double> values;     ///< floating point values eg energy, theta, phi
+  std::vector<Identifier> ids;    ///< subcluster ids of a cluster or element ids of a block
+  std::string text;               ///< string argument
+};
+
+/// One line of a trace
+struct PTraceRecord {
+  PTrace::RecordKind kind;      ///< what the record describes
+  std::string format;           ///< format string as passed to PDebug::write
+  std::vector<PTraceArg> args;  ///< arguments
+};
+
+/** Reads a binary trace written by PTrace, renders it as the text PDebug output and compares two traces.
+ *
+ * Usage:
+ * @code
+ *   PTraceReader reader("physics.trace");
+ *   PTraceRecord record;
+ *   while (reader.next(record))
+ *     std::cout << PTraceReader::render(record) << std::endl;
+ * @endcode
+ */
+class PTraceReader {
+public:
+  /** Constructor, throws if the file cannot be opened or is not a trace
+   * @param[in] fname name of trace file
+   */
+  PTraceReader(const std::string& fname);
+  /** Reads the next record, returns false at the end of the file. Throws if the file is truncated.
+   * @param[out] record the record that has been read
+   */
+  bool next(PTraceRecord& record);
+  std::size_t numRecords() const { return m_numRecords; }  ///< number of records read so far
+
+  static std::string render(const PTraceRecord& record);  ///< the line that PDebug would have written
+  static std::string render(const PTraceArg& arg);        ///< text for one argument, as produced by operator<<
+  static const char* kindName(PTrace::RecordKind kind);   ///< eg "created"
+
+  /** Structural comparison of two records: the kinds, formats, argument types, identifiers and integers must
+   * match and floating point values must agree within a relative tolerance.
+   * @param[in] r1 first record
+   * @param[in] r2 second record
+   * @param[in] tolerance allowed relative difference for floating point values
+   * @return empty string if the records match, otherwise a description of the first difference
+   */
+  static std::string compare(const PTraceRecord& r1, const PTraceRecord& r2, double tolerance = 0.);
+
+  /** Compares two trace files record by record and writes the differences found
+   * @param[in] fname1 first trace
+   * @param[in] fname2 second trace
+   * @param[in] out where to describe the differences
+   * @param[in] tolerance allowed relative difference for floating point values
+   * @param[in] maxReported stop after this many differences have been written
+   * @return number of records that differ (including records present in only one trace)
+   */
+  static std::size_t diff(const std::string& fname1, const std::string& fname2, std::ostream& out,
+                          double tolerance = 0., std::size_t maxReported = 10);
+
+private:
+  template <typename T>
+  T get();  ///< reads a value, throws if the file ends
+  std::string getString(uint32_t length);
+  void readArg(PTraceArg& arg);
+
+  std::ifstream m_in;                       ///< the trace file
+  std::string m_fname;                      ///< name of the trace file
+  std::vector<std::string> m_formats;       ///< format strings indexed by their number
+  std::size_t m_numRecords;                 ///< number of records read so far
+};
+}  // end namespace papas
+
+#endif /* utility_ptracereader_h */
@@ -0,0 +1,92 @@
+#ifndef utility_perfcounters_h
+#define utility_perfcounters_h
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace papas {
+
+/** Samples hardware performance counters (cycles, instructions, last level cache misses, branch misses) around each
+ *  PapasManager stage, so that the cost of a stage can be expressed as IPC and misses per object processed
+ *
+ * The counters are opened with the Linux perf_event_open system call, once per thread, and count only the calling
+ * thread in user space. If they cannot be opened (not Linux, no PMU in a virtual machine, or a restrictive
+ * /proc/sys/kernel/perf_event_paranoid) the stages are still timed and the report says which counters are missing.
+ * When sampling is not started a Scope costs a single test of a flag.
+ *
+ * Usage:
+ * @code
+ *   PerfCounters::start();
+ *   {
+ *     PerfCounters::Scope scope(PerfCounters::kMerge);
+ *     scope.setObjects(clusters.size());
+ *     ...
+ *   }
+ *   std::cout << PerfCounters::report();
+ * @endcode
+ */
+class PerfCounters {
+public:
+  /// Stages that are sampled
+  enum Stage { kSimulate = 0, kMerge, kBlockBuild, kSimplify, kReconstruct, kNumStages };
+  /// Hardware counters
+  enum Counter { kCycles = 0, kInstructions, kCacheMisses, kBranchMisses, kNumCounters };
+  /// Sum over all the samples of one stage
+  struct Totals {
+    uint64_t calls = 0;                        ///< number of times the stage was sampled
+    uint64_t objects = 0;                      ///< number of objects processed (see Scope::setObjects)
+    double seconds = 0;                        ///< wall clock time
+    std::array<double, kNumCounters> counts{};  ///< counter values (scaled if the kernel multiplexed them)
+  };
+
+  /// Samples the counters of the calling thread from its construction to its destruction
+  class Scope {
+  public:
+    /** Constructor
+     * @param[in] stage stage to which the sample is added
+     */
+    Scope(Stage stage);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    /** Sets the number of objects processed by the stage (eg clusters in), used to normalise the counts
+     * @param[in] n number of objects
+     */
+    void setObjects(uint64_t n) { m_objects = n; }
+
+  private:
+    Stage m_stage;
+    bool m_on;  ///< whether sampling was on when the scope started
+    uint64_t m_objects;
+    std::chrono::steady_clock::time_point m_start;
+    std::array<double, kNumCounters> m_counts;  ///< counter values at the start
+  };
+
+  static void start();  ///< starts sampling, clearing the totals
+  static void stop() { s_on = false; }                                  ///< stops sampling, totals are kept
+  static bool isOn() { return s_on.load(std::memory_order_relaxed); }  ///< whether stages are being sampled
+  /** Whether a hardware counter could be opened (on the calling thread)
+   * @param[in] counter the counter
+   */
+  static bool hasCounter(Counter counter);
+  static Totals totals(Stage stage);       ///< sum of the samples of a stage
+  static const char* stageName(Stage stage);        ///< eg "merge clusters"
+  static const char* counterName(Counter counter);  ///< eg "cycles"
+  /// Table of time, IPC and cycles/misses per object for each stage
+  static std::string report();
+
+private:
+  /// Reads the current (scaled) values of the counters of the calling thread, NaN for unavailable counters
+  static std::array<double, kNumCounters> read();
+
+  static std::atomic<bool> s_on;                    ///< whether stages are being sampled
+  static std::mutex s_mutex;                        ///< protects s_totals
+  static std::array<Totals, kNumStages> s_totals;  ///< totals for each stage
+};
+}  // end namespace papas
+
+#endif /* utility_perfcounters_h */
@@ -0,0 +1,81 @@
+#ifndef utility_processpool_h
+#define utility_processpool_h
+
+#include "papas/utility/Metrics.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace papas {
+
+/** Runs a range of events in forked worker processes and collects a summary of each event through shared memory
+ *
+ * The parent sets up everything that the workers share (eg the detector and the PapasManager) and then calls run(),
+ * which forks the workers. Each worker processes a contiguous block of the events, so the workers do not share any
+ * ROOT state and nothing needs to be thread safe. The summary of each event (time, number of reconstructed
+ * particles and the Metrics counters) is written into a slot of an anonymous shared mapping that the parent reads
+ * once the workers have finished.
+ *
+ * Output files should be opened by each worker (in workerStart) under workerFileName() and merged by the parent
+ * with mergeFiles(): as the blocks of events are in worker order the merged file is in event order.
+ * A worker ends with _exit() so that it does not run the parent's exit handlers: workerEnd must flush and close
+ * whatever the worker wrote (eg PDebug::flush()).
+ *
+ * With one worker (or none) the events are run in this process, without forking.
+ *
+ * Usage:
+ * @code
+ *   CMS cms;
+ *   PapasManager papasManager(cms);
+ *   auto summaries = ProcessPool::run(8, 0, 1000, [&](unsigned int eventNo) {
+ *     ... simulate and reconstruct event eventNo ...
+ *     return papasManager.event().particles('r').size();
+ *   });
+ * @endcode
+ */
+class ProcessPool {
+public:
+  /// Summary of one event, filled in by a worker
+  struct EventSummary {
+    uint32_t eventNo;        ///< event number
+    uint32_t worker;         ///< worker that processed the event
+    uint32_t done;           ///< 1 once the event has been processed
+    double seconds;          ///< time taken by the event
+    uint64_t reconstructed;  ///< number returned by the process function, eg reconstructed particles
+    uint64_t counters[Metrics::kNumCounters];  ///< Metrics counters of the event (zero if Metrics is not on)
+  };
+  typedef std::function<std::size_t(unsigned int eventNo)> Process;  ///< processes one event
+  typedef std::function<void(unsigned int worker)> WorkerHook;        ///< called at the start or end of a worker
+
+  /** Processes events firstEvent .. firstEvent + nEvents - 1 in nWorkers processes.
+   * If Metrics is on, the counters of each event are read after process() returns and the event is ended, so
+   * process() should not call Metrics::endEvent() itself. Each worker restarts Metrics (without a CSV file) and the
+   * parent ends the events of all the workers in event order once they have finished, so the Metrics CSV file and
+   * totals of the parent are as for a single process run (but the block size and shape histograms are not
+   * collected). Throws std::runtime_error if a worker cannot be started or does not finish successfully (eg
+   * process() threw).
+   * @param[in] nWorkers number of worker processes
+   * @param[in] firstEvent first event number
+   * @param[in] nEvents number of events
+   * @param[in] process called by a worker for each of its events
+   * @param[in] workerStart called by each worker before its first event, eg to open its input and output files
+   * @param[in] workerEnd called by each worker after its last event, eg to flush its output files
+   * @return summaries of the events, in event order
+   */
+  static std::vector<EventSummary> run(unsigned int nWorkers, unsigned int firstEvent, unsigned int nEvents,
+                                       const Process& process, const WorkerHook& workerStart = WorkerHook(),
+                                       const WorkerHook& workerEnd = WorkerHook());
+  /// Name of the file that a worker should write instead of fname eg "physics.txt" -> "physics.txt.3"
+  static std::string workerFileName(const std::string& fname, unsigned int worker);
+  /** Concatenates the workers' files (see workerFileName) into fname in worker order and deletes them.
+   * Missing worker files are skipped. Throws std::runtime_error if fname cannot be written.
+   * @param[in] fname merged file name
+   * @param[in] nWorkers number of workers
+   */
+  static void mergeFiles(const std::string& fname, unsigned int nWorkers);
+};
+}  // end namespace papas
+
+#endif /* utility_processpool_h */
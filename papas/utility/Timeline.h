@@ -0,0 +1,114 @@
+#ifndef utility_timeline_h
+#define utility_timeline_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace papas {
+
+/** Records a timeline of spans (eg one event, one PapasManager stage, one block) for every thread and writes it
+ *  in the Chrome trace-event JSON format, which can be opened in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Each thread records into its own fixed size ring buffer, so recording needs no locks. When a buffer is full the
+ * oldest spans of that thread are overwritten. Names and categories must be string literals (only the pointers are
+ * stored). When the timeline is not started a Span costs a single test of a flag.
+ *
+ * start() may be called again while other threads are recording. Spans that were open across the restart are
+ * dropped when they close, as their start time belongs to the old timeline. The old buffers are not deleted (a
+ * thread may still be writing into one) but are kept in a pool and reused by the threads of the next timeline.
+ *
+ * Usage:
+ * @code
+ *   Timeline::start();
+ *   {
+ *     Timeline::Span span("reconstruct", "stage");
+ *     ...
+ *   }
+ *   Timeline::write("timeline.json");  // once the threads have finished recording
+ * @endcode
+ */
+class Timeline {
+public:
+  /// Records the time from its construction to its destruction as a span
+  class Span {
+  public:
+    /** Constructor
+     * @param[in] name name of the span eg "simulate" (string literal)
+     * @param[in] category category eg "stage", "event", "io", "block" (string literal)
+     * @param[in] arg optional number shown with the span eg event number, negative for none
+     */
+    Span(const char* name, const char* category, int64_t arg = -1)
+        : m_name(name), m_category(category), m_arg(arg), m_generation(s_generation), m_start(s_on ? now() : 0) {}
+    ~Span() {
+      if (s_on && m_start) record(m_name, m_category, m_start, now(), m_arg, m_generation);
+    }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+  private:
+    const char* m_name;
+    const char* m_category;
+    int64_t m_arg;
+    uint64_t m_generation;  ///< timeline in which the span started, read before m_start
+    int64_t m_start;  ///< start time in ns, zero if the timeline was off when the span started
+  };
+
+  /** Starts recording, clearing anything recorded before
+   * @param[in] spansPerThread size of the ring buffer of each thread (rounded up to a power of 2)
+   */
+  static void start(std::size_t spansPerThread = 1 << 16);
+  static void stop() { s_on = false; }  ///< stops recording, what has been recorded can still be written
+  static bool isOn() { return s_on; }   ///< whether spans are being recorded
+  /// Name shown for the calling thread (string literal), eg "worker"
+  static void setThreadName(const char* name);
+  /** Writes all the recorded spans in Chrome trace-event JSON format. Should only be called when no spans are
+   * being recorded. Throws if the file cannot be written.
+   * @param[in] fname name of output file eg "timeline.json"
+   */
+  static void write(const std::string& fname);
+  static std::size_t size();  ///< number of spans currently held in all the buffers
+  static int64_t now() {      ///< nanoseconds since the timeline was started (never zero)
+    return steadyNanoseconds() - s_epoch.load(std::memory_order_relaxed) + 1;
+  }
+
+private:
+  struct Record {
+    const char* name;
+    const char* category;
+    int64_t start;  ///< ns
+    int64_t end;    ///< ns
+    int64_t arg;
+  };
+  /// Single producer ring buffer owned by one thread
+  struct ThreadBuffer {
+    ThreadBuffer(std::size_t capacity) : records(capacity), head(0), generation(0), tid(0), name(nullptr) {}
+    std::vector<Record> records;
+    std::atomic<uint64_t> head;  ///< number of spans ever recorded by this thread
+    uint64_t generation;         ///< timeline the buffer is recording
+    uint32_t tid;                ///< small thread number used in the output
+    const char* name;            ///< optional thread name
+  };
+  static void record(const char* name, const char* category, int64_t start, int64_t end, int64_t arg,
+                     uint64_t generation);
+  static ThreadBuffer& threadBuffer();  ///< buffer of the calling thread, created on first use
+  static int64_t steadyNanoseconds() {  ///< steady clock time in ns
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  static std::atomic<bool> s_on;                             ///< whether spans are being recorded
+  static std::atomic<int64_t> s_epoch;                       ///< steady clock time (ns) at which it was started
+  static std::atomic<uint64_t> s_generation;                 ///< incremented by start(), invalidates old buffers
+  static std::size_t s_capacity;                             ///< ring buffer size (power of 2)
+  static std::mutex s_mutex;                                 ///< protects s_buffers
+  static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;  ///< one buffer per thread that has recorded
+  static std::vector<std::unique_ptr<ThreadBuffer>> s_retired;  ///< buffers of earlier starts, reused by threadBuffer
+};
+}  // end namespace papas
+
+#endif /* utility_timeline_h */
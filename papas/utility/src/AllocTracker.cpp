@@ -0,0 +1,180 @@
+#include "papas/utility/AllocTracker.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace papas {
+
+#ifdef PAPAS_ALLOC_TRACKING
+thread_local AllocTracker::Stage AllocTracker::s_stage = AllocTracker::kUnscoped;
+#endif
+AllocTracker::StageCounts AllocTracker::s_lastEvent;
+AllocTracker::StageCounts AllocTracker::s_runTotals;
+unsigned int AllocTracker::s_numEvents = 0;
+
+namespace {
+/// Running counts of one stage. These are zero initialised before any dynamic initialisation (atomics have trivial
+/// default constructors), so operator new may be used by static constructors in other translation units.
+struct AtomicCounts {
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> bytes;
+  std::atomic<uint64_t> deallocations;
+};
+AtomicCounts stageCounts[AllocTracker::kNumStages];
+std::atomic<uint64_t> live;  ///< bytes currently allocated
+std::atomic<uint64_t> peak;  ///< peak of live since resetPeak
+}
+
+bool AllocTracker::isEnabled() {
+#ifdef PAPAS_ALLOC_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AllocTracker::recordAllocation(std::size_t size) {
+#ifdef PAPAS_ALLOC_TRACKING
+  auto& counts = stageCounts[s_stage];
+  counts.allocations.fetch_add(1, std::memory_order_relaxed);
+  counts.bytes.fetch_add(size, std::memory_order_relaxed);
+  uint64_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+  uint64_t before = peak.load(std::memory_order_relaxed);
+  while (now > before && !peak.compare_exchange_weak(before, now, std::memory_order_relaxed)) {
+  }
+#else
+  (void)size;
+#endif
+}
+
+void AllocTracker::recordDeallocation(std::size_t size) {
+#ifdef PAPAS_ALLOC_TRACKING
+  stageCounts[s_stage].deallocations.fetch_add(1, std::memory_order_relaxed);
+  live.fetch_sub(size, std::memory_order_relaxed);
+#else
+  (void)size;
+#endif
+}
+
+uint64_t AllocTracker::liveBytes() { return live.load(std::memory_order_relaxed); }
+
+uint64_t AllocTracker::peakBytes() { return peak.load(std::memory_order_relaxed); }
+
+void AllocTracker::resetPeak() { peak.store(live.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+AllocTracker::StageCounts AllocTracker::counts() {
+  StageCounts counts;
+  for (unsigned int s = 0; s < kNumStages; ++s) {
+    counts[s].allocations = stageCounts[s].allocations.load(std::memory_order_relaxed);
+    counts[s].bytes = stageCounts[s].bytes.load(std::memory_order_relaxed);
+    counts[s].deallocations = stageCounts[s].deallocations.load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+AllocTracker::StageCounts AllocTracker::endEvent() {
+  StageCounts now = counts();
+  StageCounts event;
+  for (unsigned int s = 0; s < kNumStages; ++s) {
+    event[s].allocations = now[s].allocations - s_lastEvent[s].allocations;
+    event[s].bytes = now[s].bytes - s_lastEvent[s].bytes;
+    event[s].deallocations = now[s].deallocations - s_lastEvent[s].deallocations;
+    s_runTotals[s].allocations += event[s].allocations;
+    s_runTotals[s].bytes += event[s].bytes;
+    s_runTotals[s].deallocations += event[s].deallocations;
+  }
+  s_lastEvent = now;
+  ++s_numEvents;
+  return event;
+}
+
+void AllocTracker::resetRun() {
+  s_lastEvent = counts();
+  s_runTotals = StageCounts();
+  s_numEvents = 0;
+}
+
+const char* AllocTracker::stageName(Stage stage) {
+  static const char* names[] = {"unscoped",       "simulate",    "merge clusters", "build blocks",
+                                "simplify blocks", "reconstruct", "io"};
+  return (stage < kNumStages) ? names[stage] : "unknown";
+}
+
+std::string AllocTracker::summary(const StageCounts& counts, unsigned int nEvents) {
+  if (!isEnabled()) return "allocation tracking not compiled in (cmake -Dpapas_alloc_tracking=ON)\n";
+  if (nEvents == 0) nEvents = 1;
+  char line[200];
+  std::snprintf(line, sizeof(line), "%-16s %14s %16s %14s %14s %14s\n", "stage", "allocations", "bytes",
+                "deallocations", "allocs/event", "bytes/event");
+  std::string text = line;
+  Counts total;
+  for (unsigned int s = 0; s <= kNumStages; ++s) {
+    const Counts& c = (s < kNumStages) ? counts[s] : total;
+    if (s < kNumStages) {
+      total.allocations += c.allocations;
+      total.bytes += c.bytes;
+      total.deallocations += c.deallocations;
+    }
+    std::snprintf(line, sizeof(line), "%-16s %14llu %16llu %14llu %14.1f %14.1f\n",
+                  (s < kNumStages) ? stageName(static_cast<Stage>(s)) : "total", (unsigned long long)c.allocations,
+                  (unsigned long long)c.bytes, (unsigned long long)c.deallocations, double(c.allocations) / nEvents,
+                  double(c.bytes) / nEvents);
+    text += line;
+  }
+  return text;
+}
+
+}  // end namespace papas
+
+#ifdef PAPAS_ALLOC_TRACKING
+// Replacements for the global allocation functions (the aligned forms of C++17 are not used by papas).
+// Each block starts with a header holding the requested size, so that operator delete knows how many bytes are freed.
+namespace {
+const std::size_t kHeaderSize = alignof(std::max_align_t);  ///< keeps the returned memory suitably aligned
+
+void* trackedAllocate(std::size_t size) {
+  papas::AllocTracker::recordAllocation(size);
+  void* p;
+  while ((p = std::malloc(size + kHeaderSize)) == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+  *static_cast<std::size_t*>(p) = size;
+  return static_cast<char*>(p) + kHeaderSize;
+}
+
+void trackedFree(void* p) noexcept {
+  if (p == nullptr) return;
+  void* block = static_cast<char*>(p) - kHeaderSize;
+  papas::AllocTracker::recordDeallocation(*static_cast<std::size_t*>(block));
+  std::free(block);
+}
+}
+
+void* operator new(std::size_t size) { return trackedAllocate(size); }
+void* operator new[](std::size_t size) { return trackedAllocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return trackedAllocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return trackedAllocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+#endif
@@ -0,0 +1,191 @@
+#include "papas/utility/Metrics.h"
+
+#include <algorithm>
+
+namespace papas {
+
+std::atomic<bool> Metrics::s_on(false);
+std::array<std::atomic<uint64_t>, Metrics::kNumCounters> Metrics::s_event;
+std::mutex Metrics::s_mutex;
+unsigned int Metrics::s_numEvents = 0;
+uint64_t Metrics::s_maxBlockSize = 0;
+std::array<uint64_t, Metrics::kNumCounters> Metrics::s_totals;
+std::array<Metrics::Histogram, Metrics::kNumCounters> Metrics::s_histograms;
+Metrics::Histogram Metrics::s_eventSeconds;
+std::array<uint64_t, Metrics::kNumSizeBuckets + 1> Metrics::s_blockSizes;
+uint64_t Metrics::s_blockSizeSum = 0;
+std::map<std::string, uint64_t> Metrics::s_blockShortNames;
+FILE* Metrics::s_csv = nullptr;
+
+namespace {
+/// upper bounds of the block size histogram
+const std::array<unsigned int, Metrics::kNumSizeBuckets> blockSizeBounds = {{1, 2, 3, 4, 5, 8, 16, 32, 64, 128}};
+/// smallest upper bound of the histogram of event times (seconds)
+const double firstSecondsBound = 1e-4;
+const char* descriptions[] = {"Clusters read by cluster merging",
+                              "Merged clusters made",
+                              "Distances computed by EventRuler",
+                              "Edges kept (linked or nearby)",
+                              "Edges kept that are linked",
+                              "Blocks reconstructed",
+                              "History nodes created",
+                              "History links made",
+                              "Particles reconstructed"};
+}
+
+void Metrics::Histogram::clear() {
+  counts.fill(0);
+  sum = 0;
+}
+
+void Metrics::Histogram::fill(double value, double firstBound) {
+  unsigned int bucket = 0;
+  double bound = firstBound;
+  while (bucket < kNumDecades && value > bound) {
+    ++bucket;
+    bound *= 10;
+  }
+  counts[bucket]++;
+  sum += value;
+}
+
+void Metrics::start(const std::string& csvName) {
+  stop();
+  std::lock_guard<std::mutex> guard(s_mutex);
+  for (auto& counter : s_event)
+    counter = 0;
+  s_numEvents = 0;
+  s_maxBlockSize = 0;
+  s_totals.fill(0);
+  for (auto& histogram : s_histograms)
+    histogram.clear();
+  s_eventSeconds.clear();
+  s_blockSizes.fill(0);
+  s_blockSizeSum = 0;
+  s_blockShortNames.clear();
+  if (!csvName.empty()) {
+    s_csv = std::fopen(csvName.c_str(), "w");
+    if (s_csv == nullptr) throw std::string("Metrics: unable to open " + csvName);
+    std::fprintf(s_csv, "event,seconds");
+    for (unsigned int c = 0; c < kNumCounters; ++c)
+      std::fprintf(s_csv, ",%s", name(static_cast<Counter>(c)));
+    std::fprintf(s_csv, ",max_block_size\n");
+  }
+  s_on = true;
+}
+
+void Metrics::stop() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_on = false;
+  if (s_csv != nullptr) std::fclose(s_csv);
+  s_csv = nullptr;
+}
+
+void Metrics::addBlock(const std::string& shortName, unsigned int size) {
+  if (!isOn()) return;
+  add(kBlocks);
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_maxBlockSize = std::max<uint64_t>(s_maxBlockSize, size);
+  auto bucket = std::lower_bound(blockSizeBounds.begin(), blockSizeBounds.end(), size) - blockSizeBounds.begin();
+  s_blockSizes[bucket]++;
+  s_blockSizeSum += size;
+  s_blockShortNames[shortName]++;
+}
+
+void Metrics::endEvent(unsigned int eventNo, double seconds) {
+  if (!isOn()) return;
+  std::lock_guard<std::mutex> guard(s_mutex);
+  std::array<uint64_t, kNumCounters> values;
+  for (unsigned int c = 0; c < kNumCounters; ++c)
+    values[c] = s_event[c].exchange(0);
+  if (s_csv != nullptr) {
+    std::fprintf(s_csv, "%u,%.6f", eventNo, seconds);
+    for (auto value : values)
+      std::fprintf(s_csv, ",%llu", static_cast<unsigned long long>(value));
+    std::fprintf(s_csv, ",%llu\n", static_cast<unsigned long long>(s_maxBlockSize));
+  }
+  for (unsigned int c = 0; c < kNumCounters; ++c) {
+    s_totals[c] += values[c];
+    s_histograms[c].fill(values[c], 1.);
+  }
+  if (seconds >= 0) s_eventSeconds.fill(seconds, firstSecondsBound);
+  s_maxBlockSize = 0;
+  ++s_numEvents;
+}
+
+uint64_t Metrics::total(Counter counter) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  return s_totals[counter];
+}
+
+unsigned int Metrics::numEvents() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  return s_numEvents;
+}
+
+const char* Metrics::name(Counter counter) {
+  static const char* names[] = {"clusters_in",  "merged_clusters_out", "distance_evaluations",
+                                "edges_created", "edges_linked",        "blocks",
+                                "history_nodes", "history_links",       "particles_reconstructed"};
+  return (counter < kNumCounters) ? names[counter] : "unknown";
+}
+
+namespace {
+/// writes a histogram whose buckets are the decades firstBound, 10*firstBound ...
+void writeDecades(FILE* file, const std::string& metric, const uint64_t* counts, unsigned int numDecades, double sum,
+                  double firstBound) {
+  uint64_t cumulative = 0;
+  double bound = firstBound;
+  for (unsigned int i = 0; i < numDecades; ++i) {
+    cumulative += counts[i];
+    std::fprintf(file, "%s_bucket{le=\"%g\"} %llu\n", metric.c_str(), bound, (unsigned long long)cumulative);
+    bound *= 10;
+  }
+  cumulative += counts[numDecades];
+  std::fprintf(file, "%s_bucket{le=\"+Inf\"} %llu\n", metric.c_str(), (unsigned long long)cumulative);
+  std::fprintf(file, "%s_sum %.17g\n", metric.c_str(), sum);
+  std::fprintf(file, "%s_count %llu\n", metric.c_str(), (unsigned long long)cumulative);
+}
+}
+
+void Metrics::writePrometheus(const std::string& fname) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  FILE* file = std::fopen(fname.c_str(), "w");
+  if (file == nullptr) throw std::string("Metrics: unable to open " + fname);
+  std::fprintf(file, "# HELP papas_events_total Events processed\n# TYPE papas_events_total counter\n");
+  std::fprintf(file, "papas_events_total %u\n", s_numEvents);
+  for (unsigned int c = 0; c < kNumCounters; ++c) {
+    std::string metric = std::string("papas_") + name(static_cast<Counter>(c));
+    std::fprintf(file, "# HELP %s_total %s\n# TYPE %s_total counter\n", metric.c_str(), descriptions[c],
+                 metric.c_str());
+    std::fprintf(file, "%s_total %llu\n", metric.c_str(), (unsigned long long)s_totals[c]);
+  }
+  for (unsigned int c = 0; c < kNumCounters; ++c) {
+    std::string metric = std::string("papas_event_") + name(static_cast<Counter>(c));
+    std::fprintf(file, "# HELP %s %s per event\n# TYPE %s histogram\n", metric.c_str(), descriptions[c],
+                 metric.c_str());
+    writeDecades(file, metric, s_histograms[c].counts.data(), kNumDecades, s_histograms[c].sum, 1.);
+  }
+  std::fprintf(file, "# HELP papas_event_seconds Time per event\n# TYPE papas_event_seconds histogram\n");
+  writeDecades(file, "papas_event_seconds", s_eventSeconds.counts.data(), kNumDecades, s_eventSeconds.sum,
+               firstSecondsBound);
+  std::fprintf(file, "# HELP papas_block_size Elements per reconstructed block\n# TYPE papas_block_size histogram\n");
+  uint64_t cumulative = 0;
+  for (unsigned int i = 0; i < kNumSizeBuckets; ++i) {
+    cumulative += s_blockSizes[i];
+    std::fprintf(file, "papas_block_size_bucket{le=\"%u\"} %llu\n", blockSizeBounds[i],
+                 (unsigned long long)cumulative);
+  }
+  cumulative += s_blockSizes[kNumSizeBuckets];
+  std::fprintf(file, "papas_block_size_bucket{le=\"+Inf\"} %llu\n", (unsigned long long)cumulative);
+  std::fprintf(file, "papas_block_size_sum %llu\npapas_block_size_count %llu\n", (unsigned long long)s_blockSizeSum,
+               (unsigned long long)cumulative);
+  std::fprintf(file, "# HELP papas_blocks_by_shortname_total Reconstructed blocks of each type\n");
+  std::fprintf(file, "# TYPE papas_blocks_by_shortname_total counter\n");
+  for (const auto& shortName : s_blockShortNames)
+    std::fprintf(file, "papas_blocks_by_shortname_total{shortname=\"%s\"} %llu\n", shortName.first.c_str(),
+                 (unsigned long long)shortName.second);
+  if (std::fclose(file) != 0) throw std::string("Metrics: unable to write " + fname);
+}
+
+}  // end namespace papas
@@ -0,0 +1,202 @@
+#include "papas/utility/PTrace.h"
+
+#include "papas/datatypes/Cluster.h"
+#include "papas/datatypes/Particle.h"
+#include "papas/datatypes/Track.h"
+#include "papas/reconstruction/PFBlock.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace papas {
+
+FILE* PTrace::s_file = nullptr;
+std::mutex PTrace::s_mutex;
+std::vector<char> PTrace::s_record;
+std::size_t PTrace::s_kindPosition = 0;
+bool PTrace::s_firstArg = true;
+std::vector<std::string> PTrace::s_formatStrings;
+std::vector<PTrace::RecordKind> PTrace::s_formatKinds;
+std::unordered_map<const char*, uint32_t> PTrace::s_formatPointers;
+std::unordered_map<std::string, uint32_t> PTrace::s_formatIndices;
+
+namespace {
+/// makes sure that the trace is flushed and closed at the end of the program
+struct PTraceCloser {
+  ~PTraceCloser() { PTrace::close(); }
+} ptraceCloser;
+}
+
+void PTrace::open(const std::string& fname) {
+  close();
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_file = std::fopen(fname.c_str(), "wb");
+  if (s_file == nullptr) throw std::string("PTrace: unable to open trace file " + fname);
+  std::setvbuf(s_file, nullptr, _IOFBF, 1 << 20);
+  std::fwrite("PAPASTR1", 1, 8, s_file);
+  // format indices are local to a file
+  s_formatStrings.clear();
+  s_formatKinds.clear();
+  s_formatPointers.clear();
+  s_formatIndices.clear();
+}
+
+void PTrace::close() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  if (s_file == nullptr) return;
+  std::fclose(s_file);
+  s_file = nullptr;
+}
+
+void PTrace::flush() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  if (s_file != nullptr) std::fflush(s_file);
+}
+
+PTrace::RecordKind PTrace::kind(const char* fmt) {
+  if (std::strncmp(fmt, "Made Smeared", 12) == 0) return kSmeared;
+  if (std::strncmp(fmt, "Rejected", 8) == 0) return kRejected;
+  if (std::strncmp(fmt, "Made", 4) == 0) return std::strstr(fmt, " from ") ? kReconstructed : kCreated;
+  return kMessage;
+}
+
+template <typename T>
+void PTrace::put(const T& value) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  s_record.insert(s_record.end(), bytes, bytes + sizeof(T));
+}
+
+void PTrace::beginRecord(const char* fmt, std::size_t nargs) {
+  // find the index of the format string, the address is checked first as formats are nearly always literals
+  uint32_t index;
+  auto found = s_formatPointers.find(fmt);
+  if (found != s_formatPointers.end() && s_formatStrings[found->second] == fmt) {
+    index = found->second;
+  } else {
+    auto foundString = s_formatIndices.find(fmt);
+    if (foundString != s_formatIndices.end()) {
+      index = foundString->second;
+    } else {  // new format string so write its definition
+      index = s_formatStrings.size();
+      s_formatStrings.emplace_back(fmt);
+      s_formatKinds.push_back(kind(fmt));
+      s_formatIndices.emplace(fmt, index);
+      uint32_t length = s_formatStrings.back().size();
+      s_record.clear();
+      put('F');
+      put(index);
+      put(s_formatKinds.back());
+      put(length);
+      s_record.insert(s_record.end(), fmt, fmt + length);
+      std::fwrite(s_record.data(), 1, s_record.size(), s_file);
+    }
+    s_formatPointers[fmt] = index;
+  }
+  s_record.clear();
+  put('R');
+  put(index);
+  s_kindPosition = s_record.size();
+  put(s_formatKinds[index]);
+  put(static_cast<uint8_t>(nargs));
+  s_firstArg = true;
+}
+
+void PTrace::endRecord() { std::fwrite(s_record.data(), 1, s_record.size(), s_file); }
+
+void PTrace::addObject(const Cluster& cluster) {
+  put(kClusterArg);
+  put(cluster.id());
+  put(cluster.energy());
+  put(cluster.theta());
+  put(cluster.position().Phi());
+  put(static_cast<uint32_t>(cluster.subClusters().size()));
+  for (const auto& c : cluster.subClusters())
+    put(c->id());
+  s_firstArg = false;
+}
+
+void PTrace::addObject(const Track& track) {
+  put(kTrackArg);
+  put(track.id());
+  put(track.energy());
+  put(track.p3().Perp());
+  put(M_PI / 2. - track.p3().Theta());
+  put(track.p3().Phi());
+  s_firstArg = false;
+}
+
+void PTrace::addObject(const Particle& particle) {
+  put(kParticleArg);
+  put(particle.id());
+  put(static_cast<int32_t>(particle.pdgId()));
+  put(particle.status());
+  put(particle.charge());
+  put(particle.e());
+  put(particle.theta());
+  put(particle.phi());
+  put(std::fabs(particle.mass()));
+  s_firstArg = false;
+}
+
+void PTrace::addObject(const PFBlock& block) {
+  if (s_firstArg && static_cast<RecordKind>(s_record[s_kindPosition]) == kCreated)
+    s_record[s_kindPosition] = kBlockMade;
+  put(kBlockArg);
+  put(block.id());
+  put(static_cast<uint8_t>(block.numEdges() > 0));
+  const auto& ids = block.elementIds();
+  put(static_cast<uint32_t>(ids.size()));
+  for (auto id : ids)
+    put(id);
+  // only the edges that are printed as distances are kept, ie linked edges with a distance
+  auto countPosition = s_record.size();
+  put(static_cast<uint32_t>(0));
+  uint32_t count = 0;
+  uint32_t row = 0;
+  for (auto id1 : ids) {
+    uint32_t column = 0;
+    for (auto id2 : ids) {
+      if (column == row) break;
+      if (block.hasEdge(id1, id2)) {
+        Edge edge = block.edge(id1, id2);
+        if (edge.isLinked() && edge.distance() >= 0) {
+          put(row);
+          put(column);
+          put(edge.distance());
+          ++count;
+        }
+      }
+      ++column;
+    }
+    ++row;
+  }
+  std::memcpy(&s_record[countPosition], &count, sizeof(count));
+  s_firstArg = false;
+}
+
+void PTrace::addInteger(int64_t value) {
+  put(kIntArg);
+  put(value);
+  s_firstArg = false;
+}
+
+void PTrace::addUnsigned(uint64_t value) {
+  put(kUnsignedArg);
+  put(value);
+  s_firstArg = false;
+}
+
+void PTrace::addDouble(double value) {
+  put(kDoubleArg);
+  put(value);
+  s_firstArg = false;
+}
+
+void PTrace::addString(const std::string& s) {
+  put(kStringArg);
+  put(static_cast<uint32_t>(s.size()));
+  s_record.insert(s_record.end(), s.begin(), s.end());
+  s_firstArg = false;
+}
+
+}  // end namespace papas
@@ -0,0 +1,301 @@
+#include "papas/utility/PTraceReader.h"
+
+#include "papas/datatypes/IdCoder.h"
+#include "papas/utility/StringFormatter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace papas {
+
+PTraceReader::PTraceReader(const std::string& fname)
+    : m_in(fname, std::ios::binary), m_fname(fname), m_numRecords(0) {
+  if (!m_in) throw std::string("PTraceReader: unable to open " + fname);
+  char header[8];
+  if (!m_in.read(header, 8) || std::string(header, 8) != "PAPASTR1")
+    throw std::string("PTraceReader: " + fname + " is not a papas trace");
+}
+
+template <typename T>
+T PTraceReader::get() {
+  T value;
+  if (!m_in.read(reinterpret_cast<char*>(&value), sizeof(T)))
+    throw std::string("PTraceReader: " + m_fname + " is truncated");
+  return value;
+}
+
+std::string PTraceReader::getString(uint32_t length) {
+  std::string s(length, ' ');
+  if (length > 0 && !m_in.read(&s[0], length)) throw std::string("PTraceReader: " + m_fname + " is truncated");
+  return s;
+}
+
+bool PTraceReader::next(PTraceRecord& record) {
+  char type;
+  while (m_in.get(type)) {
+    if (type == 'F') {  // definition of a format string
+      auto index = get<uint32_t>();
+      get<uint8_t>();  // kind, which is repeated in each record
+      auto length = get<uint32_t>();
+      if (index >= m_formats.size()) m_formats.resize(index + 1);
+      m_formats[index] = getString(length);
+    } else if (type == 'R') {
+      auto index = get<uint32_t>();
+      if (index >= m_formats.size()) throw std::string("PTraceReader: undefined format in " + m_fname);
+      record.format = m_formats[index];
+      record.kind = static_cast<PTrace::RecordKind>(get<uint8_t>());
+      record.args.resize(get<uint8_t>());
+      for (auto& arg : record.args)
+        readArg(arg);
+      ++m_numRecords;
+      return true;
+    } else
+      throw std::string("PTraceReader: unknown record type in " + m_fname);
+  }
+  return false;
+}
+
+void PTraceReader::readArg(PTraceArg& arg) {
+  arg = PTraceArg();
+  arg.tag = static_cast<PTrace::ArgTag>(get<char>());
+  switch (arg.tag) {
+  case PTrace::kClusterArg: {
+    arg.id = get<Identifier>();
+    for (int i = 0; i < 3; ++i)
+      arg.values.push_back(get<double>());
+    auto n = get<uint32_t>();
+    for (uint32_t i = 0; i < n; ++i)
+      arg.ids.push_back(get<Identifier>());
+    break;
+  }
+  case PTrace::kTrackArg:
+    arg.id = get<Identifier>();
+    for (int i = 0; i < 4; ++i)
+      arg.values.push_back(get<double>());
+    break;
+  case PTrace::kParticleArg:
+    arg.id = get<Identifier>();
+    arg.integers.push_back(get<int32_t>());
+    for (int i = 0; i < 6; ++i)
+      arg.values.push_back(get<double>());
+    break;
+  case PTrace::kBlockArg: {
+    arg.id = get<Identifier>();
+    arg.integers.push_back(get<uint8_t>());
+    auto n = get<uint32_t>();
+    for (uint32_t i = 0; i < n; ++i)
+      arg.ids.push_back(get<Identifier>());
+    auto m = get<uint32_t>();
+    for (uint32_t i = 0; i < m; ++i) {
+      arg.integers.push_back(get<uint32_t>());
+      arg.integers.push_back(get<uint32_t>());
+      arg.values.push_back(get<double>());
+    }
+    break;
+  }
+  case PTrace::kIntArg:
+    arg.integers.push_back(get<int64_t>());
+    break;
+  case PTrace::kUnsignedArg:
+    arg.id = get<uint64_t>();
+    break;
+  case PTrace::kDoubleArg:
+    arg.values.push_back(get<double>());
+    break;
+  case PTrace::kStringArg:
+    arg.text = getString(get<uint32_t>());
+    break;
+  default:
+    throw std::string("PTraceReader: unknown argument type in " + m_fname);
+  }
+}
+
+namespace {
+/// Text of a block, as produced by operator<<(std::ostream&, const PFBlock&)
+std::string renderBlock(const PTraceArg& arg) {
+  fmt::MemoryWriter out;
+  unsigned int ecals = 0, hcals = 0, tracks = 0;
+  for (auto id : arg.ids) {
+    if (IdCoder::isEcal(id)) ++ecals;
+    if (IdCoder::isHcal(id)) ++hcals;
+    if (IdCoder::isTrack(id)) ++tracks;
+  }
+  fmt::MemoryWriter shortName;
+  if (ecals) shortName.write("E{}", ecals);
+  if (hcals) shortName.write("H{}", hcals);
+  if (tracks) shortName.write("T{}", tracks);
+  out.write("block:{:8} :{:6}: ecals = {} hcals = {} tracks = {}\n", shortName.str(), IdCoder::pretty(arg.id), ecals,
+            hcals, tracks);
+  out.write("    elements:\n");
+  int count = 0;
+  for (auto id : arg.ids) {
+    out.write("{:>7}{} = {:9} value={:5.1f} ({})\n", IdCoder::typeLetter(id), count, IdCoder::pretty(id),
+              IdCoder::value(id), id);
+    ++count;
+  }
+  if (arg.integers[0] && arg.ids.size() > 1) {
+    std::map<std::pair<int64_t, int64_t>, double> distances;
+    for (std::size_t i = 0; i < arg.values.size(); ++i)
+      distances[std::make_pair(arg.integers[1 + 2 * i], arg.integers[2 + 2 * i])] = arg.values[i];
+    out.write("    distances:\n        ");
+    for (std::size_t i = 0; i < arg.ids.size(); ++i)
+      out.write("{:>8}", IdCoder::typeLetter(arg.ids[i]) + std::to_string(i));
+    for (std::size_t row = 0; row < arg.ids.size(); ++row) {
+      out.write("\n{:>8}", IdCoder::typeLetter(arg.ids[row]) + std::to_string(row));
+      for (std::size_t column = 0; column < row; ++column) {
+        auto found = distances.find(std::make_pair(row, column));
+        if (found == distances.end())
+          out.write("     ---");
+        else
+          out.write("{:8.4f}", found->second);
+      }
+      out.write("       .");
+    }
+    out.write("\n");
+  }
+  return out.str();
+}
+
+/// Formats a value using a format specification from the trace format string eg "{:5}"
+template <typename T>
+std::string formatValue(const std::string& spec, const T& value) {
+  return spec.empty() ? fmt::format("{}", value) : fmt::format("{" + spec + "}", value);
+}
+}
+
+std::string PTraceReader::render(const PTraceArg& arg) {
+  switch (arg.tag) {
+  case PTrace::kClusterArg: {
+    fmt::MemoryWriter out;
+    out.write("Cluster: {:<6}:{}: ", IdCoder::pretty(arg.id), arg.id);
+    out << string_format("%7.2f %5.2f %5.2f", arg.values[0], arg.values[1], arg.values[2]);
+    out << " sub(";
+    if (arg.ids.empty())  // match python pdebug outputs
+      out << IdCoder::pretty(arg.id) << ", ";
+    for (auto id : arg.ids)
+      out << IdCoder::pretty(id) << ", ";
+    out << ")";
+    return out.str();
+  }
+  case PTrace::kTrackArg:
+    return fmt::format("Track: {:<6}:{}: ", IdCoder::pretty(arg.id), arg.id) +
+           string_format("%7.2f %7.2f %5.2f %5.2f", arg.values[0], arg.values[1], arg.values[2], arg.values[3]);
+  case PTrace::kParticleArg: {
+    fmt::MemoryWriter out;
+    out.write("Particle :{:<6}:{}: ", IdCoder::pretty(arg.id), arg.id);
+    out.write("pdgid = {:5}, status = {:3}, q = {:2}", static_cast<int>(arg.integers[0]), arg.values[0],
+              arg.values[1]);
+    out.write(", e = {:5.1f}, theta = {:5.2f}, phi = {:5.2f}, mass = {:5.2f}", arg.values[2], arg.values[3],
+              arg.values[4], arg.values[5]);
+    return out.str();
+  }
+  case PTrace::kBlockArg:
+    return renderBlock(arg);
+  case PTrace::kIntArg:
+    return fmt::format("{}", arg.integers[0]);
+  case PTrace::kUnsignedArg:
+    return fmt::format("{}", arg.id);
+  case PTrace::kDoubleArg:
+    return fmt::format("{}", arg.values[0]);
+  default:
+    return arg.text;
+  }
+}
+
+std::string PTraceReader::render(const PTraceRecord& record) {
+  // substitute the arguments into the format string, as fmt would
+  std::string out;
+  const auto& format = record.format;
+  std::size_t next = 0;
+  for (std::size_t i = 0; i < format.size(); ++i) {
+    char c = format[i];
+    if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {  // escaped brace
+      out += c;
+      ++i;
+    } else if (c == '{' && format.find('}', i) != std::string::npos) {
+      auto end = format.find('}', i);
+      std::string spec = format.substr(i + 1, end - i - 1);
+      i = end;
+      if (next >= record.args.size()) {
+        out += "{" + spec + "}";
+        continue;
+      }
+      const auto& arg = record.args[next++];
+      if (spec.empty() || spec[0] != ':') {
+        out += render(arg);
+      } else if (arg.tag == PTrace::kIntArg) {
+        out += formatValue(spec, arg.integers[0]);
+      } else if (arg.tag == PTrace::kUnsignedArg) {
+        out += formatValue(spec, arg.id);
+      } else if (arg.tag == PTrace::kDoubleArg) {
+        out += formatValue(spec, arg.values[0]);
+      } else {
+        out += formatValue(spec, render(arg));
+      }
+    } else
+      out += c;
+  }
+  return out;
+}
+
+const char* PTraceReader::kindName(PTrace::RecordKind kind) {
+  static const char* names[] = {"message", "created", "smeared", "rejected", "block made", "reconstructed"};
+  return (kind <= PTrace::kReconstructed) ? names[kind] : "unknown";
+}
+
+std::string PTraceReader::compare(const PTraceRecord& r1, const PTraceRecord& r2, double tolerance) {
+  if (r1.kind != r2.kind) return fmt::format("kind {} != {}", kindName(r1.kind), kindName(r2.kind));
+  if (r1.format != r2.format) return fmt::format("format \"{}\" != \"{}\"", r1.format, r2.format);
+  if (r1.args.size() != r2.args.size())
+    return fmt::format("number of arguments {} != {}", r1.args.size(), r2.args.size());
+  for (std::size_t i = 0; i < r1.args.size(); ++i) {
+    const auto& a1 = r1.args[i];
+    const auto& a2 = r2.args[i];
+    if (a1.tag != a2.tag) return fmt::format("argument {} type {} != {}", i, (char)a1.tag, (char)a2.tag);
+    if (a1.id != a2.id)
+      return fmt::format("argument {} id {} != {}", i, IdCoder::pretty(a1.id), IdCoder::pretty(a2.id));
+    if (a1.ids != a2.ids) return fmt::format("argument {} element or subcluster ids differ", i);
+    if (a1.integers != a2.integers) return fmt::format("argument {} integer values differ", i);
+    if (a1.text != a2.text) return fmt::format("argument {} text \"{}\" != \"{}\"", i, a1.text, a2.text);
+    if (a1.values.size() != a2.values.size()) return fmt::format("argument {} number of values differ", i);
+    for (std::size_t j = 0; j < a1.values.size(); ++j) {
+      double v1 = a1.values[j];
+      double v2 = a2.values[j];
+      if (std::isnan(v1) && std::isnan(v2)) continue;
+      if (v1 != v2 && !(std::fabs(v1 - v2) <= tolerance * std::max(std::fabs(v1), std::fabs(v2))))
+        return fmt::format("argument {} value {}: {} != {}", i, j, v1, v2);
+    }
+  }
+  return std::string();
+}
+
+std::size_t PTraceReader::diff(const std::string& fname1, const std::string& fname2, std::ostream& out,
+                               double tolerance, std::size_t maxReported) {
+  PTraceReader reader1(fname1);
+  PTraceReader reader2(fname2);
+  PTraceRecord r1, r2;
+  std::size_t ndiffs = 0;
+  auto report = [&](std::size_t recordNo, const std::string& what) {
+    ++ndiffs;
+    if (ndiffs <= maxReported) out << "record " << recordNo << ": " << what << std::endl;
+  };
+  while (true) {
+    bool has1 = reader1.next(r1);
+    bool has2 = reader2.next(r2);
+    if (!has1 && !has2) break;
+    if (has1 && !has2) {
+      report(reader1.numRecords(), "only in " + fname1 + "\n< " + render(r1));
+    } else if (has2 && !has1) {
+      report(reader2.numRecords(), "only in " + fname2 + "\n> " + render(r2));
+    } else {
+      auto difference = compare(r1, r2, tolerance);
+      if (!difference.empty())
+        report(reader1.numRecords(), difference + "\n< " + render(r1) + "\n> " + render(r2));
+    }
+  }
+  if (ndiffs > maxReported) out << "... " << ndiffs - maxReported << " more differences" << std::endl;
+  return ndiffs;
+}
+
+}  // end namespace papas
@@ -0,0 +1,151 @@
+#include "papas/utility/PerfCounters.h"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace papas {
+
+std::atomic<bool> PerfCounters::s_on(false);
+std::mutex PerfCounters::s_mutex;
+std::array<PerfCounters::Totals, PerfCounters::kNumStages> PerfCounters::s_totals;
+
+namespace {
+/// Counters of one thread, opened on first use and closed when the thread exits
+class ThreadCounters {
+public:
+  ThreadCounters() {
+    m_fds.fill(-1);
+#ifdef __linux__
+    const std::array<std::pair<uint32_t, uint64_t>, PerfCounters::kNumCounters> events = {
+        {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}}};
+    for (unsigned int c = 0; c < events.size(); ++c) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = events[c].first;
+      attr.config = events[c].second;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // the kernel may multiplex the counters, the enabled and running times allow the counts to be scaled
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      // this thread, any cpu
+      m_fds[c] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+  }
+  ~ThreadCounters() {
+#ifdef __linux__
+    for (int fd : m_fds)
+      if (fd >= 0) close(fd);
+#endif
+  }
+  bool has(unsigned int counter) const { return m_fds[counter] >= 0; }
+  double read(unsigned int counter) const {
+#ifdef __linux__
+    uint64_t values[3];  // value, time enabled, time running
+    if (m_fds[counter] >= 0 && ::read(m_fds[counter], values, sizeof(values)) == sizeof(values)) {
+      if (values[2] == 0) return 0;
+      return (values[2] < values[1]) ? double(values[0]) * values[1] / values[2] : double(values[0]);
+    }
+#endif
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+private:
+  std::array<int, PerfCounters::kNumCounters> m_fds;  ///< file descriptors, -1 if the counter is unavailable
+};
+
+ThreadCounters& threadCounters() {
+  thread_local ThreadCounters counters;
+  return counters;
+}
+}
+
+PerfCounters::Scope::Scope(Stage stage) : m_stage(stage), m_on(isOn()), m_objects(0) {
+  if (!m_on) return;
+  m_counts = read();
+  m_start = std::chrono::steady_clock::now();
+}
+
+PerfCounters::Scope::~Scope() {
+  if (!m_on) return;
+  auto end = std::chrono::steady_clock::now();
+  auto counts = read();
+  std::lock_guard<std::mutex> guard(s_mutex);
+  Totals& totals = s_totals[m_stage];
+  totals.calls++;
+  totals.objects += m_objects;
+  totals.seconds += std::chrono::duration<double>(end - m_start).count();
+  for (unsigned int c = 0; c < kNumCounters; ++c)
+    totals.counts[c] += counts[c] - m_counts[c];  // stays NaN for an unavailable counter
+}
+
+void PerfCounters::start() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_totals.fill(Totals());
+  threadCounters();  // opens the counters of the calling thread
+  s_on = true;
+}
+
+bool PerfCounters::hasCounter(Counter counter) { return threadCounters().has(counter); }
+
+PerfCounters::Totals PerfCounters::totals(Stage stage) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  return s_totals[stage];
+}
+
+std::array<double, PerfCounters::kNumCounters> PerfCounters::read() {
+  const ThreadCounters& counters = threadCounters();
+  std::array<double, kNumCounters> values;
+  for (unsigned int c = 0; c < kNumCounters; ++c)
+    values[c] = counters.read(c);
+  return values;
+}
+
+const char* PerfCounters::stageName(Stage stage) {
+  static const char* names[] = {"simulate", "merge clusters", "build blocks", "simplify blocks", "reconstruct"};
+  return (stage < kNumStages) ? names[stage] : "unknown";
+}
+
+const char* PerfCounters::counterName(Counter counter) {
+  static const char* names[] = {"cycles", "instructions", "LLC misses", "branch misses"};
+  return (counter < kNumCounters) ? names[counter] : "unknown";
+}
+
+std::string PerfCounters::report() {
+  std::string text;
+  std::string missing;
+  for (unsigned int c = 0; c < kNumCounters; ++c) {
+    if (hasCounter(static_cast<Counter>(c))) continue;
+    if (!missing.empty()) missing += ", ";
+    missing += counterName(static_cast<Counter>(c));
+  }
+  if (!missing.empty()) text = "hardware counters unavailable (" + missing + "), shown as nan\n";
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-16s %8s %12s %10s %10s %6s %14s %13s %13s\n", "stage", "calls", "objects",
+                "ms", "us/object", "IPC", "cycles/object", "LLC miss/obj", "br miss/obj");
+  text += line;
+  std::lock_guard<std::mutex> guard(s_mutex);
+  for (unsigned int s = 0; s < kNumStages; ++s) {
+    const Totals& t = s_totals[s];
+    double objects = t.objects ? double(t.objects) : std::numeric_limits<double>::quiet_NaN();
+    std::snprintf(line, sizeof(line), "%-16s %8llu %12llu %10.3f %10.4f %6.2f %14.1f %13.3f %13.3f\n",
+                  stageName(static_cast<Stage>(s)), (unsigned long long)t.calls, (unsigned long long)t.objects,
+                  t.seconds * 1e3, t.seconds * 1e6 / objects, t.counts[kInstructions] / t.counts[kCycles],
+                  t.counts[kCycles] / objects, t.counts[kCacheMisses] / objects, t.counts[kBranchMisses] / objects);
+    text += line;
+  }
+  return text;
+}
+
+}  // end namespace papas
@@ -0,0 +1,122 @@
+#include "papas/utility/ProcessPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace papas {
+
+namespace {
+
+/// runs the events of one worker, writing their summaries into slots
+void runWorker(unsigned int worker, unsigned int firstEvent, unsigned int nEvents,
+               ProcessPool::EventSummary* summaries, const ProcessPool::Process& process,
+               const ProcessPool::WorkerHook& workerStart, const ProcessPool::WorkerHook& workerEnd, bool forked) {
+  // a forked worker must not write into the CSV file of the parent, which ends its events later
+  if (forked && Metrics::isOn()) Metrics::start();
+  if (workerStart) workerStart(worker);
+  for (unsigned int i = 0; i < nEvents; ++i) {
+    auto& summary = summaries[i];
+    summary.eventNo = firstEvent + i;
+    summary.worker = worker;
+    auto start = std::chrono::steady_clock::now();
+    summary.reconstructed = process(summary.eventNo);
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (unsigned int c = 0; c < Metrics::kNumCounters; ++c)
+      summary.counters[c] = Metrics::value(static_cast<Metrics::Counter>(c));
+    if (Metrics::isOn()) Metrics::endEvent(summary.eventNo, summary.seconds);
+    summary.done = 1;
+  }
+  if (workerEnd) workerEnd(worker);
+}
+
+}  // end anonymous namespace
+
+std::vector<ProcessPool::EventSummary> ProcessPool::run(unsigned int nWorkers, unsigned int firstEvent,
+                                                         unsigned int nEvents, const Process& process,
+                                                         const WorkerHook& workerStart, const WorkerHook& workerEnd) {
+  if (nWorkers <= 1 || nEvents <= 1) {
+    std::vector<EventSummary> summaries(nEvents);
+    runWorker(0, firstEvent, nEvents, summaries.data(), process, workerStart, workerEnd, false);
+    return summaries;
+  }
+  if (nWorkers > nEvents) nWorkers = nEvents;
+  std::size_t bytes = nEvents * sizeof(EventSummary);
+  void* shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) throw std::runtime_error("ProcessPool: could not map shared memory");
+  auto* slots = static_cast<EventSummary*>(shared);
+  std::fill(slots, slots + nEvents, EventSummary());
+  // anything still buffered would otherwise be written by every worker
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  std::vector<pid_t> pids;
+  for (unsigned int w = 0; w < nWorkers; ++w) {
+    // worker w gets events [begin, end) of the range
+    unsigned int begin = (uint64_t)nEvents * w / nWorkers;
+    unsigned int end = (uint64_t)nEvents * (w + 1) / nWorkers;
+    pid_t pid = fork();
+    if (pid == 0) {
+      int status = 0;
+      try {
+        runWorker(w, firstEvent + begin, end - begin, slots + begin, process, workerStart, workerEnd, true);
+      } catch (const char* err) {
+        std::cerr << "ProcessPool worker " << w << ": " << err << std::endl;
+        status = 1;
+      } catch (const std::string& err) {
+        std::cerr << "ProcessPool worker " << w << ": " << err << std::endl;
+        status = 1;
+      } catch (const std::exception& err) {
+        std::cerr << "ProcessPool worker " << w << ": " << err.what() << std::endl;
+        status = 1;
+      }
+      std::cout.flush();
+      std::cerr.flush();
+      std::fflush(nullptr);
+      _exit(status);
+    }
+    if (pid < 0) break;  // the workers already started are waited for below
+    pids.push_back(pid);
+  }
+  bool ok = pids.size() == nWorkers;
+  for (auto pid : pids) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+  }
+  std::vector<EventSummary> summaries(slots, slots + nEvents);
+  munmap(shared, bytes);
+  if (!ok) throw std::runtime_error("ProcessPool: a worker failed");
+  if (Metrics::isOn()) {
+    for (const auto& summary : summaries) {
+      for (unsigned int c = 0; c < Metrics::kNumCounters; ++c)
+        Metrics::add(static_cast<Metrics::Counter>(c), summary.counters[c]);
+      Metrics::endEvent(summary.eventNo, summary.seconds);
+    }
+  }
+  return summaries;
+}
+
+std::string ProcessPool::workerFileName(const std::string& fname, unsigned int worker) {
+  return fname + "." + std::to_string(worker);
+}
+
+void ProcessPool::mergeFiles(const std::string& fname, unsigned int nWorkers) {
+  std::ofstream out(fname, std::ios::binary);
+  if (!out) throw std::runtime_error("ProcessPool: could not open " + fname);
+  for (unsigned int w = 0; w < nWorkers; ++w) {
+    auto workerFile = workerFileName(fname, w);
+    std::ifstream in(workerFile, std::ios::binary);
+    if (!in) continue;
+    if (in.peek() != std::ifstream::traits_type::eof()) out << in.rdbuf();
+    in.close();
+    std::remove(workerFile.c_str());
+  }
+}
+
+}  // end namespace papas
@@ -0,0 +1,109 @@
+#include "papas/utility/Timeline.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace papas {
+
+std::atomic<bool> Timeline::s_on(false);
+std::atomic<int64_t> Timeline::s_epoch(Timeline::steadyNanoseconds());
+std::atomic<uint64_t> Timeline::s_generation(0);
+std::size_t Timeline::s_capacity = 1 << 16;
+std::mutex Timeline::s_mutex;
+std::vector<std::unique_ptr<Timeline::ThreadBuffer>> Timeline::s_buffers;
+std::vector<std::unique_ptr<Timeline::ThreadBuffer>> Timeline::s_retired;
+
+namespace {
+thread_local const char* t_threadName = nullptr;  ///< kept by the thread when the timeline is restarted
+}
+
+void Timeline::start(std::size_t spansPerThread) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  s_capacity = 1;
+  while (s_capacity < spansPerThread)
+    s_capacity <<= 1;
+  // another thread may still be writing into its old buffer (eg a span that was open), so it is not deleted but
+  // put back in the pool for the threads of the new timeline
+  for (auto& buffer : s_buffers)
+    s_retired.push_back(std::move(buffer));
+  s_buffers.clear();
+  s_epoch = steadyNanoseconds();  // before the generation so that a span of the new generation sees the new epoch
+  s_generation++;                 // threads will take new buffers on their next span
+  s_on = true;
+}
+
+Timeline::ThreadBuffer& Timeline::threadBuffer() {
+  // an old buffer may have been reused by another thread, so it is only used while the generation matches
+  thread_local ThreadBuffer* buffer = nullptr;
+  thread_local uint64_t generation = 0;
+  if (buffer == nullptr || generation != s_generation) {
+    std::lock_guard<std::mutex> guard(s_mutex);
+    auto retired = std::find_if(s_retired.begin(), s_retired.end(),
+                                [](const std::unique_ptr<ThreadBuffer>& b) { return b->records.size() == s_capacity; });
+    if (retired != s_retired.end()) {
+      s_buffers.push_back(std::move(*retired));
+      s_retired.erase(retired);
+    } else
+      s_buffers.emplace_back(new ThreadBuffer(s_capacity));
+    buffer = s_buffers.back().get();
+    buffer->head.store(0, std::memory_order_relaxed);
+    buffer->generation = s_generation;
+    buffer->tid = s_buffers.size();
+    buffer->name = t_threadName;
+    generation = buffer->generation;
+  }
+  return *buffer;
+}
+
+void Timeline::setThreadName(const char* name) {
+  t_threadName = name;
+  threadBuffer().name = name;
+}
+
+void Timeline::record(const char* name, const char* category, int64_t start, int64_t end, int64_t arg,
+                      uint64_t generation) {
+  auto& buffer = threadBuffer();
+  if (buffer.generation != generation) return;  // the span started before a restart, its start time is meaningless
+  auto head = buffer.head.load(std::memory_order_relaxed);
+  buffer.records[head & (buffer.records.size() - 1)] = Record{name, category, start, end, arg};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::size_t Timeline::size() {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  std::size_t total = 0;
+  for (const auto& buffer : s_buffers)
+    total += std::min<uint64_t>(buffer->head.load(std::memory_order_acquire), buffer->records.size());
+  return total;
+}
+
+void Timeline::write(const std::string& fname) {
+  std::lock_guard<std::mutex> guard(s_mutex);
+  FILE* file = std::fopen(fname.c_str(), "w");
+  if (file == nullptr) throw std::string("Timeline: unable to open " + fname);
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  for (const auto& buffer : s_buffers) {
+    if (buffer->name != nullptr) {
+      std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                   first ? "" : ",\n", buffer->tid, buffer->name);
+      first = false;
+    }
+    // the oldest spans are lost if the buffer has wrapped around
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t size = buffer->records.size();
+    for (uint64_t i = (head > size) ? head - size : 0; i < head; ++i) {
+      const auto& r = buffer->records[i & (size - 1)];
+      // complete ("X") events, times are in microseconds
+      std::fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                   first ? "" : ",\n", r.name, r.category, r.start * 1e-3, (r.end - r.start) * 1e-3, buffer->tid);
+      if (r.arg >= 0) std::fprintf(file, ",\"args\":{\"n\":%lld}", static_cast<long long>(r.arg));
+      std::fprintf(file, "}");
+      first = false;
+    }
+  }
+  std::fprintf(file, "\n]}\n");
+  if (std::fclose(file) != 0) throw std::string("Timeline: unable to write " + fname);
+}
+
+}  // end namespace papas
@@ -3,10 +3,14 @@
 #include "tests/catch.hpp"
 
 // C++
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <numeric>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -18,22 +22,35 @@
 #include "papas/datatypes/Event.h"
 #include "papas/datatypes/Helix.h"
 #include "papas/datatypes/HistoryHelper.h"
+#include "papas/datatypes/IdBitset.h"
 #include "papas/detectors/CMS.h"
 #include "papas/detectors/CMSField.h"
 #include "papas/detectors/Calorimeter.h"
 #include "papas/display/Display.h"
 #include "papas/display/GTrajectory.h"
 #include "papas/display/ViewPane.h"
+#include "papas/graphtools/BuildSubGraphs.h"
+#include "papas/graphtools/ConnectedComponents.h"
 #include "papas/graphtools/Distance.h"
+#include "papas/graphtools/EdgeStore.h"
 #include "papas/graphtools/EventRuler.h"
 #include "papas/reconstruction/BuildPFBlocks.h"
+#include "papas/reconstruction/MergeAndBuildBlocks.h"
 #include "papas/reconstruction/MergeClusters.h"
 #include "papas/reconstruction/PapasManagerTester.h"
 #include "papas/reconstruction/SimplifyPFBlocks.h"
 #include "papas/simulation/HelixPropagator.h"
+#include "papas/simulation/ParticleGun.h"
+#include "papas/simulation/PileupMixer.h"
 #include "papas/simulation/Simulator.h"
 #include "papas/simulation/StraightLinePropagator.h"
+#include "papas/utility/AllocTracker.h"
+#include "papas/utility/Metrics.h"
+#include "papas/utility/PTraceReader.h"
+#include "papas/utility/PerfCounters.h"
+#include "papas/utility/ProcessPool.h"
 #include "papas/utility/TRandom.h"
+#include "papas/utility/Timeline.h"
 
 using namespace papas;
 
@@ -56,6 +73,10 @@ TEST_CASE("IdCoder") {
   auto id = IdCoder::makeId(1, IdCoder::ItemType::kEcalCluster, 'g', 3.1);
   REQUIRE(IdCoder::subtype(id) == 'g');
   REQUIRE(IdCoder::type('e') == IdCoder::kEcalCluster);
+  REQUIRE(IdCoder::typeAndSubtypeKey(id) == IdCoder::typeAndSubtypeKey(IdCoder::kEcalCluster, 'g'));
+  REQUIRE(IdCoder::typeAndSubtypeKey(id) != IdCoder::typeAndSubtypeKey(IdCoder::kHcalCluster, 'g'));
+  REQUIRE(IdCoder::typeAndSubtypeKey(IdCoder::kBlock, 'z') < IdCoder::kTypeAndSubtypeKeys);
+  REQUIRE_THROWS(IdCoder::type('x'));
 
   for (int j = 0; j < 6; j++) {
     IdCoder::ItemType e = IdCoder::ItemType::kEcalCluster;
@@ -65,6 +86,42 @@ TEST_CASE("IdCoder") {
       id = IdCoder::makeId(i, e, 't', (float)(1. / n));
     }
   }
+
+  // largest index allowed by the identifier layout, and edge keys of ids that differ only in the high index bits
+  uint32_t maxIndex = (1u << PAPAS_ID_INDEX_BITS) - 2;
+  auto big = IdCoder::makeId(maxIndex, IdCoder::kEcalCluster, 's', 7.5);
+  REQUIRE(IdCoder::index(big) == maxIndex);
+  REQUIRE(IdCoder::type(big) == IdCoder::kEcalCluster);
+  REQUIRE(IdCoder::subtype(big) == 's');
+  REQUIRE(IdCoder::value(big) == 7.5);
+  REQUIRE_THROWS(IdCoder::makeId(maxIndex + 1, IdCoder::kEcalCluster, 's', 7.5));
+  auto low = IdCoder::makeId(maxIndex & 0xFFFF, IdCoder::kEcalCluster, 's', 7.5);
+  auto track = IdCoder::makeId(1, IdCoder::kTrack, 's', 2.);
+  REQUIRE(Edge::makeKey(big, track) != Edge::makeKey(low, track));
+  REQUIRE(Edge::makeKey(big, track) == Edge::makeKey(track, big));
+  REQUIRE(Edge::keyEnd(Edge::makeKey(big, track), 0) == IdCoder::uniqueId(track));
+  REQUIRE(IdCoder::makeId(1, IdCoder::kEcalCluster, 's', 7.5) > IdCoder::makeId(2, IdCoder::kEcalCluster, 's', 7.4));
+}
+
+TEST_CASE("IdBitset") {
+  IdBitset bits;
+  auto id1 = IdCoder::makeId(3, IdCoder::kEcalCluster, 'm', 1.5);
+  auto id2 = IdCoder::makeId(3, IdCoder::kEcalCluster, 's', 1.5);  // same index, different subtype
+  auto id3 = IdCoder::makeId(1000, IdCoder::kTrack, 's', 2.5);
+  REQUIRE(bits.empty());
+  REQUIRE(bits.test(id1) == false);
+  bits.set(id1);
+  bits.set(id3);
+  REQUIRE(bits.test(id1));
+  REQUIRE(bits.test(id2) == false);
+  REQUIRE(bits.test(id3));
+  REQUIRE(bits.count() == 2);
+  bits.reset(id1);
+  REQUIRE(bits.test(id1) == false);
+  REQUIRE(bits.count() == 1);
+  bits.clear();
+  REQUIRE(bits.empty());
+  REQUIRE(bits.test(id3) == false);
 }
 
 TEST_CASE("Helix") {  /// Helix path test
@@ -257,6 +314,43 @@ TEST_CASE("StraightLine") {
   REQUIRE(points[papas::Position::kEcalIn].Z() == Approx(1.));
 }
 
+TEST_CASE("LazyPathPoints") {
+  std::shared_ptr<const Field> field = std::make_shared<Field>(CMSField(VolumeCylinder(Layer::kField, 2.9, 3.6), 3.8));
+  StraightLinePropagator propStraight(field);
+  HelixPropagator propHelix(field);
+  SurfaceCylinder cyl1(papas::Position::kEcalIn, 1, 2);
+  SurfaceCylinder cyl2(papas::Position::kHcalIn, 2, 3);
+
+  // lazy points are the same as the ones propagated to straight away
+  Particle eager(211, -1, TLorentzVector{2., 0, 1, 5}, 1, 'r', TVector3{0, 0, 0}, 3.8);
+  Particle lazy(211, -1, TLorentzVector{2., 0, 1, 5}, 2, 'r', TVector3{0, 0, 0}, 3.8);
+  propHelix.setPath(eager);
+  propHelix.setPath(lazy);
+  propHelix.propagateOne(eager, cyl1);
+  propHelix.propagateOne(eager, cyl2);
+  lazy.path()->addLazyPoint(cyl1);
+  lazy.path()->addLazyPoint(cyl2);
+  REQUIRE(lazy.path()->namedPoint(papas::Position::kEcalIn) == eager.path()->namedPoint(papas::Position::kEcalIn));
+  REQUIRE(lazy.path()->points() == eager.path()->points());
+
+  // the point is computed when it is asked for, not when it is added
+  Particle photon(22, 0, TLorentzVector{1, 0, 1, 2.}, 3, 't');
+  propStraight.setPath(photon);
+  photon.path()->addLazyPoint(cyl1);
+  cyl1 = SurfaceCylinder(papas::Position::kEcalIn, 0.5, 2);
+  REQUIRE(photon.path()->namedPoint(papas::Position::kEcalIn).Perp() == Approx(0.5));
+
+  // a cylinder that is not crossed gives no point, an explicit point replaces a lazy one
+  Particle outside(22, 0, TLorentzVector{1, 0, 1, 2.}, 4, 's', {0, 0, 2.5}, 0.);
+  propStraight.setPath(outside);
+  outside.path()->addLazyPoint(cyl1);
+  outside.path()->addLazyPoint(cyl2);
+  outside.path()->addPoint(papas::Position::kHcalIn, TVector3(1, 2, 3));
+  REQUIRE(!outside.path()->hasNamedPoint(papas::Position::kEcalIn));
+  REQUIRE(outside.path()->namedPoint(papas::Position::kHcalIn) == TVector3(1, 2, 3));
+  REQUIRE(outside.path()->points().size() == 2UL);
+}
+
 TEST_CASE("TRandomExp") {
   // seed it to have known start point
   rootrandom::Random::seed(100);
@@ -373,7 +467,15 @@ TEST_CASE("Edges") {
   REQUIRE(edge.isLinked() == false);
   // NB ids are ordered when stored so may be the opposite way around to the constructor
   REQUIRE(edge.otherId(id1) == id2);
-  return;
+
+  // keys are only used through the Edge API, as their layout depends on the identifier index width
+  Identifier big = IdCoder::makeId((1u << IdCoder::bitshift()) - 2, IdCoder::kTrack, 's', 7.5);
+  EdgeKey key = Edge::makeKey(big, id1);
+  REQUIRE(key == Edge::makeKey(id1, big));
+  REQUIRE(key != Edge::makeKey(id1, id3));
+  REQUIRE(Edge::keyEnd(key, 0) == IdCoder::uniqueId(big));
+  REQUIRE(Edge::keyEnd(key, 1) == IdCoder::uniqueId(id1));
+  REQUIRE(std::hash<EdgeKey>()(key) == std::hash<EdgeKey>()(Edge::makeKey(id1, big)));
 }
 
 TEST_CASE("PFBlocks") {
@@ -426,6 +528,174 @@ TEST_CASE("PFBlocks") {
   return;
 }
 
+TEST_CASE("EdgeStore") {
+  Identifier id1 = IdCoder::makeId(1, IdCoder::kEcalCluster, 't');
+  Identifier id2 = IdCoder::makeId(2, IdCoder::kHcalCluster, 't');
+  Identifier id3 = IdCoder::makeId(3, IdCoder::kTrack, 't');
+  Identifier id4 = IdCoder::makeId(4, IdCoder::kEcalCluster, 't');
+  Identifier id5 = IdCoder::makeId(5, IdCoder::kTrack, 't');
+  Ids ids{id1, id2, id3, id4, id5};
+
+  // only linked edges, and unlinked edges within 0.1, are kept
+  EdgeStore store(0.1);
+  REQUIRE(store.addEdge(id1, id3, true, 0.2) == true);
+  REQUIRE(store.addEdge(id2, id3, false, 0.05) == true);
+  REQUIRE(store.addEdge(id4, id3, false, 0.5) == false);
+  REQUIRE(store.addEdge(id5, id4, true, 0.01) == true);
+  REQUIRE(store.size() == 3);
+  REQUIRE(store.hasEdge(id3, id1));
+  REQUIRE(store.hasEdge(id3, id4) == false);
+  REQUIRE(store.edge(id3, id1).key() == Edge::makeKey(id1, id3));
+  REQUIRE(store.edge(id2, id3).isLinked() == false);
+  REQUIRE(store.edge(id4, id5).distance() == Approx(0.01));
+  REQUIRE(sizeof(EdgeStore::Link) == 12);
+  EdgeStore exact(-1., true);
+  exact.addEdge(id5, id4, true, 0.01);
+  exact.addEdge(id1, id3, true, 0.2);
+  REQUIRE(exact.edge(id4, id5).distance() == 0.01);
+  REQUIRE(exact.edge(id1, id3).distance() == 0.2);
+  REQUIRE_THROWS(store.edge(id1, id2));
+
+  // subgraphs must be the same as those made from the full set of edges
+  Edges edges;
+  for (const auto& link : store.links()) {
+    auto edge = store.edge(link);
+    edges.emplace(edge.key(), edge);
+  }
+  Edge unlinked(id4, id3, false, 0.5);
+  edges.emplace(unlinked.key(), unlinked);
+  auto subGraphs = buildSubGraphs(ids, store);
+  REQUIRE(subGraphs == buildSubGraphs(ids, edges));
+  REQUIRE(subGraphs.size() == 3);
+
+  auto shared = std::make_shared<EdgeStore>(std::move(store));
+  PFBlock block(Ids{id1, id2, id3}, shared, 0, 'r');
+  REQUIRE(block.edges().size() == 2);
+  REQUIRE(block.linkedIds(id3) == Ids{id1});
+
+  // a block that views the same store with one link removed
+  PFBlock view(Ids{id1, id2, id3}, shared, 1, 's', EdgeKeys{Edge::makeKey(id1, id3)});
+  REQUIRE(view.edgeStore() == block.edgeStore());
+  REQUIRE(view.edge(id1, id3).isLinked() == false);
+  REQUIRE(view.edge(Edge::makeKey(id3, id1)).isLinked() == false);
+  REQUIRE(view.numEdges() == 2);
+  REQUIRE_THROWS(view.edge(Edge::makeKey(id4, id5)));  // in the store but not in the block
+  std::size_t nLinked = 0;
+  view.visitEdges([&nLinked](const Edge& edge) { nLinked += edge.isLinked(); });
+  REQUIRE(nLinked == 0);
+  REQUIRE(view.linkedIds(id3).size() == 0);
+  REQUIRE(block.edge(id1, id3).isLinked() == true);
+}
+
+TEST_CASE("ConnectedComponents") {
+  REQUIRE(ConnectedComponents::labels(5, {{4, 2}, {3, 1}, {2, 0}}) == std::vector<uint32_t>({0, 1, 0, 1, 0}));
+  // a random sparse graph gives the same labels serially and split over threads
+  const uint32_t nNodes = 20000;
+  std::vector<ConnectedComponents::Link> links;
+  rootrandom::Random::seed(0xcc);
+  for (uint32_t i = 0; i < 15000; ++i) {
+    auto a = (uint32_t)rootrandom::Random::uniform(0, nNodes);
+    links.emplace_back(a, (uint32_t)rootrandom::Random::uniform(0, nNodes));
+  }
+  ConnectedComponents::setThreads(1);
+  auto serial = ConnectedComponents::labels(nNodes, links);
+  ConnectedComponents::setThreads(4);
+  auto minEdges = ConnectedComponents::minParallelEdges();
+  ConnectedComponents::setMinParallelEdges(0);
+  REQUIRE(ConnectedComponents::labels(nNodes, links) == serial);
+  bool smallestLinked = true;
+  for (const auto& link : links)
+    smallestLinked &= serial[link.first] == serial[link.second] && serial[link.first] <= link.first;
+  REQUIRE(smallestLinked);
+  ConnectedComponents::setMinParallelEdges(minEdges);
+  ConnectedComponents::setThreads(0);
+}
+
+TEST_CASE("PTrace") {
+  // a binary trace renders as the text that PDebug::File would have written
+  Cluster cluster(10., TVector3(1, 0, 1), 0.04, 1, IdCoder::kEcalCluster, 't');
+  Track track(TVector3(2, 1, 0.5), 1, std::make_shared<Path>(), 2, 's');
+  Particle particle(211, 1, TLorentzVector(1, 2, 3, 5), 3, 'r');
+  Identifier id1 = IdCoder::makeId(1, IdCoder::kEcalCluster, 't');
+  Identifier id2 = IdCoder::makeId(2, IdCoder::kHcalCluster, 't');
+  Identifier id3 = IdCoder::makeId(3, IdCoder::kTrack, 't');
+  Edges edges;
+  Edge edge1(id1, id3, true, 0.0123);
+  Edge edge2(id2, id3, true, 0.0456);
+  edges.emplace(edge1.key(), std::move(edge1));
+  edges.emplace(edge2.key(), std::move(edge2));
+  PFBlock block(Ids{id1, id2, id3}, edges, 1, 'r');
+
+  const std::string fname = "ptrace_unittest.trace";
+  PTrace::open(fname);
+  PTrace::write("Event: {}", 7u);
+  PTrace::write("Made {}", cluster);
+  PTrace::write("Made Smeared{}", track);
+  PTrace::write("Made {}", block);
+  PTrace::write("Made {} from Smeared{}", particle, track);
+  PTrace::close();
+
+  std::vector<std::string> expected = {"Event: 7", fmt::format("Made {}", cluster),
+                                       fmt::format("Made Smeared{}", track), fmt::format("Made {}", block),
+                                       fmt::format("Made {} from Smeared{}", particle, track)};
+  std::vector<PTrace::RecordKind> kinds = {PTrace::kMessage, PTrace::kCreated, PTrace::kSmeared, PTrace::kBlockMade,
+                                           PTrace::kReconstructed};
+  PTraceReader reader(fname);
+  PTraceRecord record;
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    REQUIRE(reader.next(record));
+    REQUIRE(PTraceReader::render(record) == expected[i]);
+    REQUIRE(record.kind == kinds[i]);
+  }
+  REQUIRE(!reader.next(record));
+  std::ostringstream out;
+  REQUIRE(PTraceReader::diff(fname, fname, out) == 0);
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("Timeline") {
+  // spans are kept per thread, and only the most recent ones are kept when a buffer is full
+  Timeline::start(4);
+  auto work = [] {
+    for (int i = 0; i < 10; ++i)
+      Timeline::Span span("work", "test", i);
+  };
+  std::thread other(work);
+  work();
+  other.join();
+  REQUIRE(Timeline::size() == 8);
+  Timeline::stop();
+  { Timeline::Span span("ignored", "test"); }
+  REQUIRE(Timeline::size() == 8);
+  const std::string fname = "timeline_unittest.json";
+  Timeline::write(fname);
+  std::ifstream in(fname);
+  std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"n\":9}") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"n\":5}") == std::string::npos);
+  std::remove(fname.c_str());
+
+  // restarting while a span is open is safe, the span is dropped as it started in the old timeline, and the thread
+  // keeps its name
+  Timeline::start(4);
+  Timeline::setThreadName("main");
+  {
+    Timeline::Span open("open", "test");
+    Timeline::start(4);
+  }
+  { Timeline::Span span("after", "test"); }
+  REQUIRE(Timeline::size() == 1);
+  Timeline::stop();
+  Timeline::write(fname);
+  std::ifstream restarted(fname);
+  json.assign((std::istreambuf_iterator<char>(restarted)), std::istreambuf_iterator<char>());
+  REQUIRE(json.find("\"name\":\"main\"") != std::string::npos);
+  REQUIRE(json.find("\"name\":\"after\"") != std::string::npos);
+  REQUIRE(json.find("\"name\":\"open\"") == std::string::npos);
+  std::remove(fname.c_str());
+}
+
 TEST_CASE("BlockSplitter") {
   Identifier id1 = IdCoder::makeId(1, IdCoder::kHcalCluster, 't');
   Identifier id2 = IdCoder::makeId(2, IdCoder::kHcalCluster, 't');
@@ -576,6 +846,311 @@ TEST_CASE("test_papasevent") {
   REQUIRE_THROWS(event.track(500));
   REQUIRE(event.hasObject(499) == false);
   REQUIRE(event.hasObject(lastid) == true);
+  REQUIRE(event.hasCollection(IdCoder::kHcalCluster, 't') == false);
+  REQUIRE(event.clusters(IdCoder::kHcalCluster, 't').size() == 0);
+  REQUIRE(event.collectionIds(std::string("et")).size() == 2);
+  event.clear();
+  REQUIRE(event.hasCollection(lastid) == false);
+  REQUIRE(event.tracks('t').size() == 0);
+}
+
+TEST_CASE("ParticleGun") {
+  CMS cms;
+  ParticleGun gun1(cms, 7);
+  ParticleGun gun2(cms, 7);
+  Particles particles1;
+  Particles particles2;
+  gun1.makeParticles(50, particles1, 3);
+  gun2.makeParticles(50, particles2, 3);
+  REQUIRE(particles1.size() == 50);
+  // the same seed gives the same particles
+  for (const auto& p : particles1) {
+    REQUIRE(particles2.at(p.first).e() == p.second.e());
+    REQUIRE(p.second.path() != nullptr);
+  }
+  REQUIRE_THROWS(gun1.setEnergyRange(10., 1.));
+}
+
+TEST_CASE("ParticlesWithoutPath") {
+  // particles made without a path (eg by a bulk import) are given one when they are added to the event
+  CMS cms;
+  ParticleGun gun(cms, 11);
+  Particles withPaths;
+  gun.makeParticles(40, withPaths, 1);
+  Particles withoutPaths;
+  for (const auto& p : withPaths) {
+    const auto& ptc = p.second;
+    withoutPaths.emplace(p.first, Particle(ptc.pdgId(), ptc.charge(), ptc.p4(), IdCoder::index(p.first), 's',
+                                           ptc.startVertex(), ptc.status()));
+    REQUIRE(withoutPaths.at(p.first).path() == nullptr);
+  }
+  std::vector<double> energies;
+  for (auto* particles : {&withPaths, &withoutPaths}) {
+    rootrandom::Random::seed(0xdeadbeef);
+    PapasManager papasManager(cms);
+    papasManager.addParticles(*particles);
+    papasManager.simulate();
+    // the simulation adds its points to the paths of the particles in the event
+    for (const auto& p : papasManager.event().particles('s'))
+      REQUIRE(p.second.path()->hasNamedPoint(papas::Position::kEcalIn) ==
+              withPaths.at(p.first).path()->hasNamedPoint(papas::Position::kEcalIn));
+    double energy = 0;
+    for (const auto& c : papasManager.event().clusters("es"))
+      energy += c.second.energy();
+    for (const auto& t : papasManager.event().tracks('s'))
+      energy += t.second.energy();
+    energies.push_back(energy);
+  }
+  REQUIRE(energies[0] > 0);
+  REQUIRE(energies[0] == energies[1]);
+}
+
+TEST_CASE("BlockTopologies") {
+  CMS cms;
+  PapasManager papasManager(cms);
+  ParticleGun gun(cms, 3);
+  auto& particles = papasManager.createParticles();
+  gun.makeParticles(200, particles, 2);
+  papasManager.addParticles(particles);
+  papasManager.simulate();
+  papasManager.mergeClusters("es");
+  papasManager.mergeClusters("hs");
+  papasManager.buildBlocks();
+  papasManager.simplifyBlocks('r');
+  papasManager.reconstruct('s');
+  // every block is counted once, and its count matches its classification
+  PFReconstructor::TopologyCounts counts{};
+  for (const auto& b : papasManager.event().blocks('s')) {
+    counts[PFReconstructor::topology(b.second)]++;
+  }
+  REQUIRE(counts == papasManager.topologyCounts());
+  REQUIRE(std::accumulate(counts.begin(), counts.end(), 0u) == papasManager.event().blocks('s').size());
+  REQUIRE(std::string(PFReconstructor::topologyName(PFReconstructor::kH1T1)) == "H1T1");
+  papasManager.resetTopologyCounts();
+  REQUIRE(papasManager.topologyCounts()[PFReconstructor::kOther] == 0);
+}
+
+TEST_CASE("Metrics") {
+  CMS cms;
+  PapasManager papasManager(cms);
+  ParticleGun gun(cms, 5);
+  Metrics::start();
+  auto& particles = papasManager.createParticles();
+  gun.makeParticles(100, particles);
+  papasManager.addParticles(particles);
+  papasManager.simulate();
+  papasManager.mergeClusters("es");
+  papasManager.mergeClusters("hs");
+  papasManager.buildBlocks();
+  papasManager.simplifyBlocks('r');
+  papasManager.reconstruct('s');
+  REQUIRE(Metrics::value(Metrics::kBlocks) == papasManager.event().blocks('s').size());
+  REQUIRE(Metrics::value(Metrics::kParticlesReconstructed) == papasManager.event().particles('r').size());
+  REQUIRE(Metrics::value(Metrics::kDistanceEvaluations) > 0);
+  Metrics::endEvent(0, 0.01);
+  REQUIRE(Metrics::value(Metrics::kBlocks) == 0);
+  REQUIRE(Metrics::total(Metrics::kBlocks) == papasManager.event().blocks('s').size());
+  REQUIRE(Metrics::numEvents() == 1);
+  const std::string fname = "metrics_unittest.prom";
+  Metrics::writePrometheus(fname);
+  Metrics::stop();
+  Metrics::add(Metrics::kBlocks);  // ignored when stopped
+  REQUIRE(Metrics::value(Metrics::kBlocks) == 0);
+  std::ifstream in(fname);
+  std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  REQUIRE(text.find("papas_events_total 1\n") != std::string::npos);
+  REQUIRE(text.find("papas_block_size_bucket{le=\"+Inf\"}") != std::string::npos);
+  std::remove(fname.c_str());
+}
+
+TEST_CASE("ProcessPool") {
+  // each event adds to a counter and writes a line into the file of its worker
+  const std::string fname = "processpool_unittest.txt";
+  std::ofstream out;
+  auto process = [&out](unsigned int eventNo) {
+    Metrics::add(Metrics::kBlocks, eventNo);
+    out << eventNo << "\n";
+    return std::size_t(2 * eventNo);
+  };
+  auto workerStart = [&out, &fname](unsigned int worker) { out.open(ProcessPool::workerFileName(fname, worker)); };
+  auto workerEnd = [&out](unsigned int) { out.close(); };
+  Metrics::start();
+  auto summaries = ProcessPool::run(3, 10, 7, process, workerStart, workerEnd);
+  ProcessPool::mergeFiles(fname, 3);
+  REQUIRE(summaries.size() == 7);
+  bool ok = true;
+  for (unsigned int i = 0; i < 7; ++i) {
+    const auto& summary = summaries[i];
+    ok &= summary.done == 1 && summary.eventNo == 10 + i && summary.reconstructed == 2 * summary.eventNo;
+    ok &= summary.counters[Metrics::kBlocks] == summary.eventNo && summary.worker == (i < 2 ? 0 : (i < 4 ? 1 : 2));
+  }
+  REQUIRE(ok);
+  // the parent has the events of all the workers
+  REQUIRE(Metrics::numEvents() == 7);
+  REQUIRE(Metrics::total(Metrics::kBlocks) == 10 + 11 + 12 + 13 + 14 + 15 + 16);
+  Metrics::stop();
+  std::ifstream in(fname);
+  std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  REQUIRE(text == "10\n11\n12\n13\n14\n15\n16\n");
+  std::remove(fname.c_str());
+  // a worker that fails is reported
+  auto fail = [](unsigned int eventNo) -> std::size_t {
+    if (eventNo == 3) throw "bad event";
+    return 0;
+  };
+  REQUIRE_THROWS(ProcessPool::run(2, 0, 4, fail));
+}
+
+TEST_CASE("AllocTracker") {
+  AllocTracker::resetRun();
+  {
+    AllocTracker::Scope scope(AllocTracker::kMerge);
+    std::vector<std::unique_ptr<int>> ints;
+    for (int i = 0; i < 10; ++i)
+      ints.emplace_back(new int(i));
+  }
+  auto event = AllocTracker::endEvent();
+  REQUIRE(AllocTracker::numEvents() == 1);
+  if (AllocTracker::isEnabled()) {
+    REQUIRE(event[AllocTracker::kMerge].allocations >= 10);
+    REQUIRE(event[AllocTracker::kMerge].bytes >= 10 * sizeof(int));
+    REQUIRE(event[AllocTracker::kMerge].deallocations >= 10);
+    REQUIRE(event[AllocTracker::kSimulate].allocations == 0);
+    AllocTracker::resetPeak();
+    auto live = AllocTracker::liveBytes();
+    {
+      std::vector<char> buffer(1 << 20);
+      REQUIRE(AllocTracker::liveBytes() >= live + (1 << 20));
+    }
+    REQUIRE(AllocTracker::peakBytes() >= live + (1 << 20));
+    REQUIRE(AllocTracker::liveBytes() < live + (1 << 20));
+  } else {
+    REQUIRE(event[AllocTracker::kMerge].allocations == 0);
+  }
+  REQUIRE(AllocTracker::runTotals()[AllocTracker::kMerge].allocations == event[AllocTracker::kMerge].allocations);
+  REQUIRE(std::string(AllocTracker::stageName(AllocTracker::kBlockBuild)) == "build blocks");
+}
+
+TEST_CASE("PerfCounters") {
+  CMS cms;
+  PapasManager papasManager(cms);
+  ParticleGun gun(cms, 7);
+  auto& particles = papasManager.createParticles();
+  gun.makeParticles(50, particles);
+  papasManager.addParticles(particles);
+  PerfCounters::start();
+  papasManager.simulate();
+  papasManager.mergeClusters("es");
+  papasManager.mergeClusters("hs");
+  PerfCounters::stop();
+  papasManager.buildBlocks();  // not sampled
+  REQUIRE(PerfCounters::totals(PerfCounters::kSimulate).calls == 1);
+  REQUIRE(PerfCounters::totals(PerfCounters::kSimulate).objects == 50);
+  REQUIRE(PerfCounters::totals(PerfCounters::kMerge).calls == 2);
+  REQUIRE(PerfCounters::totals(PerfCounters::kMerge).objects > 0);
+  REQUIRE(PerfCounters::totals(PerfCounters::kBlockBuild).calls == 0);
+  if (PerfCounters::hasCounter(PerfCounters::kInstructions))
+    REQUIRE(PerfCounters::totals(PerfCounters::kSimulate).counts[PerfCounters::kInstructions] > 0);
+  REQUIRE(PerfCounters::report().find("merge clusters") != std::string::npos);
+}
+
+TEST_CASE("PileupMixer") {
+  CMS cms;
+  PileupMixer mixer(cms, 5, 3);
+  Particles empty;
+  REQUIRE_THROWS(mixer.mix(empty));  // no pool
+  REQUIRE_THROWS(PileupMixer(cms, -1));
+  REQUIRE_THROWS(mixer.setMeanPileup(-0.5));
+  ParticleGun minbias(cms, 4);
+  minbias.setEnergyRange(0.5, 3);
+  mixer.fillPool(minbias, 10, 8);
+  REQUIRE(mixer.poolSize() == 10);
+  mixer.setFluctuate(false);
+  PapasManager papasManager(cms);
+  ParticleGun gun(cms, 5);
+  auto& particles = papasManager.createParticles();
+  gun.makeParticles(20, particles);
+  REQUIRE(mixer.mix(particles) == 5);
+  REQUIRE(particles.size() == 20 + 5 * 8);
+  unsigned int displaced = 0;
+  for (const auto& p : particles) {
+    REQUIRE(p.second.path() != nullptr);
+    if (p.second.startVertex().Z() != 0) displaced++;
+  }
+  REQUIRE(displaced == 5 * 8);
+  Particles signal;
+  mixer.setMeanPileup(0);
+  REQUIRE(mixer.mix(signal) == 0);
+  mixer.setFluctuate(true);
+  REQUIRE(mixer.mix(signal) == 0);
+  REQUIRE(signal.empty());
+  papasManager.addParticles(particles);
+  papasManager.simulate();
+  papasManager.mergeClusters("es");
+  papasManager.mergeClusters("hs");
+  papasManager.buildBlocks();
+  papasManager.simplifyBlocks('r');
+  papasManager.reconstruct('s');
+  REQUIRE(papasManager.event().particles('r').size() > 0);
+}
+
+TEST_CASE("BFSTraverser") {
+  // 1 -> 2 -> 3, 1 -> 4 and 5 -> 3
+  Nodes nodes;
+  for (Identifier i = 1; i < 6; ++i)
+    nodes.emplace(i, PFNode(i));
+  nodes[1].addChild(nodes[2]);
+  nodes[2].addChild(nodes[3]);
+  nodes[1].addChild(nodes[4]);
+  nodes[5].addChild(nodes[3]);
+  DAG::BFSTraverser<PFNode> bfs;
+  DAG::BFSVisitor<PFNode> visitor;
+  std::vector<const PFNode*> reached;
+  auto collect = [&reached](const PFNode* node) {
+    reached.push_back(node);
+    return true;
+  };
+  // same nodes in the same order as the BFSVisitor
+  for (auto visittype : {DAG::enumVisitType::CHILDREN, DAG::enumVisitType::PARENTS, DAG::enumVisitType::UNDIRECTED}) {
+    for (int depth : {-1, 0, 1}) {
+      reached.clear();
+      REQUIRE(bfs.traverse(nodes[2], visittype, collect, depth));
+      REQUIRE(reached == visitor.traverseNodes(nodes[2], visittype, depth));
+    }
+  }
+  // a second visit without a reset only reaches what was not yet reached
+  reached.clear();
+  bfs.traverse(nodes[1], DAG::enumVisitType::CHILDREN, collect);
+  REQUIRE(reached.size() == 4);
+  REQUIRE(bfs.visited(&nodes[3]));
+  REQUIRE(!bfs.visited(&nodes[5]));
+  reached.clear();
+  bfs.visit(nodes[5], DAG::enumVisitType::UNDIRECTED, collect);
+  REQUIRE(reached.size() == 1);
+  // the callback can stop the traversal
+  reached.clear();
+  REQUIRE(!bfs.traverse(nodes[1], DAG::enumVisitType::UNDIRECTED, [&reached](const PFNode* node) {
+    reached.push_back(node);
+    return reached.size() < 2;
+  }));
+  REQUIRE(reached.size() == 2);
+  // traversers keep their marks to themselves, so they do not disturb each other
+  DAG::BFSTraverser<PFNode> other;
+  bfs.traverse(nodes[1], DAG::enumVisitType::CHILDREN, [](const PFNode*) { return true; });
+  reached.clear();
+  REQUIRE(other.traverse(nodes[5], DAG::enumVisitType::UNDIRECTED, collect));
+  REQUIRE(reached.size() == 5);
+  REQUIRE(!bfs.visited(&nodes[5]));
+  // a chain longer than the initial table of marks
+  Nodes chain;
+  for (Identifier i = 0; i < 1000; ++i)
+    chain.emplace(i, PFNode(i));
+  for (Identifier i = 1; i < 1000; ++i)
+    chain[i - 1].addChild(chain[i]);
+  std::size_t n = 0;
+  other.traverse(chain[0], DAG::enumVisitType::CHILDREN, [&n](const PFNode*) { return ++n > 0; });
+  REQUIRE(n == 1000);
+  REQUIRE(other.visited(&chain[999]));
 }
 
 TEST_CASE("test_history") {
@@ -615,6 +1190,215 @@ TEST_CASE("test_history") {
   fids = hhelper.filteredIds(ids, IdCoder::kParticle, 'r');
   REQUIRE(fids.size() == 1);
   REQUIRE(*fids.begin() == lastid);
+  REQUIRE(hhelper.linkedIds(lastid, "et") == Ids{lastcluster});
+  // searches can stop early
+  int nvisited = 0;
+  REQUIRE(!hhelper.visitLinkedIds(lastid, DAG::enumVisitType::CHILDREN, [&nvisited](Identifier) {
+    ++nvisited;
+    return false;
+  }));
+  REQUIRE(nvisited == 1);
+}
+
+TEST_CASE("HistoryLevel") {
+  // for each reconstructed particle, the simulated particles it comes from through its own tracks and clusters
+  auto provenance = [](HistoryLevel level, std::size_t& nHistory, std::size_t& nBlocks, std::multiset<int>& pdgIds) {
+    setHistoryLevel(level);
+    rootrandom::Random::seed(0xfeed);
+    CMS cms;
+    PapasManager papasManager(cms);
+    ParticleGun gun(cms, 11);
+    auto& particles = papasManager.createParticles();
+    gun.makeParticles(100, particles, 2);
+    papasManager.addParticles(particles);
+    papasManager.simulate();
+    papasManager.mergeClusters("es");
+    papasManager.mergeClusters("hs");
+    papasManager.buildBlocks();
+    papasManager.simplifyBlocks('r');
+    papasManager.reconstruct('s');
+    const auto& history = papasManager.event().history();
+    nHistory = history.size();
+    nBlocks = 0;
+    for (const auto& node : history)
+      nBlocks += IdCoder::isBlock(node.first);
+    std::map<Identifier, Ids> simParents;
+    HistoryHelper hhelper(papasManager.event());
+    for (const auto& p : papasManager.event().particles('r')) {
+      pdgIds.insert(p.second.pdgId());
+      auto& parents = simParents[p.first];
+      auto node = history.find(p.first);
+      if (node == history.end()) continue;
+      for (const auto* element : node->second.parents()) {
+        if (IdCoder::isBlock(element->value())) continue;  // the block also holds other particles' elements
+        auto ids = hhelper.linkedIds(element->value(), "ps", DAG::enumVisitType::PARENTS);
+        parents.insert(ids.begin(), ids.end());
+      }
+    }
+    return simParents;
+  };
+  std::size_t nFull, nTruth, nNone, nFullBlocks, nTruthBlocks, nNoneBlocks;
+  std::multiset<int> fullPdgIds, truthPdgIds, nonePdgIds;
+  auto full = provenance(HistoryLevel::kFull, nFull, nFullBlocks, fullPdgIds);
+  auto truth = provenance(HistoryLevel::kTruth, nTruth, nTruthBlocks, truthPdgIds);
+  auto none = provenance(HistoryLevel::kNone, nNone, nNoneBlocks, nonePdgIds);
+  setHistoryLevel(HistoryLevel::kFull);
+  REQUIRE(full.size() > 0);
+  REQUIRE(truth == full);
+  REQUIRE(none.size() == full.size());
+  REQUIRE(nFullBlocks > 0);
+  REQUIRE(nTruthBlocks == 0);
+  REQUIRE(nTruth < nFull);
+  REQUIRE(nNone > 0);  // the track truth links
+  REQUIRE(nNone < nTruth);
+  // muons and electrons are identified from the track truth links at every level
+  REQUIRE(fullPdgIds.count(11) + fullPdgIds.count(-11) + fullPdgIds.count(13) + fullPdgIds.count(-13) > 0);
+  REQUIRE(truthPdgIds == fullPdgIds);
+  REQUIRE(nonePdgIds == fullPdgIds);
+}
+
+TEST_CASE("PrunedRetention") {
+  // the reconstructed particles (energy by id) with each retention, and the collections left at the end
+  auto reconstruct = [](PapasManager::Retention retention, std::vector<std::string>& left) {
+    rootrandom::Random::seed(0xbeef);
+    CMS cms;
+    PapasManager papasManager(cms);
+    papasManager.setRetention(retention);
+    ParticleGun gun(cms, 11);
+    auto& particles = papasManager.createParticles();
+    gun.makeParticles(50, particles, 2);
+    papasManager.addParticles(particles);
+    papasManager.simulate();
+    REQUIRE(papasManager.event().hasCollection(IdCoder::kEcalCluster, 's'));
+    REQUIRE(papasManager.event().hasCollection(IdCoder::kEcalCluster, 't') ==
+            (retention == PapasManager::Retention::kKeepAll));
+    papasManager.mergeClusters("es");
+    papasManager.mergeClusters("hs");
+    papasManager.buildBlocks();
+    papasManager.simplifyBlocks('r');
+    papasManager.reconstruct('s');
+    for (auto name : {"et", "ht", "tt", "es", "hs", "ts", "em", "hm", "br", "bs", "ps", "pr"})
+      if (papasManager.event().hasCollection(IdCoder::type(name[0]), name[1])) left.push_back(name);
+    std::map<Identifier, double> energies;
+    for (const auto& p : papasManager.event().particles('r'))
+      energies[p.first] = p.second.e();
+    return energies;
+  };
+  std::vector<std::string> leftAll, leftPruned;
+  auto all = reconstruct(PapasManager::Retention::kKeepAll, leftAll);
+  auto pruned = reconstruct(PapasManager::Retention::kPruned, leftPruned);
+  REQUIRE(all.size() > 0);
+  REQUIRE(pruned == all);
+  REQUIRE(leftAll.size() == 12);
+  REQUIRE(leftPruned == std::vector<std::string>({"ps", "pr"}));
+}
+
+TEST_CASE("MergeAndBuildBlocks") {
+  // everything made from the merged clusters onwards, written out in full
+  auto describe = [](bool fused) {
+    rootrandom::Random::seed(0xc0de);
+    CMS cms;
+    PapasManager papasManager(cms);
+    ParticleGun gun(cms, 11);
+    auto& particles = papasManager.createParticles();
+    gun.makeParticles(100, particles, 2);
+    papasManager.addParticles(particles);
+    papasManager.simulate();
+    if (fused)
+      papasManager.mergeAndBuildBlocks();
+    else {
+      papasManager.mergeClusters("es");
+      papasManager.mergeClusters("hs");
+      papasManager.buildBlocks();
+    }
+    papasManager.simplifyBlocks('r');
+    papasManager.reconstruct('s');
+    const auto& event = papasManager.event();
+    std::ostringstream out;
+    out.precision(17);
+    for (auto name : {"em", "hm"})
+      for (auto id : event.collectionIds(std::string(name)))
+        out << id << " " << event.cluster(id).energy() << " " << event.cluster(id).position().X() << "\n";
+    for (auto subtype : {'r', 's'}) {
+      for (auto id : event.collectionIds(IdCoder::kBlock, subtype)) {
+        const auto& block = event.block(id);
+        out << id << ":";
+        for (auto elementId : block.elementIds())
+          for (auto key : block.linkedEdgeKeys(elementId))
+            out << " " << Edge::keyEnd(key, 0) << "-" << Edge::keyEnd(key, 1);
+        for (const auto& edge : block.edges())
+          out << " " << Edge::keyEnd(edge.first, 0) << "-" << Edge::keyEnd(edge.first, 1) << edge.second.isLinked()
+              << edge.second.distance();
+        out << "\n";
+      }
+    }
+    for (const auto& node : event.history()) {
+      std::set<Identifier> children;  // the children are kept in an unordered set of pointers
+      for (const auto* child : node.second.children())
+        children.insert(child->value());
+      out << node.first << ":";
+      for (auto child : children)
+        out << " " << child;
+      out << "\n";
+    }
+    for (const auto& p : event.particles('r'))
+      out << p.first << " " << p.second.e() << "\n";
+    return out.str();
+  };
+  auto separate = describe(false);
+  auto fused = describe(true);
+  REQUIRE(separate.size() > 1000);
+  REQUIRE(fused == separate);
+}
+
+TEST_CASE("ImportClustersAndTracks") {
+  // clusters and tracks made outside PAPAS (here copied from a simulated event) can be reconstructed directly
+  rootrandom::Random::seed(0xfeed);
+  CMS cms;
+  PapasManager simulated(cms);
+  ParticleGun gun(cms, 5);
+  auto& particles = simulated.createParticles();
+  gun.makeParticles(100, particles, 2);
+  simulated.addParticles(particles);
+  simulated.simulate();
+
+  PapasManager imported(cms);
+  imported.setRetention(PapasManager::Retention::kPruned);
+  for (auto name : {"es", "hs"}) {
+    auto& clusters = imported.createClusters();
+    for (const auto& c : simulated.event().clusters(name)) {
+      Cluster cluster(c.second.energy(), c.second.position(), c.second.size(), clusters.size(), IdCoder::type(name[0]),
+                      's');
+      clusters.emplace(cluster.id(), std::move(cluster));
+    }
+    imported.addClusters(clusters);
+  }
+  auto& tracks = imported.createTracks();
+  double charge = 0;
+  for (const auto& t : simulated.event().tracks('s')) {
+    const auto& track = t.second;
+    auto path = imported.makeTrackPath(track.p3(), track.charge(), TVector3(0, 0, 0));
+    REQUIRE(path->hasNamedPoint(papas::Position::kEcalIn) == track.path()->hasNamedPoint(papas::Position::kEcalIn));
+    Track copy(track.p3(), track.charge(), path, tracks.size(), 's');
+    tracks.emplace(copy.id(), std::move(copy));
+    charge += track.charge();
+  }
+  imported.addTracks(tracks);
+  imported.mergeClusters("es");
+  imported.mergeClusters("hs");
+  imported.buildBlocks();
+  imported.simplifyBlocks('r');
+  imported.reconstruct('s');
+
+  // every track gives a charged particle, and only the reconstructed particles are left
+  const auto& event = imported.event();
+  REQUIRE(event.particles('r').size() > tracks.size());
+  double recCharge = 0;
+  for (const auto& p : event.particles('r'))
+    recCharge += p.second.charge();
+  REQUIRE(recCharge == Approx(charge));
+  REQUIRE(!event.hasCollection(IdCoder::kTrack, 's'));
+  REQUIRE(!event.hasCollection(IdCoder::kEcalCluster, 'm'));
 }
 
 TEST_CASE("merge_inside") {